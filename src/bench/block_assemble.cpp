@@ -47,18 +47,30 @@ static void AssembleBlock(benchmark::Bench& bench)
         PrepareBlock(test_setup->m_node, P2WSH_OP_TRUE);
     });
 }
-static void BlockAssemblerAddPackageTxns(benchmark::Bench& bench)
+static void BlockAssemblerSelection(benchmark::Bench& bench, bool use_cluster_chunks)
 {
     FastRandomContext det_rand{true};
     auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
     testing_setup->PopulateMempool(det_rand, /*num_transactions=*/1000, /*submit=*/true);
     node::BlockAssembler::Options assembler_options;
     assembler_options.test_block_validity = false;
+    assembler_options.use_cluster_chunks = use_cluster_chunks;
 
     bench.run([&] {
         PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE, assembler_options);
     });
 }
 
+static void BlockAssemblerAddPackageTxns(benchmark::Bench& bench)
+{
+    BlockAssemblerSelection(bench, /*use_cluster_chunks=*/false);
+}
+
+static void BlockAssemblerAddChunks(benchmark::Bench& bench)
+{
+    BlockAssemblerSelection(bench, /*use_cluster_chunks=*/true);
+}
+
 BENCHMARK(AssembleBlock, benchmark::PriorityLevel::HIGH);
 BENCHMARK(BlockAssemblerAddPackageTxns, benchmark::PriorityLevel::LOW);
+BENCHMARK(BlockAssemblerAddChunks, benchmark::PriorityLevel::LOW);
@@ -5,8 +5,10 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
+#include <util/densemap.h>
 
 #include <vector>
 
@@ -51,3 +53,104 @@ static void CCoinsCaching(benchmark::Bench& bench)
 }
 
 BENCHMARK(CCoinsCaching, benchmark::PriorityLevel::HIGH);
+
+using DenseCoinsMap = DenseHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
+
+//! Number of entries in the coins maps of the benchmarks below.
+static constexpr size_t COINS_MAP_ENTRIES{200000};
+
+template <typename Map>
+static std::vector<COutPoint> FillCoinsMap(Map& map)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(COINS_MAP_ENTRIES);
+    for (size_t i = 0; i < COINS_MAP_ENTRIES; ++i) {
+        outpoints.emplace_back(rng.rand256(), rng.randrange(4));
+        Coin coin;
+        coin.out.nValue = rng.randrange(MAX_MONEY);
+        coin.nHeight = rng.randrange(1000000);
+        map.try_emplace(outpoints.back(), std::move(coin), CCoinsCacheEntry::DIRTY);
+    }
+    return outpoints;
+}
+
+static void CCoinsMapLookup(benchmark::Bench& bench)
+{
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+    const auto outpoints{FillCoinsMap(map)};
+    size_t i{0};
+    bench.run([&] {
+        const auto it{map.find(outpoints[i])};
+        assert(it != map.end());
+        i = (i + 7919) % outpoints.size();
+    });
+}
+
+static void DenseCoinsMapLookup(benchmark::Bench& bench)
+{
+    DenseCoinsMap map;
+    const auto outpoints{FillCoinsMap(map)};
+    size_t i{0};
+    bench.run([&] {
+        const auto it{map.find(outpoints[i])};
+        assert(it != map.end());
+        i = (i + 7919) % outpoints.size();
+    });
+}
+
+// Iteration over all dirty entries is what a cache flush does before writing.
+static void CCoinsMapIterate(benchmark::Bench& bench)
+{
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+    FillCoinsMap(map);
+    bench.batch(map.size()).unit("entry").run([&] {
+        CAmount total{0};
+        for (const auto& [_, entry] : map) {
+            if (entry.flags & CCoinsCacheEntry::DIRTY) total += entry.coin.out.nValue;
+        }
+        ankerl::nanobench::doNotOptimizeAway(total);
+    });
+}
+
+static void DenseCoinsMapIterate(benchmark::Bench& bench)
+{
+    DenseCoinsMap map;
+    FillCoinsMap(map);
+    bench.batch(map.size()).unit("entry").run([&] {
+        CAmount total{0};
+        for (const auto& [_, entry] : map) {
+            if (entry.flags & CCoinsCacheEntry::DIRTY) total += entry.coin.out.nValue;
+        }
+        ankerl::nanobench::doNotOptimizeAway(total);
+    });
+}
+
+// Fill a map, then drain it the way CCoinsViewCache::Flush() does.
+static void CCoinsMapFillAndDrain(benchmark::Bench& bench)
+{
+    bench.batch(COINS_MAP_ENTRIES).unit("entry").run([&] {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap map{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+        FillCoinsMap(map);
+        for (auto it = map.begin(); it != map.end();) it = map.erase(it);
+    });
+}
+
+static void DenseCoinsMapFillAndDrain(benchmark::Bench& bench)
+{
+    bench.batch(COINS_MAP_ENTRIES).unit("entry").run([&] {
+        DenseCoinsMap map;
+        FillCoinsMap(map);
+        for (auto it = map.begin(); it != map.end();) it = map.erase(it);
+    });
+}
+
+BENCHMARK(CCoinsMapLookup, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DenseCoinsMapLookup, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapIterate, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DenseCoinsMapIterate, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsMapFillAndDrain, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DenseCoinsMapFillAndDrain, benchmark::PriorityLevel::HIGH);
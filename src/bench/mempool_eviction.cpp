@@ -134,4 +134,41 @@ static void MempoolEviction(benchmark::Bench& bench)
     });
 }
 
+// Add a long chain of transactions (as a chain of packages relayed in a burst
+// would be), bump the fee of one in the middle, confirm the first one and
+// evict the rest. Every step walks the ancestors or descendants of each
+// transaction in the chain.
+static void MempoolLongChain(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    constexpr size_t CHAIN_LENGTH{500};
+
+    std::vector<CTransactionRef> chain;
+    chain.reserve(CHAIN_LENGTH);
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        if (i > 0) tx.vin[0].prevout = COutPoint(chain.back()->GetHash(), 0);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        chain.push_back(MakeTransactionRef(tx));
+    }
+
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const auto& tx : chain) {
+            AddTx(tx, 1000LL, pool);
+        }
+        pool.PrioritiseTransaction(chain[CHAIN_LENGTH / 2]->GetHash(), 1000);
+        pool.PrioritiseTransaction(chain[CHAIN_LENGTH / 2]->GetHash(), -1000);
+        pool.removeForBlock({chain.front()}, 1);
+        pool.TrimToSize(0);
+        assert(pool.size() == 0);
+    });
+}
+
 BENCHMARK(MempoolEviction, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolLongChain, benchmark::PriorityLevel::HIGH);
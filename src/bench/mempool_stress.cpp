@@ -103,6 +103,24 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+static void MempoolClusterLinearize(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, /*childTxs=*/800, /*min_ancestors=*/1);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+    for (auto& tx : ordered_coins) {
+        AddTx(tx, pool);
+    }
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        // Invalidate one cluster, so that each run relinearizes only what changed.
+        const auto& tx{ordered_coins[det_rand.randrange(ordered_coins.size())]};
+        pool.PrioritiseTransaction(tx->GetHash(), det_rand.randrange(1000));
+        ankerl::nanobench::doNotOptimizeAway(pool.GetClusterChunks().size());
+    });
+}
+
 static void MempoolCheck(benchmark::Bench& bench)
 {
     FastRandomContext det_rand{true};
@@ -119,4 +137,5 @@ static void MempoolCheck(benchmark::Bench& bench)
 }
 
 BENCHMARK(ComplexMemPool, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolClusterLinearize, benchmark::PriorityLevel::HIGH);
 BENCHMARK(MempoolCheck, benchmark::PriorityLevel::HIGH);
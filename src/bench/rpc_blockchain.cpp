@@ -6,6 +6,7 @@
 #include <bench/data.h>
 
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
 #include <util/chaintype.h>
@@ -13,6 +14,8 @@
 
 #include <univalue.h>
 
+#include <string_view>
+
 namespace {
 
 struct TestBlockAndIndex {
@@ -59,3 +62,17 @@ static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
 }
 
 BENCHMARK(BlockToJsonVerboseWrite, benchmark::PriorityLevel::HIGH);
+
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    bench.run([&] {
+        size_t total{0};
+        JSONStreamWriter writer{[&](std::string_view chunk) { total += chunk.size(); }};
+        blockToJSON(data.testing_setup->m_node.chainman->m_blockman, data.block, &data.blockindex, &data.blockindex, TxVerbosity::SHOW_DETAILS_AND_PREVOUT, writer);
+        writer.Flush();
+        ankerl::nanobench::doNotOptimizeAway(total);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseStream, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <univalue.h>
+
+#include <cassert>
+#include <string>
+
+//! Number of requests in the JSON-RPC batch of the benchmarks below.
+static constexpr int BATCH_SIZE{2000};
+
+static std::string MakeBatchRequest()
+{
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        UniValue params(UniValue::VARR);
+        params.push_back("00000000000000000001ba5c5d0e2bd2c2b1b5f5f7d8a6c3d2b1a0f9e8d7c6b" + std::to_string(i % 10));
+        params.push_back(2);
+        UniValue request(UniValue::VOBJ);
+        request.pushKV("jsonrpc", "1.0");
+        request.pushKV("id", i);
+        request.pushKV("method", "getblock");
+        request.pushKV("params", std::move(params));
+        batch.push_back(std::move(request));
+    }
+    return batch.write();
+}
+
+static UniValue MakeBatchReply()
+{
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        UniValue result(UniValue::VOBJ);
+        result.pushKV("txid", "8a1c3e5f7b9d2f4a6c8e0b2d4f6a8c0e2b4d6f8a0c2e4b6d8f0a2c4e6b8d0f2a");
+        result.pushKV("size", 225 + i);
+        result.pushKV("fee", 0.00012345);
+        result.pushKV("comment", "escaped \"quotes\" and\ttabs");
+        UniValue reply(UniValue::VOBJ);
+        reply.pushKV("result", std::move(result));
+        reply.pushKV("error", NullUniValue);
+        reply.pushKV("id", i);
+        batch.push_back(std::move(reply));
+    }
+    return batch;
+}
+
+static void JsonRpcBatchRead(benchmark::Bench& bench)
+{
+    const std::string json{MakeBatchRequest()};
+    bench.batch(BATCH_SIZE).unit("request").run([&] {
+        UniValue batch;
+        bool ok{batch.read(json)};
+        assert(ok);
+        ankerl::nanobench::doNotOptimizeAway(batch);
+    });
+}
+
+static void JsonRpcBatchWrite(benchmark::Bench& bench)
+{
+    const UniValue batch{MakeBatchReply()};
+    bench.batch(BATCH_SIZE).unit("reply").run([&] {
+        auto json{batch.write()};
+        ankerl::nanobench::doNotOptimizeAway(json);
+    });
+}
+
+static void JsonLargeObjectLookup(benchmark::Bench& bench)
+{
+    UniValue obj(UniValue::VOBJ);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        obj.pushKVEnd("key" + std::to_string(i), i);
+    }
+    int i{0};
+    bench.run([&] {
+        const UniValue& value{obj.find_value("key" + std::to_string(i))};
+        assert(value.isNum());
+        i = (i + 7919) % BATCH_SIZE;
+    });
+}
+
+BENCHMARK(JsonRpcBatchRead, benchmark::PriorityLevel::HIGH);
+BENCHMARK(JsonRpcBatchWrite, benchmark::PriorityLevel::HIGH);
+BENCHMARK(JsonLargeObjectLookup, benchmark::PriorityLevel::HIGH);
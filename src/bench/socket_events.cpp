@@ -0,0 +1,112 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat/compat.h>
+#include <random.h>
+#include <util/fs_helpers.h>
+#include <util/sock.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+// Compare the ways CConnman's socket handler can wait for network activity,
+// with many connected peers of which only a few are active at a time. The
+// peers are the remote ends of local socketpair(2)s; on each iteration a few
+// of them send a byte, and the local ends that became readable are found and
+// drained.
+#ifdef USE_EPOLL
+
+//! Number of peers that send something per iteration.
+static constexpr size_t ACTIVE_PEERS{8};
+
+namespace {
+struct Peers {
+    std::vector<std::shared_ptr<Sock>> local;
+    std::vector<std::unique_ptr<Sock>> remote;
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    explicit Peers(size_t num_peers)
+    {
+        const int fds_needed(2 * num_peers + 64);
+        const int fds_available{RaiseFileDescriptorLimit(fds_needed)};
+        assert(fds_available >= fds_needed);
+        for (size_t i = 0; i < num_peers; ++i) {
+            int s[2];
+            const int res{socketpair(AF_UNIX, SOCK_STREAM, 0, s)};
+            assert(res == 0);
+            local.push_back(std::make_shared<Sock>(s[0]));
+            remote.push_back(std::make_unique<Sock>(s[1]));
+            const bool non_blocking{local.back()->SetNonBlocking()};
+            assert(non_blocking);
+        }
+    }
+
+    void SendSome()
+    {
+        for (size_t i = 0; i < ACTIVE_PEERS; ++i) {
+            const uint8_t byte{0};
+            const ssize_t sent{remote[rng.randrange(remote.size())]->Send(&byte, 1, MSG_NOSIGNAL)};
+            assert(sent == 1);
+        }
+    }
+
+    static void Drain(const Sock& sock)
+    {
+        uint8_t buf[64];
+        while (sock.Recv(buf, sizeof(buf), MSG_DONTWAIT) > 0) {}
+    }
+};
+} // namespace
+
+static void SocketEventsWaitMany(benchmark::Bench& bench, size_t num_peers)
+{
+    Peers peers{num_peers};
+    bench.unit("wakeup").run([&] {
+        peers.SendSome();
+        // Like CConnman::GenerateWaitSockets(), the set is rebuilt on every wakeup.
+        Sock::EventsPerSock events_per_sock;
+        for (const auto& sock : peers.local) {
+            events_per_sock.emplace(sock, Sock::Events{Sock::RECV});
+        }
+        const bool success{events_per_sock.begin()->first->WaitMany(0ms, events_per_sock)};
+        assert(success);
+        for (const auto& [sock, events] : events_per_sock) {
+            if (events.occurred & Sock::RECV) Peers::Drain(*sock);
+        }
+    });
+}
+
+static void SocketEventsEpoll(benchmark::Bench& bench, size_t num_peers)
+{
+    Peers peers{num_peers};
+    SockEpoll epoll;
+    assert(epoll.IsValid());
+    for (size_t i = 0; i < peers.local.size(); ++i) {
+        const bool added{epoll.Add(*peers.local[i], Sock::RECV, i, /*edge_triggered=*/true)};
+        assert(added);
+    }
+    std::vector<SockEpoll::Event> events;
+    bench.unit("wakeup").run([&] {
+        peers.SendSome();
+        const bool success{epoll.Wait(0ms, peers.local.size(), events)};
+        assert(success);
+        for (const auto& event : events) {
+            if (event.occurred & Sock::RECV) Peers::Drain(*peers.local[event.id]);
+        }
+    });
+}
+
+static void SocketEventsWaitMany125Peers(benchmark::Bench& bench) { SocketEventsWaitMany(bench, 125); }
+static void SocketEventsWaitMany1000Peers(benchmark::Bench& bench) { SocketEventsWaitMany(bench, 1000); }
+static void SocketEventsEpoll125Peers(benchmark::Bench& bench) { SocketEventsEpoll(bench, 125); }
+static void SocketEventsEpoll1000Peers(benchmark::Bench& bench) { SocketEventsEpoll(bench, 1000); }
+
+BENCHMARK(SocketEventsWaitMany125Peers, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SocketEventsWaitMany1000Peers, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SocketEventsEpoll125Peers, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SocketEventsEpoll1000Peers, benchmark::PriorityLevel::HIGH);
+
+#endif // USE_EPOLL
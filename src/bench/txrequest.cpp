@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <txrequest.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr int NUM_PEERS{500};
+constexpr int NUM_TXS{1000};
+//! Number of peers that announce each transaction
+constexpr int ANNOUNCERS_PER_TX{32};
+//! Transactions per inv message, as sent every few seconds by a peer
+constexpr size_t INV_SIZE{35};
+
+/** The inv messages each peer sends, with overlapping transactions. */
+std::vector<std::vector<std::vector<GenTxid>>> MakeInvs()
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<std::vector<GenTxid>> announced(NUM_PEERS);
+    for (int tx = 0; tx < NUM_TXS; ++tx) {
+        const GenTxid gtxid{GenTxid::Wtxid(rng.rand256())};
+        for (int i = 0; i < ANNOUNCERS_PER_TX; ++i) {
+            announced[rng.randrange(NUM_PEERS)].push_back(gtxid);
+        }
+    }
+    std::vector<std::vector<std::vector<GenTxid>>> invs(NUM_PEERS);
+    for (int peer = 0; peer < NUM_PEERS; ++peer) {
+        for (size_t i = 0; i < announced[peer].size(); i += INV_SIZE) {
+            const auto end{std::min(i + INV_SIZE, announced[peer].size())};
+            invs[peer].emplace_back(announced[peer].begin() + i, announced[peer].begin() + end);
+        }
+    }
+    return invs;
+}
+
+/** Peers send their invs in turn, then everything requestable is requested and received. */
+void TxRequestRelay(benchmark::Bench& bench, bool batched)
+{
+    const auto invs{MakeInvs()};
+    size_t max_invs{0};
+    for (const auto& peer_invs : invs) max_invs = std::max(max_invs, peer_invs.size());
+
+    bench.run([&] {
+        TxRequestTracker tracker{/*deterministic=*/true};
+        std::chrono::microseconds now{1h};
+        for (size_t round = 0; round < max_invs; ++round) {
+            for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+                if (round >= invs[peer].size()) continue;
+                const auto& inv{invs[peer][round]};
+                const bool preferred{peer % 8 == 0};
+                if (batched) {
+                    tracker.ReceivedInvs(peer, inv, preferred, now);
+                } else {
+                    for (const GenTxid& gtxid : inv) tracker.ReceivedInv(peer, gtxid, preferred, now);
+                }
+            }
+            now += 100ms;
+            for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+                for (const GenTxid& gtxid : tracker.GetRequestable(peer, now)) {
+                    tracker.RequestedTx(peer, gtxid.GetHash(), now + 60s);
+                    tracker.ForgetTxHash(gtxid.GetHash());
+                }
+            }
+        }
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) tracker.DisconnectedPeer(peer);
+        assert(tracker.Size() == 0);
+    });
+}
+} // namespace
+
+static void TxRequestReceivedInv(benchmark::Bench& bench) { TxRequestRelay(bench, /*batched=*/false); }
+static void TxRequestReceivedInvs(benchmark::Bench& bench) { TxRequestRelay(bench, /*batched=*/true); }
+
+BENCHMARK(TxRequestReceivedInv, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TxRequestReceivedInvs, benchmark::PriorityLevel::HIGH);
@@ -70,20 +70,23 @@ void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator
     m_key = CKey();
 }
 
-void BIP324Cipher::Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept
+void BIP324Cipher::Encrypt(Span<const std::byte> contents_prefix, Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept
 {
-    assert(output.size() == contents.size() + EXPANSION);
+    assert(contents_prefix.size() <= MAX_CONTENTS_PREFIX_LEN);
+    const size_t contents_len{contents_prefix.size() + contents.size()};
+    assert(output.size() == contents_len + EXPANSION);
 
     // Encrypt length.
     std::byte len[LENGTH_LEN];
-    len[0] = std::byte{(uint8_t)(contents.size() & 0xFF)};
-    len[1] = std::byte{(uint8_t)((contents.size() >> 8) & 0xFF)};
-    len[2] = std::byte{(uint8_t)((contents.size() >> 16) & 0xFF)};
+    len[0] = std::byte{(uint8_t)(contents_len & 0xFF)};
+    len[1] = std::byte{(uint8_t)((contents_len >> 8) & 0xFF)};
+    len[2] = std::byte{(uint8_t)((contents_len >> 16) & 0xFF)};
     m_send_l_cipher->Crypt(len, output.first(LENGTH_LEN));
 
-    // Encrypt plaintext.
-    std::byte header[HEADER_LEN] = {ignore ? IGNORE_BIT : std::byte{0}};
-    m_send_p_cipher->Encrypt(header, contents, aad, output.subspan(LENGTH_LEN));
+    // Encrypt plaintext: the header and the contents prefix, followed by the rest of the contents.
+    std::byte header[HEADER_LEN + MAX_CONTENTS_PREFIX_LEN] = {ignore ? IGNORE_BIT : std::byte{0}};
+    std::copy(contents_prefix.begin(), contents_prefix.end(), header + HEADER_LEN);
+    m_send_p_cipher->Encrypt(Span{header}.first(HEADER_LEN + contents_prefix.size()), contents, aad, output.subspan(LENGTH_LEN));
 }
 
 uint32_t BIP324Cipher::DecryptLength(Span<const std::byte> input) noexcept
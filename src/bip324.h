@@ -26,6 +26,8 @@ public:
     static constexpr unsigned HEADER_LEN{1};
     static constexpr unsigned EXPANSION = LENGTH_LEN + HEADER_LEN + FSChaCha20Poly1305::EXPANSION;
     static constexpr std::byte IGNORE_BIT{0x80};
+    /** Maximum size of the contents_prefix that Encrypt() accepts (enough for an encoded message type). */
+    static constexpr unsigned MAX_CONTENTS_PREFIX_LEN{15};
 
 private:
     std::optional<FSChaCha20> m_send_l_cipher;
@@ -68,7 +70,18 @@ public:
      *
      * It must hold that output.size() == contents.size() + EXPANSION.
      */
-    void Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept;
+    void Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept
+    {
+        Encrypt({}, contents, aad, ignore, output);
+    }
+
+    /** Encrypt a packet whose contents are contents_prefix followed by contents, without
+     *  concatenating them first. Only after Initialize().
+     *
+     * It must hold that contents_prefix.size() <= MAX_CONTENTS_PREFIX_LEN, and
+     * output.size() == contents_prefix.size() + contents.size() + EXPANSION.
+     */
+    void Encrypt(Span<const std::byte> contents_prefix, Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept;
 
     /** Decrypt the length of a packet. Only after Initialize().
      *
@@ -16,6 +16,16 @@ std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) { return false; }
 std::unique_ptr<CCoinsViewCursor> CCoinsView::Cursor() const { return nullptr; }
 
+std::vector<std::optional<Coin>> CCoinsView::GetCoins(Span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        Coin coin;
+        if (GetCoin(outpoints[i], coin)) coins[i] = std::move(coin);
+    }
+    return coins;
+}
+
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 {
     Coin coin;
@@ -24,6 +34,7 @@ bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 
 CCoinsViewBacked::CCoinsViewBacked(CCoinsView *viewIn) : base(viewIn) { }
 bool CCoinsViewBacked::GetCoin(const COutPoint &outpoint, Coin &coin) const { return base->GetCoin(outpoint, coin); }
+std::vector<std::optional<Coin>> CCoinsViewBacked::GetCoins(Span<const COutPoint> outpoints) const { return base->GetCoins(outpoints); }
 bool CCoinsViewBacked::HaveCoin(const COutPoint &outpoint) const { return base->HaveCoin(outpoint); }
 uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 std::vector<uint256> CCoinsViewBacked::GetHeadBlocks() const { return base->GetHeadBlocks(); }
@@ -67,6 +78,33 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
 
+std::vector<std::optional<Coin>> CCoinsViewCache::GetCoins(Span<const COutPoint> outpoints) const
+{
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<COutPoint> missing;
+    std::vector<size_t> missing_pos;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoints[i]);
+        if (it == cacheCoins.end()) {
+            missing.push_back(outpoints[i]);
+            missing_pos.push_back(i);
+        } else if (!it->second.coin.IsSpent()) {
+            coins[i] = it->second.coin;
+        }
+    }
+    if (missing.empty()) return coins;
+
+    std::vector<std::optional<Coin>> fetched{base->GetCoins(missing)};
+    for (size_t j = 0; j < missing.size(); ++j) {
+        if (!fetched[j]) continue;
+        coins[missing_pos[j]] = *fetched[j];
+        // The same outpoint may have been requested more than once.
+        auto [it, inserted] = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(missing[j]), std::forward_as_tuple(std::move(*fetched[j])));
+        if (inserted) cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+    return coins;
+}
+
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possible_overwrite) {
     assert(!coin.IsSpent());
     if (coin.out.scriptPubKey.IsUnspendable()) return;
@@ -282,6 +320,25 @@ bool CCoinsViewCache::Sync()
     return fOk;
 }
 
+CCoinsFlushBatch CCoinsViewCache::TakeFlushBatch()
+{
+    CCoinsFlushBatch batch;
+    batch.hashBlock = hashBlock;
+    batch.coins.reserve(cacheCoins.size());
+    for (auto& [outpoint, entry] : cacheCoins) {
+        if (!(entry.flags & CCoinsCacheEntry::DIRTY)) continue;
+        // A FRESH coin that was spent never reached the base view, so there
+        // is nothing to delete there.
+        if ((entry.flags & CCoinsCacheEntry::FRESH) && entry.coin.IsSpent()) continue;
+        batch.coins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint),
+                            std::forward_as_tuple(std::move(entry.coin), CCoinsCacheEntry::DIRTY));
+    }
+    cacheCoins.clear();
+    ReallocateCache();
+    cachedCoinsUsage = 0;
+    return batch;
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -367,7 +424,7 @@ const Coin& AccessByTxid(const CCoinsViewCache& view, const uint256& txid)
 }
 
 template <typename Func>
-static bool ExecuteBackedWrapper(Func func, const std::vector<std::function<void()>>& err_callbacks)
+static auto ExecuteBackedWrapper(Func func, const std::vector<std::function<void()>>& err_callbacks)
 {
     try {
         return func();
@@ -388,6 +445,10 @@ bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint, Coin &coin) cons
     return ExecuteBackedWrapper([&]() { return CCoinsViewBacked::GetCoin(outpoint, coin); }, m_err_callbacks);
 }
 
+std::vector<std::optional<Coin>> CCoinsViewErrorCatcher::GetCoins(Span<const COutPoint> outpoints) const {
+    return ExecuteBackedWrapper([&]() { return CCoinsViewBacked::GetCoins(outpoints); }, m_err_callbacks);
+}
+
 bool CCoinsViewErrorCatcher::HaveCoin(const COutPoint &outpoint) const {
     return ExecuteBackedWrapper([&]() { return CCoinsViewBacked::HaveCoin(outpoint); }, m_err_callbacks);
 }
@@ -12,6 +12,7 @@
 #include <memusage.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
+#include <span.h>
 #include <support/allocators/pool.h>
 #include <uint256.h>
 #include <util/hasher.h>
@@ -20,7 +21,9 @@
 #include <stdint.h>
 
 #include <functional>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -158,6 +161,19 @@ using CCoinsMap = std::unordered_map<COutPoint,
 
 using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
 
+/**
+ * The modifications of a CCoinsViewCache, detached from the cache by
+ * CCoinsViewCache::TakeFlushBatch() so they can be written to the database
+ * without holding cs_main. Entries are all DIRTY; spent coins are deletions.
+ * Unlike CCoinsMap, the entries do not live in the cache's memory resource,
+ * so the batch may be read from and destroyed on another thread.
+ */
+struct CCoinsFlushBatch {
+    //! Block hash whose state the batch represents
+    uint256 hashBlock;
+    std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> coins;
+};
+
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
 {
@@ -188,6 +204,13 @@ public:
      */
     virtual bool GetCoin(const COutPoint &outpoint, Coin &coin) const;
 
+    /** Retrieve the Coins for many outpoints at once.
+     *  Returns one entry per outpoint, in the same order as the input; an entry is
+     *  std::nullopt when no unspent coin was found for that outpoint.
+     *  The default implementation calls GetCoin() for every outpoint.
+     */
+    virtual std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const;
+
     //! Just check whether a given outpoint is unspent.
     virtual bool HaveCoin(const COutPoint &outpoint) const;
 
@@ -224,6 +247,7 @@ protected:
 public:
     CCoinsViewBacked(CCoinsView *viewIn);
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
@@ -262,6 +286,9 @@ public:
 
     // Standard CCoinsView methods
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    /** Outpoints not yet in the cache are fetched from the backing view with a
+     *  single batched GetCoins() call and added to the cache. */
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     void SetBestBlock(const uint256 &hashBlock);
@@ -328,6 +355,15 @@ public:
      */
     bool Sync();
 
+    /**
+     * Move the modifications applied to this cache into a CCoinsFlushBatch and
+     * wipe local state, as Flush() does, but without writing to the base view.
+     * The caller becomes responsible for writing the batch (see
+     * CCoinsViewDB::BatchWriteInBackground()); until then the base view does
+     * not reflect the changes made in this cache.
+     */
+    CCoinsFlushBatch TakeFlushBatch();
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
@@ -402,6 +438,7 @@ public:
     }
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
 
 private:
@@ -10,9 +10,25 @@
 #include <support/cleanse.h>
 #include <span.h>
 
+#include <compat/cpuid.h>
+
 #include <algorithm>
 #include <string.h>
 
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+namespace chacha20_sse2
+{
+void Crypt_4way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks);
+}
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace chacha20_avx2
+{
+void Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks);
+}
+#endif
+
 constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
 
 #define QUARTERROUND(a,b,c,d) \
@@ -23,6 +39,63 @@ constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (
 
 #define REPEAT10(a) do { {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; } while(0)
 
+namespace {
+
+/** Multi-block implementation: en/deciphers (or, with a null in, outputs the keystream for) a
+ *  multiple of width blocks starting at the block counter in input[8..9], which it leaves as is. */
+using CryptMultiFn = void (*)(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks);
+
+struct MultiBlockImpl {
+    CryptMultiFn fn{nullptr};
+    size_t width{0};
+};
+
+/** The vector implementations usable on this CPU, widest first. */
+struct MultiBlockImpls {
+    MultiBlockImpl impls[2];
+
+    MultiBlockImpls()
+    {
+        [[maybe_unused]] size_t n{0};
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL) && defined(HAVE_GETCPUID)
+        uint32_t eax, ebx, ecx, edx;
+        GetCPUID(1, 0, eax, ebx, ecx, edx);
+        const bool have_xsave{((ecx >> 27) & 1) != 0};
+        const bool have_avx{((ecx >> 28) & 1) != 0};
+        if (have_xsave && have_avx && AVXEnabled()) {
+            GetCPUID(7, 0, eax, ebx, ecx, edx);
+            if ((ebx >> 5) & 1) impls[n++] = {chacha20_avx2::Crypt_8way, 8};
+        }
+#endif
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__))
+        impls[n++] = {chacha20_sse2::Crypt_4way, 4};
+#endif
+    }
+};
+
+/** Run as many leading blocks as possible through the vector implementations, and advance the
+ *  block counter past them. Returns the number of blocks processed. */
+size_t CryptMultiBlock(uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks) noexcept
+{
+    // Short requests (such as the 3-byte length of each BIP324 packet) always take the scalar path.
+    if (blocks < 4) return 0;
+    static const MultiBlockImpls g_impls;
+    size_t done{0};
+    for (const auto& impl : g_impls.impls) {
+        if (!impl.fn) break;
+        const size_t todo{(blocks - done) / impl.width * impl.width};
+        if (!todo) continue;
+        impl.fn(input, in ? in + done * ChaCha20Aligned::BLOCKLEN : nullptr, out + done * ChaCha20Aligned::BLOCKLEN, todo);
+        const uint64_t counter{(input[8] | (uint64_t{input[9]} << 32)) + todo};
+        input[8] = uint32_t(counter);
+        input[9] = uint32_t(counter >> 32);
+        done += todo;
+    }
+    return done;
+}
+
+} // namespace
+
 void ChaCha20Aligned::SetKey(Span<const std::byte> key) noexcept
 {
     assert(key.size() == KEYLEN);
@@ -64,6 +137,10 @@ inline void ChaCha20Aligned::Keystream(Span<std::byte> output) noexcept
     size_t blocks = output.size() / BLOCKLEN;
     assert(blocks * BLOCKLEN == output.size());
 
+    const size_t vectorized{CryptMultiBlock(input, nullptr, c, blocks)};
+    c += vectorized * BLOCKLEN;
+    blocks -= vectorized;
+
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
@@ -167,6 +244,11 @@ inline void ChaCha20Aligned::Crypt(Span<const std::byte> in_bytes, Span<std::byt
     size_t blocks = out_bytes.size() / BLOCKLEN;
     assert(blocks * BLOCKLEN == out_bytes.size());
 
+    const size_t vectorized{CryptMultiBlock(input, m, c, blocks)};
+    m += vectorized * BLOCKLEN;
+    c += vectorized * BLOCKLEN;
+    blocks -= vectorized;
+
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
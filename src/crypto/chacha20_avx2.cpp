@@ -0,0 +1,115 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template <int n>
+__m256i inline Rotl(__m256i x) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+template <>
+__m256i inline Rotl<16>(__m256i x)
+{
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                                  13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+}
+template <>
+__m256i inline Rotl<8>(__m256i x)
+{
+    return _mm256_shuffle_epi8(x, _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                                  14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+}
+
+void inline QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = Rotl<16>(Xor(d, a));
+    c = Add(c, d); b = Rotl<12>(Xor(b, c));
+    a = Add(a, b); d = Rotl<8>(Xor(d, a));
+    c = Add(c, d); b = Rotl<7>(Xor(b, c));
+}
+
+/** Transpose the 4 words w[0..3] within each 128-bit half: r[i] holds them for lane i (low) and lane i + 4 (high). */
+void inline Transpose4(const __m256i w[4], __m256i r[4])
+{
+    const __m256i t0 = _mm256_unpacklo_epi32(w[0], w[1]);
+    const __m256i t1 = _mm256_unpacklo_epi32(w[2], w[3]);
+    const __m256i t2 = _mm256_unpackhi_epi32(w[0], w[1]);
+    const __m256i t3 = _mm256_unpackhi_epi32(w[2], w[3]);
+    r[0] = _mm256_unpacklo_epi64(t0, t1);
+    r[1] = _mm256_unpackhi_epi64(t0, t1);
+    r[2] = _mm256_unpacklo_epi64(t2, t3);
+    r[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+void inline Store(__m256i v, const unsigned char* in, unsigned char* out)
+{
+    if (in) v = Xor(v, _mm256_loadu_si256((const __m256i*)in));
+    _mm256_storeu_si256((__m256i*)out, v);
+}
+
+} // namespace
+
+void Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    __m256i j[16];
+    j[0] = _mm256_set1_epi32(0x61707865);
+    j[1] = _mm256_set1_epi32(0x3320646e);
+    j[2] = _mm256_set1_epi32(0x79622d32);
+    j[3] = _mm256_set1_epi32(0x6b206574);
+    for (int i = 0; i < 8; ++i) j[4 + i] = _mm256_set1_epi32(input[i]);
+    j[14] = _mm256_set1_epi32(input[10]);
+    j[15] = _mm256_set1_epi32(input[11]);
+    uint64_t counter = input[8] | (uint64_t{input[9]} << 32);
+
+    for (; blocks >= 8; blocks -= 8) {
+        // Each lane runs its own block; the 64-bit block counter carries into word 13.
+        uint32_t lo[8], hi[8];
+        for (int i = 0; i < 8; ++i) {
+            lo[i] = uint32_t(counter + i);
+            hi[i] = uint32_t((counter + i) >> 32);
+        }
+        j[12] = _mm256_loadu_si256((const __m256i*)lo);
+        j[13] = _mm256_loadu_si256((const __m256i*)hi);
+        counter += 8;
+
+        __m256i x[16];
+        for (int i = 0; i < 16; ++i) x[i] = j[i];
+        for (int i = 0; i < 10; ++i) {
+            QuarterRound(x[0], x[4], x[8], x[12]);
+            QuarterRound(x[1], x[5], x[9], x[13]);
+            QuarterRound(x[2], x[6], x[10], x[14]);
+            QuarterRound(x[3], x[7], x[11], x[15]);
+            QuarterRound(x[0], x[5], x[10], x[15]);
+            QuarterRound(x[1], x[6], x[11], x[12]);
+            QuarterRound(x[2], x[7], x[8], x[13]);
+            QuarterRound(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+        __m256i r[4][4];
+        for (int g = 0; g < 4; ++g) Transpose4(x + 4 * g, r[g]);
+        // Words 0..7 of a block come from groups 0 and 1, words 8..15 from groups 2 and 3.
+        for (int i = 0; i < 4; ++i) {
+            const size_t lo_off{size_t(64) * i}, hi_off{size_t(64) * (i + 4)};
+            Store(_mm256_permute2x128_si256(r[0][i], r[1][i], 0x20), in ? in + lo_off : nullptr, out + lo_off);
+            Store(_mm256_permute2x128_si256(r[2][i], r[3][i], 0x20), in ? in + lo_off + 32 : nullptr, out + lo_off + 32);
+            Store(_mm256_permute2x128_si256(r[0][i], r[1][i], 0x31), in ? in + hi_off : nullptr, out + hi_off);
+            Store(_mm256_permute2x128_si256(r[2][i], r[3][i], 0x31), in ? in + hi_off + 32 : nullptr, out + hi_off + 32);
+        }
+        if (in) in += 512;
+        out += 512;
+    }
+}
+
+} // namespace chacha20_avx2
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// 4-way ChaCha20 using SSE2, which is part of the x86_64 baseline.
+
+#if defined(__x86_64__) || defined(__amd64__)
+
+#include <emmintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace chacha20_sse2 {
+namespace {
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+template <int n>
+__m128i inline Rotl(__m128i x) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+template <>
+__m128i inline Rotl<16>(__m128i x) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1); }
+
+void inline QuarterRound(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    a = Add(a, b); d = Rotl<16>(Xor(d, a));
+    c = Add(c, d); b = Rotl<12>(Xor(b, c));
+    a = Add(a, b); d = Rotl<8>(Xor(d, a));
+    c = Add(c, d); b = Rotl<7>(Xor(b, c));
+}
+
+/** Transpose the 4 words w[0..3] of 4 lanes, and write lane i (xored with in, if any) to out + 64 * i. */
+void inline Write4(const __m128i w[4], const unsigned char* in, unsigned char* out)
+{
+    const __m128i t0 = _mm_unpacklo_epi32(w[0], w[1]);
+    const __m128i t1 = _mm_unpacklo_epi32(w[2], w[3]);
+    const __m128i t2 = _mm_unpackhi_epi32(w[0], w[1]);
+    const __m128i t3 = _mm_unpackhi_epi32(w[2], w[3]);
+    __m128i r[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+    for (int i = 0; i < 4; ++i) {
+        if (in) r[i] = Xor(r[i], _mm_loadu_si128((const __m128i*)(in + 64 * i)));
+        _mm_storeu_si128((__m128i*)(out + 64 * i), r[i]);
+    }
+}
+
+} // namespace
+
+void Crypt_4way(const uint32_t* input, const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    __m128i j[16];
+    j[0] = _mm_set1_epi32(0x61707865);
+    j[1] = _mm_set1_epi32(0x3320646e);
+    j[2] = _mm_set1_epi32(0x79622d32);
+    j[3] = _mm_set1_epi32(0x6b206574);
+    for (int i = 0; i < 8; ++i) j[4 + i] = _mm_set1_epi32(input[i]);
+    j[14] = _mm_set1_epi32(input[10]);
+    j[15] = _mm_set1_epi32(input[11]);
+    uint64_t counter = input[8] | (uint64_t{input[9]} << 32);
+
+    for (; blocks >= 4; blocks -= 4) {
+        // Each lane runs its own block; the 64-bit block counter carries into word 13.
+        const uint64_t c0{counter}, c1{counter + 1}, c2{counter + 2}, c3{counter + 3};
+        j[12] = _mm_set_epi32(uint32_t(c3), uint32_t(c2), uint32_t(c1), uint32_t(c0));
+        j[13] = _mm_set_epi32(uint32_t(c3 >> 32), uint32_t(c2 >> 32), uint32_t(c1 >> 32), uint32_t(c0 >> 32));
+        counter += 4;
+
+        __m128i x[16];
+        for (int i = 0; i < 16; ++i) x[i] = j[i];
+        for (int i = 0; i < 10; ++i) {
+            QuarterRound(x[0], x[4], x[8], x[12]);
+            QuarterRound(x[1], x[5], x[9], x[13]);
+            QuarterRound(x[2], x[6], x[10], x[14]);
+            QuarterRound(x[3], x[7], x[11], x[15]);
+            QuarterRound(x[0], x[5], x[10], x[15]);
+            QuarterRound(x[1], x[6], x[11], x[12]);
+            QuarterRound(x[2], x[7], x[8], x[13]);
+            QuarterRound(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+        for (int i = 0; i < 16; i += 4) {
+            Write4(x + i, in ? in + 4 * i : nullptr, out + 4 * i);
+        }
+        if (in) in += 256;
+        out += 256;
+    }
+}
+
+} // namespace chacha20_sse2
+
+#endif // defined(__x86_64__) || defined(__amd64__)
@@ -18,7 +18,9 @@
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <exception>
 #include <leveldb/cache.h>
+#include <leveldb/comparator.h>
 #include <leveldb/db.h>
 #include <leveldb/env.h>
 #include <leveldb/filter_policy.h>
@@ -30,6 +32,7 @@
 #include <leveldb/write_batch.h>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <utility>
 
 static auto CharCast(const std::byte* data) { return reinterpret_cast<const char*>(data); }
@@ -219,7 +222,7 @@ struct LevelDBContext {
 };
 
 CDBWrapper::CDBWrapper(const DBParams& params)
-    : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
+    : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}, m_read_threads{std::max(1, params.options.read_threads)}
 {
     DBContext().penv = nullptr;
     DBContext().readoptions.verify_checksums = true;
@@ -349,6 +352,76 @@ std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
     return strValue;
 }
 
+std::vector<std::optional<std::string>> CDBWrapper::ReadManyImpl(const std::vector<Span<const std::byte>>& keys) const
+{
+    std::vector<std::optional<std::string>> values(keys.size());
+    if (keys.empty()) return values;
+
+    // Visit keys in database order so that consecutive lookups hit the same
+    // blocks and table files.
+    const leveldb::Comparator* cmp{DBContext().options.comparator};
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return cmp->Compare(leveldb::Slice(CharCast(keys[a].data()), keys[a].size()),
+                            leveldb::Slice(CharCast(keys[b].data()), keys[b].size())) < 0;
+    });
+
+    // Serve all lookups from one snapshot so the result is consistent even
+    // if a write batch lands while the reads are in progress.
+    leveldb::DB* pdb{DBContext().pdb};
+    const auto snapshot_deleter{[pdb](const leveldb::Snapshot* snap) { pdb->ReleaseSnapshot(snap); }};
+    std::unique_ptr<const leveldb::Snapshot, decltype(snapshot_deleter)> snapshot{pdb->GetSnapshot(), snapshot_deleter};
+    leveldb::ReadOptions readoptions{DBContext().readoptions};
+    readoptions.snapshot = snapshot.get();
+
+    const auto read_range{[&](size_t begin, size_t end) {
+        std::string strValue;
+        for (size_t i = begin; i < end; ++i) {
+            const Span<const std::byte> key{keys[order[i]]};
+            leveldb::Status status = pdb->Get(readoptions, leveldb::Slice(CharCast(key.data()), key.size()), &strValue);
+            if (!status.ok()) {
+                if (status.IsNotFound()) continue;
+                LogPrintf("LevelDB read failure: %s\n", status.ToString());
+                HandleError(status);
+            }
+            values[order[i]] = std::move(strValue);
+            strValue.clear();
+        }
+    }};
+
+    const size_t n_threads{std::min<size_t>(m_read_threads, keys.size() / DBWRAPPER_READMANY_MIN_KEYS_PER_THREAD)};
+    if (n_threads <= 1) {
+        read_range(0, keys.size());
+        return values;
+    }
+
+    // Hand each thread a contiguous range of the sorted keys; the calling
+    // thread takes the first one.
+    const size_t per_thread{(keys.size() + n_threads - 1) / n_threads};
+    std::vector<std::exception_ptr> errors(n_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    const auto run_range{[&](size_t t) {
+        try {
+            read_range(t * per_thread, std::min(keys.size(), (t + 1) * per_thread));
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    }};
+    for (size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back(run_range, t);
+    }
+    run_range(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return values;
+}
+
 bool CDBWrapper::ExistsImpl(Span<const std::byte> key) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
@@ -22,11 +22,17 @@
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
+//! Default for -dbreadthreads, the maximum number of threads used by a single ReadMany() call
+static const int DEFAULT_DB_READ_THREADS = 4;
+//! Minimum number of keys handed to each thread of a parallel ReadMany() call
+static const size_t DBWRAPPER_READMANY_MIN_KEYS_PER_THREAD = 64;
 
 //! User-controlled performance and debug options.
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Maximum number of threads a single ReadMany() call may fan out to.
+    int read_threads = DEFAULT_DB_READ_THREADS;
 };
 
 //! Application-specific storage settings.
@@ -205,7 +211,11 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
+    //! maximum number of threads used by ReadMany()
+    int m_read_threads;
+
     std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
+    std::vector<std::optional<std::string>> ReadManyImpl(const std::vector<Span<const std::byte>>& keys) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
     auto& DBContext() const LIFETIMEBOUND { return *Assert(m_db_context); }
@@ -237,6 +247,41 @@ public:
         return true;
     }
 
+    /**
+     * Look up many keys at once. All reads are served from a single consistent
+     * snapshot of the database. Keys are visited in sorted order, and large
+     * requests are split into contiguous key ranges that are read in parallel.
+     *
+     * @returns one entry per key, in the order of `keys`. Entries are
+     *          std::nullopt for keys that are missing or fail to deserialize.
+     */
+    template <typename V, typename K>
+    std::vector<std::optional<V>> ReadMany(Span<const K> keys) const
+    {
+        std::vector<DataStream> ssKeys(keys.size());
+        std::vector<Span<const std::byte>> key_spans;
+        key_spans.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ssKeys[i].reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+            ssKeys[i] << keys[i];
+            key_spans.emplace_back(ssKeys[i]);
+        }
+        std::vector<std::optional<std::string>> strValues{ReadManyImpl(key_spans)};
+        std::vector<std::optional<V>> values(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!strValues[i]) continue;
+            try {
+                DataStream ssValue{MakeByteSpan(*strValues[i])};
+                ssValue.Xor(obfuscate_key);
+                V value;
+                ssValue >> value;
+                values[i] = std::move(value);
+            } catch (const std::exception&) {
+            }
+        }
+        return values;
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
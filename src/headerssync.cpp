@@ -8,6 +8,11 @@
 #include <timedata.h>
 #include <util/check.h>
 #include <util/vector.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 // The two constants below are computed using the simulation script in
 // contrib/devtools/headerssync-params.py.
@@ -22,13 +27,21 @@ constexpr size_t REDOWNLOAD_BUFFER_SIZE{14441}; // 14441/606 = ~23.8 commitments
 // Our memory analysis assumes 48 bytes for a CompressedHeader (so we should
 // re-calculate parameters if we compress further)
 static_assert(sizeof(CompressedHeader) == 48);
+// Proof-of-stake headers also keep a CompressedStake, plus its signature of
+// about 72 bytes on the heap.
+static_assert(sizeof(CompressedStake) <= 64);
+
+//! Number of headers a signature checking thread takes at a time
+constexpr size_t SIGNATURE_CHECK_BATCH{64};
 
 HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-        const CBlockIndex* chain_start, const arith_uint256& minimum_required_work) :
+        const CBlockIndex* chain_start, const arith_uint256& minimum_required_work,
+        int signature_threads) :
     m_commit_offset(GetRand<unsigned>(HEADER_COMMITMENT_PERIOD)),
     m_id(id), m_consensus_params(consensus_params),
     m_chain_start(chain_start),
     m_minimum_required_work(minimum_required_work),
+    m_signature_threads(std::clamp(signature_threads, 0, MAX_HEADERS_SIGNATURE_THREADS)),
     m_current_chain_work(chain_start->nChainWork),
     m_last_header_received(m_chain_start->GetBlockHeader()),
     m_current_height(chain_start->nHeight)
@@ -55,6 +68,7 @@ void HeadersSyncState::Finalize()
     ClearShrink(m_header_commitments);
     m_last_header_received.SetNull();
     ClearShrink(m_redownloaded_headers);
+    ClearShrink(m_redownloaded_stakes);
     m_redownload_buffer_last_hash.SetNull();
     m_redownload_buffer_first_prev_hash.SetNull();
     m_process_all_remaining_headers = false;
@@ -101,14 +115,18 @@ HeadersSyncState::ProcessingResult HeadersSyncState::ProcessNextHeaders(const
         // receive, and add headers to our redownload buffer. When the buffer
         // gets big enough (meaning that we've checked enough commitments),
         // we'll return a batch of headers to the caller for processing.
-        ret.success = true;
-        for (const auto& hdr : received_headers) {
-            if (!ValidateAndStoreRedownloadedHeader(hdr)) {
-                // Something went wrong -- the peer gave us an unexpected chain.
-                // We could consider looking at the reason for failure and
-                // punishing the peer, but for now just give up on sync.
-                ret.success = false;
-                break;
+        // Block signatures are checked for the whole batch up front, so that
+        // the checks can be spread over several threads.
+        ret.success = CheckRedownloadedSignatures(received_headers);
+        if (ret.success) {
+            for (const auto& hdr : received_headers) {
+                if (!ValidateAndStoreRedownloadedHeader(hdr)) {
+                    // Something went wrong -- the peer gave us an unexpected chain.
+                    // We could consider looking at the reason for failure and
+                    // punishing the peer, but for now just give up on sync.
+                    ret.success = false;
+                    break;
+                }
             }
         }
 
@@ -165,6 +183,7 @@ bool HeadersSyncState::ValidateAndStoreHeadersCommitments(const std::vector<CBlo
 
     if (m_current_chain_work >= m_minimum_required_work) {
         m_redownloaded_headers.clear();
+        m_redownloaded_stakes.clear();
         m_redownload_buffer_last_height = m_chain_start->nHeight;
         m_redownload_buffer_first_prev_hash = m_chain_start->GetBlockHash();
         m_redownload_buffer_last_hash = m_chain_start->GetBlockHash();
@@ -213,6 +232,43 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
     return true;
 }
 
+bool HeadersSyncState::CheckRedownloadedSignatures(const std::vector<CBlockHeader>& headers) const
+{
+    const size_t num_pos{size_t(std::count_if(headers.begin(), headers.end(), [](const CBlockHeader& header) { return header.IsProofOfStake(); }))};
+    if (num_pos == 0) return true;
+
+    // Threads take batches of headers off the front until all are checked or
+    // one fails.
+    std::atomic<size_t> next{0};
+    std::atomic<bool> valid{true};
+    auto check = [&] {
+        while (valid) {
+            const size_t begin{next.fetch_add(SIGNATURE_CHECK_BATCH)};
+            if (begin >= headers.size()) return;
+            const size_t end{std::min(begin + SIGNATURE_CHECK_BATCH, headers.size())};
+            for (size_t i{begin}; i < end; ++i) {
+                if (!CheckHeaderSignature(headers[i])) {
+                    valid = false;
+                    return;
+                }
+            }
+        }
+    };
+
+    const size_t batches{(num_pos + SIGNATURE_CHECK_BATCH - 1) / SIGNATURE_CHECK_BATCH};
+    std::vector<std::thread> workers;
+    for (size_t i{1}; i < batches && workers.size() < size_t(m_signature_threads); ++i) {
+        workers.emplace_back(check);
+    }
+    check();
+    for (auto& worker : workers) worker.join();
+
+    if (!valid) {
+        LogPrint(BCLog::NET, "Initial headers sync aborted with peer=%d: invalid block signature after height=%i (redownload phase)\n", m_id, m_redownload_buffer_last_height);
+    }
+    return valid;
+}
+
 bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& header)
 {
     Assume(m_download_state == State::REDOWNLOAD);
@@ -272,6 +328,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
 
     // Store this header for later processing.
     m_redownloaded_headers.emplace_back(header);
+    if (header.IsProofOfStake()) m_redownloaded_stakes.emplace_back(header);
     m_redownload_buffer_last_height = next_height;
     m_redownload_buffer_last_hash = header.GetHash();
 
@@ -289,6 +346,10 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance()
             (m_redownloaded_headers.size() > 0 && m_process_all_remaining_headers)) {
         ret.emplace_back(m_redownloaded_headers.front().GetFullHeader(m_redownload_buffer_first_prev_hash));
         m_redownloaded_headers.pop_front();
+        if (ret.back().IsProofOfStake()) {
+            m_redownloaded_stakes.front().Apply(ret.back());
+            m_redownloaded_stakes.pop_front();
+        }
         m_redownload_buffer_first_prev_hash = ret.back().GetHash();
     }
     return ret;
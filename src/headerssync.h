@@ -15,6 +15,7 @@
 #include <util/hasher.h>
 
 #include <deque>
+#include <utility>
 #include <vector>
 
 // A compressed CBlockHeader, which leaves out the prevhash
@@ -52,6 +53,26 @@ struct CompressedHeader {
     };
 };
 
+// The proof-of-stake fields of a CBlockHeader, kept alongside the
+// CompressedHeader of proof-of-stake headers only
+struct CompressedStake {
+    COutPoint prevoutStake;
+    std::vector<unsigned char> vchBlockSig;
+
+    explicit CompressedStake(const CBlockHeader& header)
+        : prevoutStake{header.prevoutStake}, vchBlockSig{header.vchBlockSig} {}
+
+    void Apply(CBlockHeader& header)
+    {
+        header.prevoutStake = prevoutStake;
+        header.vchBlockSig = std::move(vchBlockSig);
+    }
+};
+
+//! Maximum number of threads (besides the calling one) that check the block
+//! signatures of a batch of redownloaded headers
+static constexpr int MAX_HEADERS_SIGNATURE_THREADS{8};
+
 /** HeadersSyncState:
  *
  * We wish to download a peer's headers chain in a DoS-resistant way.
@@ -96,6 +117,13 @@ struct CompressedHeader {
  * parametrization, we can achieve a given security target for potential
  * permanent memory usage, while choosing N to minimize memory use during the
  * sync (temporary, per-peer storage).
+ *
+ * Proof-of-stake headers can't be checked against their stake without the UTXO
+ * set, so that is left to block connection. The commitments are over the
+ * header hash, which covers prevoutStake and vchBlockSig, so a peer can't swap
+ * those between the two phases. In REDOWNLOAD, each batch of headers also has
+ * its block signatures checked (see CheckHeaderSignature()) on several threads
+ * before any of it is buffered.
  */
 
 class HeadersSyncState {
@@ -134,9 +162,12 @@ public:
      * consensus_params: parameters needed for difficulty adjustment validation
      * chain_start: best known fork point that the peer's headers branch from
      * minimum_required_work: amount of chain work required to accept the chain
+     * signature_threads: threads, besides the calling one, that check block
+     *                    signatures during REDOWNLOAD
      */
     HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-            const CBlockIndex* chain_start, const arith_uint256& minimum_required_work);
+            const CBlockIndex* chain_start, const arith_uint256& minimum_required_work,
+            int signature_threads = 0);
 
     /** Result data structure for ProcessNextHeaders. */
     struct ProcessingResult {
@@ -200,6 +231,9 @@ private:
     /** In PRESYNC, process and update state for a single header */
     bool ValidateAndProcessSingleHeader(const CBlockHeader& current);
 
+    /** In REDOWNLOAD, check the block signatures of a batch of headers */
+    bool CheckRedownloadedSignatures(const std::vector<CBlockHeader>& headers) const;
+
     /** In REDOWNLOAD, check a header's commitment (if applicable) and add to
      * buffer for later processing */
     bool ValidateAndStoreRedownloadedHeader(const CBlockHeader& header);
@@ -220,6 +254,9 @@ private:
     /** Minimum work that we're looking for on this chain. */
     const arith_uint256 m_minimum_required_work;
 
+    /** Threads besides the calling one that check block signatures in REDOWNLOAD */
+    const int m_signature_threads;
+
     /** Work that we've seen so far on the peer's chain */
     arith_uint256 m_current_chain_work;
 
@@ -247,6 +284,10 @@ private:
      *  m_redownloaded_headers */
     std::deque<CompressedHeader> m_redownloaded_headers;
 
+    /** The proof-of-stake fields of the proof-of-stake headers in
+     *  m_redownloaded_headers, in the same order */
+    std::deque<CompressedStake> m_redownloaded_stakes;
+
     /** Height of last header in m_redownloaded_headers */
     int64_t m_redownload_buffer_last_height{0};
 
@@ -8,6 +8,7 @@
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
 #include <logging.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -18,13 +19,19 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Maximum number of threads executing the requests of one batch */
+static int g_rpc_batch_threads{DEFAULT_RPC_BATCH_THREADS};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -89,6 +96,57 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/** Sends the result of a singleton request as a chunked HTTP reply while the
+ * RPC method is producing it. The envelope is the same as JSONRPCReply().
+ */
+class HTTPRPCResultStream final : public RPCResultStream
+{
+private:
+    HTTPRequest* const m_req;
+    std::optional<JSONStreamWriter> m_writer;
+
+public:
+    explicit HTTPRPCResultStream(HTTPRequest* req) : m_req{req} {}
+
+    JSONStreamWriter& Start() override
+    {
+        assert(!m_writer);
+        m_req->WriteHeader("Content-Type", "application/json");
+        m_req->StartChunkedReply(HTTP_OK);
+        m_writer.emplace([this](std::string_view chunk) {
+            if (!m_req->WriteReplyChunk(chunk)) {
+                throw std::runtime_error("Client disconnected while the reply was being sent");
+            }
+        });
+        m_writer->BeginObject();
+        m_writer->Key("result");
+        return *m_writer;
+    }
+
+    bool Started() const override { return m_writer.has_value(); }
+
+    //! Finish the envelope after the result was written, and end the reply.
+    void Finish(const UniValue& id)
+    {
+        try {
+            m_writer->KeyValue("error", NullUniValue);
+            m_writer->KeyValue("id", id);
+            m_writer->EndObject();
+            m_writer->Flush();
+            m_req->WriteReplyChunk("\n");
+        } catch (const std::runtime_error&) {
+            // The client went away, there is nothing left to do but end the reply.
+        }
+        m_req->EndChunkedReply();
+    }
+
+    //! End a reply that was started but can't be completed. The client sees a truncated body.
+    void Abort()
+    {
+        m_req->EndChunkedReply();
+    }
+};
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -199,7 +257,21 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
-            UniValue result = tableRPC.execute(jreq);
+            HTTPRPCResultStream stream{req};
+            jreq.result_stream = &stream;
+            UniValue result;
+            try {
+                result = tableRPC.execute(jreq);
+            } catch (...) {
+                if (!stream.Started()) throw;
+                LogPrint(BCLog::RPC, "Aborted streamed reply to %s\n", jreq.strMethod);
+                stream.Abort();
+                return false;
+            }
+            if (stream.Started()) {
+                stream.Finish(jreq.id);
+                return true;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -222,7 +294,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), QueueHTTPTask, g_rpc_batch_threads);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -297,6 +369,7 @@ bool StartHTTPRPC(const std::any& context)
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    g_rpc_batch_threads = std::max<int>(gArgs.GetIntArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 1);
 
     auto handle_rpc = [context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
     RegisterHTTPHandler("/", true, handle_rpc);
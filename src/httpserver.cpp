@@ -11,6 +11,7 @@
 #include <chainparamsbase.h>
 #include <common/args.h>
 #include <compat/compat.h>
+#include <crypto/common.h>
 #include <logging.h>
 #include <netbase.h>
 #include <node/interface_ui.h>
@@ -20,8 +21,12 @@
 #include <util/check.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
@@ -39,6 +44,7 @@
 #include <event2/http.h>
 #include <event2/http_struct.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -46,6 +52,8 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Multiple of -rpcworkqueue up to which requests are queued while applying backpressure */
+static constexpr size_t HTTP_WORKQUEUE_OVERFLOW_FACTOR{4};
 
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
@@ -55,10 +63,7 @@ public:
         req(std::move(_req)), path(_path), func(_func)
     {
     }
-    void operator()() override
-    {
-        func(req.get(), path);
-    }
+    void operator()() override;
 
     std::unique_ptr<HTTPRequest> req;
 
@@ -67,63 +72,219 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
+/** Work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
+ *
+ * Items are queued per client, and the clients are spread over one shard per
+ * worker thread. Each shard serves its clients round-robin, so a client
+ * sending a burst of requests only delays its own. Workers take items from
+ * their own shard first and steal from the other shards when it is empty, so
+ * they only contend for a lock when there is little work left.
  */
 template <typename WorkItem>
 class WorkQueue
 {
+public:
+    //! Identifies the client that queued an item, for fairness between clients
+    using ClientId = uint64_t;
+
 private:
-    Mutex cs;
-    std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
-    bool running GUARDED_BY(cs){true};
+    struct Entry {
+        std::unique_ptr<WorkItem> item;
+        SteadyClock::time_point queued;
+    };
+    struct Shard {
+        Mutex mutex;
+        //! Items of each client that has items queued
+        std::unordered_map<ClientId, std::deque<Entry>> clients GUARDED_BY(mutex);
+        //! Clients with items queued, in the order they are served
+        std::deque<ClientId> ready GUARDED_BY(mutex);
+        //! Number of items queued, to skip empty shards without locking them
+        std::atomic<size_t> size{0};
+    };
+
+    //! Bucket i of the wait time histogram counts waits of less than 2^i microseconds
+    static constexpr size_t WAIT_BUCKETS{32};
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
     const size_t maxDepth;
+    //! Number of items queued, including ones that are still being added to a shard
+    std::atomic<size_t> m_depth{0};
+    //! Number of items that can be taken from the shards
+    std::atomic<size_t> m_available{0};
+    std::atomic<bool> m_running{true};
+
+    //! Idle workers wait for m_available on this
+    Mutex m_idle_mutex;
+    std::condition_variable m_idle_cv;
+    std::atomic<int> m_idle_workers{0};
+
+    std::atomic<uint64_t> m_queued_total{0};
+    std::atomic<uint64_t> m_stolen_total{0};
+    std::array<std::atomic<uint64_t>, WAIT_BUCKETS> m_wait_histogram{};
+    std::atomic<int64_t> m_wait_max_us{0};
+
+    bool Push(WorkItem* item, ClientId client, size_t limit) EXCLUSIVE_LOCKS_REQUIRED(!m_idle_mutex)
+    {
+        size_t depth{m_depth.load()};
+        do {
+            if (depth >= limit) return false;
+        } while (!m_depth.compare_exchange_weak(depth, depth + 1));
+        // Checked after reserving a place, so that workers that saw m_running
+        // unset and m_depth zero can be sure nothing is added anymore.
+        if (!m_running) {
+            --m_depth;
+            return false;
+        }
+        Shard& shard{*m_shards[client % m_shards.size()]};
+        {
+            LOCK(shard.mutex);
+            auto& items{shard.clients[client]};
+            if (items.empty()) shard.ready.push_back(client);
+            items.push_back({std::unique_ptr<WorkItem>(item), SteadyClock::now()});
+            ++shard.size;
+            ++m_available;
+        }
+        ++m_queued_total;
+        if (m_idle_workers > 0) {
+            LOCK(m_idle_mutex);
+            m_idle_cv.notify_one();
+        }
+        return true;
+    }
+
+    std::optional<Entry> Pop(size_t worker)
+    {
+        for (size_t i = 0; i < m_shards.size(); ++i) {
+            Shard& shard{*m_shards[(worker + i) % m_shards.size()]};
+            if (shard.size == 0) continue;
+            LOCK(shard.mutex);
+            if (shard.ready.empty()) continue;
+            const ClientId client{shard.ready.front()};
+            shard.ready.pop_front();
+            auto it{shard.clients.find(client)};
+            Entry entry{std::move(it->second.front())};
+            it->second.pop_front();
+            if (it->second.empty()) {
+                shard.clients.erase(it);
+            } else {
+                shard.ready.push_back(client);
+            }
+            --shard.size;
+            --m_available;
+            --m_depth;
+            if (i > 0) ++m_stolen_total;
+            return entry;
+        }
+        return std::nullopt;
+    }
+
+    void RecordWait(SteadyClock::duration wait)
+    {
+        const int64_t wait_us{std::max<int64_t>(0, Ticks<std::chrono::microseconds>(wait))};
+        const size_t bucket{std::min<size_t>(CountBits(static_cast<uint64_t>(wait_us)), WAIT_BUCKETS - 1)};
+        ++m_wait_histogram[bucket];
+        int64_t max{m_wait_max_us.load()};
+        while (wait_us > max && !m_wait_max_us.compare_exchange_weak(max, wait_us)) {}
+    }
+
+    //! Upper bound of the wait time below which the given fraction of waits fell
+    std::chrono::microseconds WaitPercentile(const std::array<uint64_t, WAIT_BUCKETS>& histogram, uint64_t total, double fraction) const
+    {
+        uint64_t count{0};
+        for (size_t bucket = 0; bucket < WAIT_BUCKETS; ++bucket) {
+            count += histogram[bucket];
+            if (count > 0 && count >= total * fraction) {
+                return std::min(std::chrono::microseconds{uint64_t{1} << bucket}, std::chrono::microseconds{m_wait_max_us.load()});
+            }
+        }
+        return std::chrono::microseconds{m_wait_max_us.load()};
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : maxDepth(_maxDepth)
+    explicit WorkQueue(size_t _maxDepth, size_t num_shards) : maxDepth(_maxDepth)
     {
+        for (size_t i = 0; i < std::max<size_t>(num_shards, 1); ++i) {
+            m_shards.push_back(std::make_unique<Shard>());
+        }
     }
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue() = default;
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    /** Enqueue a work item, if the queue holds less than limit items (by default its depth) */
+    bool Enqueue(WorkItem* item, ClientId client, std::optional<size_t> limit = std::nullopt) EXCLUSIVE_LOCKS_REQUIRED(!m_idle_mutex)
     {
-        LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
-            return false;
-        }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
-        return true;
+        return Push(item, client, limit.value_or(maxDepth));
+    }
+    /** Enqueue a work item if the queue is less than half full */
+    bool EnqueueIfSpare(WorkItem* item, ClientId client) EXCLUSIVE_LOCKS_REQUIRED(!m_idle_mutex)
+    {
+        return Push(item, client, maxDepth / 2);
     }
     /** Thread function */
-    void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    void Run(size_t worker) EXCLUSIVE_LOCKS_REQUIRED(!m_idle_mutex)
     {
         while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running && queue.empty())
+            std::optional<Entry> entry{Pop(worker)};
+            if (!entry) {
+                WAIT_LOCK(m_idle_mutex, lock);
+                ++m_idle_workers;
+                while (m_running && m_available == 0) {
+                    m_idle_cv.wait(lock);
+                }
+                --m_idle_workers;
+                if (!m_running && m_depth == 0)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                continue;
             }
-            (*i)();
+            RecordWait(SteadyClock::now() - entry->queued);
+            (*entry->item)();
         }
     }
     /** Interrupt and exit loops */
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!m_idle_mutex)
+    {
+        LOCK(m_idle_mutex);
+        m_running = false;
+        m_idle_cv.notify_all();
+    }
+
+    size_t Depth() const { return m_depth; }
+    size_t MaxDepth() const { return maxDepth; }
+
+    HTTPWorkQueueStats GetStats() const
     {
-        LOCK(cs);
-        running = false;
-        cond.notify_all();
+        HTTPWorkQueueStats stats;
+        stats.depth = m_depth;
+        stats.max_depth = maxDepth;
+        stats.requests = m_queued_total;
+        stats.stolen = m_stolen_total;
+        std::array<uint64_t, WAIT_BUCKETS> histogram;
+        uint64_t total{0};
+        for (size_t bucket = 0; bucket < WAIT_BUCKETS; ++bucket) {
+            histogram[bucket] = m_wait_histogram[bucket];
+            total += histogram[bucket];
+        }
+        if (total > 0) {
+            stats.wait_p50 = WaitPercentile(histogram, total, 0.5);
+            stats.wait_p99 = WaitPercentile(histogram, total, 0.99);
+        }
+        stats.wait_max = std::chrono::microseconds{m_wait_max_us.load()};
+        return stats;
     }
 };
 
+/** Work item running a task queued with QueueHTTPTask */
+class HTTPTaskItem final : public HTTPClosure
+{
+public:
+    explicit HTTPTaskItem(std::function<void()> task) : m_task{std::move(task)} {}
+    void operator()() override { m_task(); }
+
+private:
+    std::function<void()> m_task;
+};
+
 struct HTTPPathHandler
 {
     HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
@@ -145,11 +306,20 @@ static struct evhttp* eventHTTP = nullptr;
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
 static std::unique_ptr<WorkQueue<HTTPClosure>> g_work_queue{nullptr};
+//! Number of requests rejected because the work queue was full
+static std::atomic<uint64_t> g_work_queue_rejected{0};
+//! Whether accepting new connections is paused because the work queue is full
+static std::atomic<bool> g_listeners_paused{false};
+//! Whether resuming to accept connections was scheduled on the event thread
+static std::atomic<bool> g_listeners_resume_scheduled{false};
+//! Number of times accepting new connections was paused
+static std::atomic<uint64_t> g_listeners_paused_count{0};
 //! Handlers for (sub)paths
 static GlobalMutex g_httppathhandlers_mutex;
 static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_mutex);
 //! Bound listening sockets
-static std::vector<evhttp_bound_socket *> boundSockets;
+static GlobalMutex g_bound_sockets_mutex;
+static std::vector<evhttp_bound_socket *> boundSockets GUARDED_BY(g_bound_sockets_mutex);
 
 /**
  * @brief Helps keep track of open `evhttp_connection`s with active `evhttp_requests`
@@ -259,6 +429,52 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     assert(false);
 }
 
+/** Identify the client of a request for fairness in the work queue. Connections
+ * from the same address count as the same client.
+ */
+static WorkQueue<HTTPClosure>::ClientId GetClientId(const CService& peer)
+{
+    static const CServiceHash hasher;
+    return hasher(CService{peer, 0});
+}
+
+/** Stop accepting new connections while the work queue is over its depth.
+ * Requests on open connections are still queued, as each of them can only
+ * have a single request in flight. Must be called from the event thread.
+ */
+static void PauseHTTPListeners()
+{
+    if (g_listeners_paused.exchange(true)) return;
+    ++g_listeners_paused_count;
+    LogPrint(BCLog::HTTP, "Work queue depth exceeded, pausing accepting new connections\n");
+    LOCK(g_bound_sockets_mutex);
+    for (evhttp_bound_socket* socket : boundSockets) {
+        evconnlistener_disable(evhttp_bound_socket_get_listener(socket));
+    }
+}
+
+/** Accept new connections again once the work queue drained to half its depth. */
+static void MaybeResumeHTTPListeners()
+{
+    if (!g_listeners_paused || g_work_queue->Depth() > g_work_queue->MaxDepth() / 2) return;
+    if (g_listeners_resume_scheduled.exchange(true)) return;
+    event_base_once(eventBase, -1, EV_TIMEOUT, [](evutil_socket_t, short, void*) {
+        g_listeners_resume_scheduled = false;
+        if (!g_listeners_paused.exchange(false)) return;
+        LogPrint(BCLog::HTTP, "Work queue drained, accepting new connections again\n");
+        LOCK(g_bound_sockets_mutex);
+        for (evhttp_bound_socket* socket : boundSockets) {
+            evconnlistener_enable(evhttp_bound_socket_get_listener(socket));
+        }
+    }, nullptr, nullptr);
+}
+
+void HTTPWorkItem::operator()()
+{
+    MaybeResumeHTTPListeners();
+    func(req.get(), path);
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
@@ -328,9 +544,15 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     if (i != iend) {
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
+        const auto client{GetClientId(item->req->GetPeer())};
+        if (g_work_queue->Enqueue(item.get(), client)) {
             item.release(); /* if true, queue took ownership */
+        } else if (g_work_queue->Enqueue(item.get(), client, g_work_queue->MaxDepth() * HTTP_WORKQUEUE_OVERFLOW_FACTOR)) {
+            // Apply backpressure instead of rejecting the request
+            item.release();
+            PauseHTTPListeners();
         } else {
+            ++g_work_queue_rejected;
             LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
             item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
         }
@@ -382,6 +604,7 @@ static bool HTTPBindAddresses(struct evhttp* http)
     }
 
     // Bind addresses
+    LOCK(g_bound_sockets_mutex);
     for (std::vector<std::pair<std::string, uint16_t> >::iterator i = endpoints.begin(); i != endpoints.end(); ++i) {
         LogPrintf("Binding RPC on address %s port %i\n", i->first, i->second);
         evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
@@ -402,7 +625,7 @@ static bool HTTPBindAddresses(struct evhttp* http)
 static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
 {
     util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    queue->Run();
+    queue->Run(worker_num);
 }
 
 /** libevent event log callback */
@@ -464,9 +687,10 @@ bool InitHTTPServer()
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
+    int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
     LogPrintfCategory(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, rpcThreads);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -520,10 +744,13 @@ void StopHTTPServer()
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
-    for (evhttp_bound_socket *socket : boundSockets) {
-        evhttp_del_accept_socket(eventHTTP, socket);
+    {
+        LOCK(g_bound_sockets_mutex);
+        for (evhttp_bound_socket *socket : boundSockets) {
+            evhttp_del_accept_socket(eventHTTP, socket);
+        }
+        boundSockets.clear();
     }
-    boundSockets.clear();
     {
         if (const auto n_connections{g_requests.CountActiveConnections()}; n_connections != 0) {
             LogPrint(BCLog::HTTP, "Waiting for %d connections to stop HTTP server\n", n_connections);
@@ -549,6 +776,25 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+bool QueueHTTPTask(std::function<void()> task)
+{
+    if (!g_work_queue) return false;
+    auto item{std::make_unique<HTTPTaskItem>(std::move(task))};
+    // Tasks are queued as a client of their own, so they take turns with requests.
+    if (!g_work_queue->EnqueueIfSpare(item.get(), /*client=*/0)) return false;
+    item.release(); // queue took ownership
+    return true;
+}
+
+std::optional<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    if (!g_work_queue) return std::nullopt;
+    HTTPWorkQueueStats stats{g_work_queue->GetStats()};
+    stats.rejected = g_work_queue_rejected;
+    stats.backpressure = g_listeners_paused_count;
+    return stats;
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -586,7 +832,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && m_chunked) {
+        // The body is incomplete, but there is no way to report an error anymore
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -638,6 +888,11 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * this cannot be done from worker threads.
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+{
+    WriteReply(nStatus, MakeByteSpan(strReply));
+}
+
+void HTTPRequest::WriteReply(int nStatus, Span<const std::byte> reply)
 {
     assert(!replySent && req);
     if (ShutdownRequested()) {
@@ -646,7 +901,7 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    evbuffer_add(evb, reply.data(), reply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
@@ -667,6 +922,158 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+/** Progress of a chunked reply, shared between the worker writing it and the
+ * main http thread sending it.
+ */
+struct HTTPRequest::ChunkedReplyState {
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Bytes handed to the main http thread that it didn't pass to libevent yet
+    size_t m_queued GUARDED_BY(m_mutex){0};
+    //! Bytes in the connection's output buffer when last checked
+    size_t m_buffered GUARDED_BY(m_mutex){0};
+    //! Whether the client connection went away
+    bool m_closed GUARDED_BY(m_mutex){false};
+
+    //! Refresh m_buffered and m_closed. Must be called from the main http thread.
+    void Update(evhttp_request* req) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        evhttp_connection* conn{evhttp_request_get_connection(req)};
+        bufferevent* bev{conn ? evhttp_connection_get_bufferevent(conn) : nullptr};
+        {
+            LOCK(m_mutex);
+            m_closed = bev == nullptr;
+            m_buffered = bev ? evbuffer_get_length(bufferevent_get_output(bev)) : 0;
+        }
+        m_cv.notify_all();
+    }
+
+    //! Called by libevent when the connection's output buffer was drained
+    static void OnWritten(evhttp_connection*, void* arg)
+    {
+        auto& self{*static_cast<ChunkedReplyState*>(arg)};
+        WITH_LOCK(self.m_mutex, self.m_buffered = 0);
+        self.m_cv.notify_all();
+    }
+};
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && req && !m_chunked);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    m_chunked = std::make_shared<ChunkedReplyState>();
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus, state = m_chunked] {
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+        state->Update(req_copy);
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::ReserveReplyChunk(size_t size)
+{
+    auto& state{*m_chunked};
+    WAIT_LOCK(state.m_mutex, lock);
+    while (!state.m_closed && state.m_queued + state.m_buffered > MAX_CHUNKED_REPLY_BUFFER) {
+        if (ShutdownRequested()) return false;
+        if (state.m_cv.wait_for(lock, std::chrono::milliseconds{100}) == std::cv_status::timeout) {
+            // Nothing was written for a while, check whether the client is still there.
+            auto req_copy = req;
+            HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state = m_chunked] { state->Update(req_copy); });
+            ev->trigger(nullptr);
+        }
+    }
+    if (state.m_closed) return false;
+    state.m_queued += size;
+    return true;
+}
+
+void HTTPRequest::SendReplyChunk(struct evbuffer* chunk, size_t size)
+{
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, chunk, size, state = m_chunked] {
+        evhttp_send_reply_chunk_with_cb(req_copy, chunk, ChunkedReplyState::OnWritten, state.get());
+        evbuffer_free(chunk);
+        WITH_LOCK(state->m_mutex, state->m_queued -= size);
+        state->Update(req_copy);
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WriteReplyChunk(std::string_view data)
+{
+    assert(!replySent && req && m_chunked);
+    if (data.empty()) return true;
+    if (!ReserveReplyChunk(data.size())) return false;
+    // Copy the data here rather than in the main http thread, which only
+    // moves the buffer into the connection's output.
+    struct evbuffer* chunk = evbuffer_new();
+    assert(chunk);
+    evbuffer_add(chunk, data.data(), data.size());
+    SendReplyChunk(chunk, data.size());
+    return true;
+}
+
+bool HTTPRequest::WriteReplyChunk(std::vector<unsigned char>&& data)
+{
+    assert(!replySent && req && m_chunked);
+    if (data.empty()) return true;
+    const size_t size{data.size()};
+    if (!ReserveReplyChunk(size)) return false;
+    // The buffer is referenced by the chunk and moved along with it into the
+    // connection's output; libevent frees it once it was sent.
+    auto* owned = new std::vector<unsigned char>(std::move(data));
+    struct evbuffer* chunk = evbuffer_new();
+    assert(chunk);
+    evbuffer_add_reference(chunk, owned->data(), size, [](const void*, size_t, void* arg) {
+        delete static_cast<std::vector<unsigned char>*>(arg);
+    }, owned);
+    SendReplyChunk(chunk, size);
+    return true;
+}
+
+bool HTTPRequest::WriteReplyChunk(std::shared_ptr<const std::vector<unsigned char>> data)
+{
+    assert(!replySent && req && m_chunked);
+    if (!data || data->empty()) return true;
+    const size_t size{data->size()};
+    if (!ReserveReplyChunk(size)) return false;
+    auto* owned = new std::shared_ptr<const std::vector<unsigned char>>(std::move(data));
+    struct evbuffer* chunk = evbuffer_new();
+    assert(chunk);
+    evbuffer_add_reference(chunk, (*owned)->data(), size, [](const void*, size_t, void* arg) {
+        delete static_cast<std::shared_ptr<const std::vector<unsigned char>>*>(arg);
+    }, owned);
+    SendReplyChunk(chunk, size);
+    return true;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && req && m_chunked);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state = m_chunked] {
+        // The request may be freed by evhttp_send_reply_end.
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        evhttp_send_reply_end(req_copy);
+        // Re-enable reading from the socket, see WriteReply.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02010900) {
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+    });
+    ev->trigger(nullptr);
+    m_chunked.reset();
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
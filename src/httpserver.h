@@ -5,13 +5,23 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <span.h>
+
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+static const int DEFAULT_RPC_BATCH_THREADS=2;
+/** Maximum number of bytes of a chunked reply waiting to be sent before the writer blocks */
+static constexpr size_t MAX_CHUNKED_REPLY_BUFFER{1 << 20};
 
 struct evhttp_request;
 struct event_base;
@@ -45,6 +55,36 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Queue a task for the HTTP worker threads, to split up the work of a request.
+ * Tasks are only queued while the work queue is less than half full, so that
+ * they can't cause requests to be rejected.
+ * @returns whether the task was queued.
+ */
+bool QueueHTTPTask(std::function<void()> task);
+
+/** Statistics of the HTTP work queue */
+struct HTTPWorkQueueStats {
+    //! Number of work items waiting for a worker thread
+    size_t depth{0};
+    //! Depth above which new connections are no longer accepted (-rpcworkqueue)
+    size_t max_depth{0};
+    //! Total number of requests queued
+    uint64_t requests{0};
+    //! Requests rejected because the queue was full even after applying backpressure
+    uint64_t rejected{0};
+    //! Work items taken by a worker thread from another thread's share of the queue
+    uint64_t stolen{0};
+    //! Number of times accepting new connections was paused because the queue was full
+    uint64_t backpressure{0};
+    //! Estimated median, 99th percentile and maximum time requests waited in the queue
+    std::chrono::microseconds wait_p50{0};
+    std::chrono::microseconds wait_p99{0};
+    std::chrono::microseconds wait_max{0};
+};
+
+/** Get statistics of the HTTP work queue, or std::nullopt if the HTTP server isn't initialized. */
+std::optional<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -56,8 +96,17 @@ struct event_base* EventBase();
 class HTTPRequest
 {
 private:
+    struct ChunkedReplyState;
+
     struct evhttp_request* req;
     bool replySent;
+    //! Set while a chunked reply is being sent
+    std::shared_ptr<ChunkedReplyState> m_chunked;
+
+    //! Wait until a chunk of the given size may be queued, see WriteReplyChunk()
+    bool ReserveReplyChunk(size_t size);
+    //! Pass a reserved chunk to the main http thread, which takes ownership of it
+    void SendReplyChunk(struct evbuffer* chunk, size_t size);
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -124,6 +173,33 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+    void WriteReply(int nStatus, Span<const std::byte> reply);
+
+    /**
+     * Start a reply whose body is sent in parts with WriteReplyChunk(), for
+     * replies too large to be built in memory first. Write the headers before
+     * calling this.
+     */
+    void StartChunkedReply(int nStatus);
+
+    /**
+     * Send the next part of a reply started with StartChunkedReply(). Blocks
+     * while too much data is waiting to be sent to the client.
+     *
+     * @returns false if the client went away or shutdown was requested, in
+     * which case the reply should be ended without sending any more data.
+     */
+    bool WriteReplyChunk(std::string_view data);
+    /** Like above, but hands the buffer to libevent instead of copying it. */
+    bool WriteReplyChunk(std::vector<unsigned char>&& data);
+    /** Like above, but keeps a reference to a shared buffer until it was sent. */
+    bool WriteReplyChunk(std::shared_ptr<const std::vector<unsigned char>> data);
+
+    /**
+     * Finish a reply started with StartChunkedReply(). Like WriteReply(), this
+     * gives the request back to the main thread.
+     */
+    void EndChunkedReply();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <coins.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <crypto/muhash.h>
 #include <index/coinstatsindex.h>
 #include <kernel/coinstats.h>
@@ -18,6 +19,7 @@
 using kernel::ApplyCoinHash;
 using kernel::CCoinsStats;
 using kernel::GetBogoSize;
+using kernel::ParallelMuHash;
 using kernel::RemoveCoinHash;
 
 static constexpr uint8_t DB_BLOCK_HASH{'s'};
@@ -104,7 +106,8 @@ struct DBHashKey {
 std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
 
 CoinStatsIndex::CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
-    : BaseIndex(std::move(chain), "coinstatsindex")
+    : BaseIndex(std::move(chain), "coinstatsindex"),
+      m_block_muhash{std::make_unique<ParallelMuHash>(std::clamp(GetNumCores() - 1, 0, kernel::MAX_MUHASH_THREADS))}
 {
     fs::path path{gArgs.GetDataDirNet() / "indexes" / "coinstats"};
     fs::create_directories(path);
@@ -112,6 +115,8 @@ CoinStatsIndex::CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t
     m_db = std::make_unique<CoinStatsIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
 }
 
+CoinStatsIndex::~CoinStatsIndex() = default;
+
 bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
     CBlockUndo block_undo;
@@ -167,7 +172,7 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
                     continue;
                 }
 
-                ApplyCoinHash(m_muhash, outpoint, coin);
+                m_block_muhash->Insert(outpoint, coin);
 
                 if (tx->IsCoinBase()) {
                     m_total_coinbase_amount += coin.out.nValue;
@@ -188,7 +193,7 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
                     Coin coin{tx_undo.vprevout[j]};
                     COutPoint outpoint{tx->vin[j].prevout.hash, tx->vin[j].prevout.n};
 
-                    RemoveCoinHash(m_muhash, outpoint, coin);
+                    m_block_muhash->Remove(outpoint, coin);
 
                     m_total_prevout_spent_amount += coin.out.nValue;
 
@@ -227,6 +232,7 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
     value.second.total_unspendables_scripts = m_total_unspendables_scripts;
     value.second.total_unspendables_unclaimed_rewards = m_total_unspendables_unclaimed_rewards;
 
+    m_block_muhash->Apply(m_muhash);
     uint256 out;
     m_muhash.Finalize(out);
     value.second.muhash = out;
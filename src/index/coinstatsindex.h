@@ -8,10 +8,13 @@
 #include <crypto/muhash.h>
 #include <index/base.h>
 
+#include <memory>
+
 class CBlockIndex;
 class CDBBatch;
 namespace kernel {
 struct CCoinsStats;
+class ParallelMuHash;
 }
 
 static constexpr bool DEFAULT_COINSTATSINDEX{false};
@@ -25,6 +28,8 @@ private:
     std::unique_ptr<BaseIndex::DB> m_db;
 
     MuHash3072 m_muhash;
+    //! Hashes the coins created and spent by a block before they are applied to m_muhash.
+    std::unique_ptr<kernel::ParallelMuHash> m_block_muhash;
     uint64_t m_transaction_output_count{0};
     uint64_t m_bogo_size{0};
     CAmount m_total_amount{0};
@@ -56,6 +61,7 @@ protected:
 public:
     // Constructs the index, which becomes available to be queried.
     explicit CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    ~CoinStatsIndex() override;
 
     // Look up stats for a specific block using CBlockIndex
     std::optional<kernel::CCoinsStats> LookUpStats(const CBlockIndex& block_index) const;
@@ -8,12 +8,16 @@
 #include <kernel/notifications_interface.h>
 #include <util/fs.h>
 
+#include <cstddef>
 #include <cstdint>
 
 class CChainParams;
 
 namespace kernel {
 
+/** Default for -blockservecache, the size of the serialized block cache in MiB */
+static constexpr int64_t DEFAULT_BLOCK_SERVE_CACHE_SIZE_MB{32};
+
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
  * `BlockManager::Options` due to the using-declaration in `BlockManager`.
@@ -24,6 +28,7 @@ struct BlockManagerOpts {
     bool fast_prune{false};
     const fs::path blocks_dir;
     Notifications& notifications;
+    size_t serialized_block_cache_bytes{DEFAULT_BLOCK_SERVE_CACHE_SIZE_MB * 1024 * 1024};
 };
 
 } // namespace kernel
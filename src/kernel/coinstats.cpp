@@ -20,9 +20,11 @@
 #include <uint256.h>
 #include <util/check.h>
 #include <util/overflow.h>
+#include <util/thread.h>
 #include <validation.h>
 #include <version.h>
 
+#include <algorithm>
 #include <cassert>
 #include <iosfwd>
 #include <iterator>
@@ -56,7 +58,7 @@ static void TxOutSer(T& ss, const COutPoint& outpoint, const Coin& coin)
     ss << coin.out;
 }
 
-static void ApplyCoinHash(HashWriter& ss, const COutPoint& outpoint, const Coin& coin)
+void ApplyCoinHash(HashWriter& ss, const COutPoint& outpoint, const Coin& coin)
 {
     TxOutSer(ss, outpoint, coin);
 }
@@ -75,8 +77,110 @@ void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& c
     muhash.Remove(MakeUCharSpan(ss));
 }
 
+static void ApplyCoinHash(ParallelMuHash& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    muhash.Insert(outpoint, coin);
+}
+
 static void ApplyCoinHash(std::nullptr_t, const COutPoint& outpoint, const Coin& coin) {}
 
+//! Number of coins handed to a ParallelMuHash worker at a time.
+static constexpr size_t MUHASH_BATCH_COINS{256};
+//! Maximum number of queued batches per ParallelMuHash worker.
+static constexpr size_t MUHASH_QUEUED_BATCHES_PER_WORKER{4};
+
+ParallelMuHash::ParallelMuHash(int worker_threads)
+    : m_partials(std::max(worker_threads, 1))
+{
+    for (int n = 0; n < worker_threads; ++n) {
+        m_workers.emplace_back(&util::TraceThread, strprintf("muhash.%i", n), [this, n] { WorkerThread(n); });
+    }
+}
+
+ParallelMuHash::~ParallelMuHash()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_work_cv.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+}
+
+void ParallelMuHash::Insert(const COutPoint& outpoint, const Coin& coin)
+{
+    Add(outpoint, coin, /*remove=*/false);
+}
+
+void ParallelMuHash::Remove(const COutPoint& outpoint, const Coin& coin)
+{
+    Add(outpoint, coin, /*remove=*/true);
+}
+
+void ParallelMuHash::Add(const COutPoint& outpoint, const Coin& coin, bool remove)
+{
+    CVectorWriter writer{0, m_batch.data, m_batch.data.size()};
+    TxOutSer(writer, outpoint, coin);
+    m_batch.ends.emplace_back(m_batch.data.size(), remove);
+    if (m_batch.ends.size() >= MUHASH_BATCH_COINS) Submit();
+}
+
+static void ProcessBatch(MuHash3072& muhash, Span<const unsigned char> data, Span<const std::pair<size_t, bool>> ends)
+{
+    size_t begin{0};
+    for (const auto& [end, remove] : ends) {
+        const auto element{data.subspan(begin, end - begin)};
+        if (remove) {
+            muhash.Remove(element);
+        } else {
+            muhash.Insert(element);
+        }
+        begin = end;
+    }
+}
+
+void ParallelMuHash::Submit()
+{
+    if (m_batch.ends.empty()) return;
+    if (m_workers.empty()) {
+        ProcessBatch(m_partials[0], m_batch.data, m_batch.ends);
+    } else {
+        WAIT_LOCK(m_mutex, lock);
+        m_idle_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_queue.size() < MUHASH_QUEUED_BATCHES_PER_WORKER * m_workers.size(); });
+        m_queue.push_back(std::move(m_batch));
+        m_work_cv.notify_one();
+    }
+    m_batch = {};
+}
+
+void ParallelMuHash::Apply(MuHash3072& muhash)
+{
+    Submit();
+    WAIT_LOCK(m_mutex, lock);
+    m_idle_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_queue.empty() && m_busy == 0; });
+    for (MuHash3072& partial : m_partials) {
+        muhash *= partial;
+        partial = MuHash3072{};
+    }
+}
+
+void ParallelMuHash::WorkerThread(size_t index)
+{
+    while (true) {
+        Batch batch;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_work_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+            batch = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_busy;
+        }
+        // The queue has room again.
+        m_idle_cv.notify_all();
+        ProcessBatch(m_partials[index], batch.data, batch.ends);
+        WITH_LOCK(m_mutex, --m_busy);
+        m_idle_cv.notify_all();
+    }
+}
+
 //! Warning: be very careful when changing this! assumeutxo and UTXO snapshot
 //! validation commitments are reliant on the hash constructed by this
 //! function.
@@ -114,7 +218,7 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
 
 //! Calculate statistics about the unspent transaction output set
 template <typename T>
-static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
@@ -151,7 +255,7 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
     return true;
 }
 
-std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point)
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point, int muhash_threads)
 {
     CBlockIndex* pindex = WITH_LOCK(::cs_main, return blockman.LookupBlockIndex(view->GetBestBlock()));
     CCoinsStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
@@ -163,11 +267,16 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
             return ComputeUTXOStats(view, stats, ss, interruption_point);
         }
         case(CoinStatsHashType::MUHASH): {
+            if (muhash_threads > 0) {
+                ParallelMuHash muhash{muhash_threads};
+                return ComputeUTXOStats(view, stats, muhash, interruption_point);
+            }
             MuHash3072 muhash;
             return ComputeUTXOStats(view, stats, muhash, interruption_point);
         }
         case(CoinStatsHashType::NONE): {
-            return ComputeUTXOStats(view, stats, nullptr, interruption_point);
+            std::nullptr_t no_hash;
+            return ComputeUTXOStats(view, stats, no_hash, interruption_point);
         }
         } // no default case, so the compiler can warn about missing cases
         assert(false);
@@ -189,6 +298,12 @@ static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats)
     muhash.Finalize(out);
     stats.hashSerialized = out;
 }
+static void FinalizeHash(ParallelMuHash& parallel_muhash, CCoinsStats& stats)
+{
+    MuHash3072 muhash;
+    parallel_muhash.Apply(muhash);
+    FinalizeHash(muhash, stats);
+}
 static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
 
 } // namespace kernel
@@ -8,21 +8,31 @@
 #include <consensus/amount.h>
 #include <crypto/muhash.h>
 #include <streams.h>
+#include <sync.h>
 #include <uint256.h>
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
 
 class CCoinsView;
 class Coin;
 class COutPoint;
 class CScript;
+class HashWriter;
 namespace node {
 class BlockManager;
 } // namespace node
 
 namespace kernel {
+//! Maximum number of worker threads used to compute a MuHash over coins.
+static constexpr int MAX_MUHASH_THREADS{8};
+
 enum class CoinStatsHashType {
     HASH_SERIALIZED,
     MUHASH,
@@ -73,10 +83,68 @@ struct CCoinsStats {
 
 uint64_t GetBogoSize(const CScript& script_pub_key);
 
+void ApplyCoinHash(HashWriter& ss, const COutPoint& outpoint, const Coin& coin);
 void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
-std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+/**
+ * Computes MuHash3072 updates for coins on a pool of worker threads.
+ *
+ * MuHash is commutative, so each worker accumulates its share of the inserted
+ * and removed coins into a partial MuHash3072 of its own. Apply() multiplies
+ * the partial results into the caller's hash. Only numerators and
+ * denominators are multiplied; the modular inversion is done once, when the
+ * combined hash is finalized.
+ *
+ * Coins are serialized on the calling thread and handed to the workers in
+ * batches. With zero worker threads, all hashing happens on the calling
+ * thread.
+ */
+class ParallelMuHash
+{
+public:
+    explicit ParallelMuHash(int worker_threads);
+    ~ParallelMuHash();
+
+    ParallelMuHash(const ParallelMuHash&) = delete;
+    ParallelMuHash& operator=(const ParallelMuHash&) = delete;
+
+    void Insert(const COutPoint& outpoint, const Coin& coin) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Remove(const COutPoint& outpoint, const Coin& coin) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Wait for all queued updates and multiply their combined result into muhash.
+    void Apply(MuHash3072& muhash) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Batch {
+        //! Serialized coins, back to back.
+        std::vector<unsigned char> data;
+        //! End offset of each coin in data, and whether it is removed rather than inserted.
+        std::vector<std::pair<size_t, bool>> ends;
+    };
+
+    void Add(const COutPoint& outpoint, const Coin& coin, bool remove) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Submit() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void WorkerThread(size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    Mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_idle_cv;
+    std::deque<Batch> m_queue GUARDED_BY(m_mutex);
+    //! Number of batches being processed by workers.
+    int m_busy GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    //! Partial results, one per worker (or a single one for the calling
+    //! thread). Each is only modified by its worker, and only read by Apply()
+    //! while all workers are idle.
+    std::vector<MuHash3072> m_partials;
+    //! Batch being filled by the calling thread.
+    Batch m_batch;
+    std::vector<std::thread> m_workers;
+};
+
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {}, int muhash_threads = 0);
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
@@ -103,6 +103,9 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+// Set in the ids of the listening sockets registered with epoll, to tell them apart from node ids
+static constexpr uint64_t EPOLL_LISTEN_SOCKET_ID{uint64_t{1} << 63};
+
 const std::string NET_MESSAGE_TYPE_OTHER = "*other*";
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
@@ -116,13 +119,58 @@ bool fListen = true;
 GlobalMutex g_maplocalhost_mutex;
 std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(g_maplocalhost_mutex);
 std::string strSubVersion;
+SendBufferPool g_send_buffer_pool;
+
+std::vector<unsigned char> SendBufferPool::Get() noexcept
+{
+    LOCK(m_mutex);
+    if (m_buffers.empty()) return {};
+    std::vector<unsigned char> buffer{std::move(m_buffers.back())};
+    m_buffers.pop_back();
+    return buffer;
+}
+
+void SendBufferPool::Put(std::vector<unsigned char> buffer) noexcept
+{
+    if (buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_SEND_BUFFER_SIZE) return;
+    buffer.clear();
+    LOCK(m_mutex);
+    // Never exceeds the capacity reserved in the constructor, so this does not allocate.
+    if (m_buffers.size() < MAX_POOLED_SEND_BUFFERS) m_buffers.push_back(std::move(buffer));
+}
+
+size_t SendBufferPool::Size() const noexcept
+{
+    return WITH_LOCK(m_mutex, return m_buffers.size());
+}
+
+void CSerializedNetMsg::Share()
+{
+    if (m_shared_data) return;
+    m_shared_data = std::shared_ptr<const std::vector<unsigned char>>{
+        new std::vector<unsigned char>(std::move(data)),
+        [](std::vector<unsigned char>* buffer) {
+            g_send_buffer_pool.Put(std::move(*buffer));
+            delete buffer;
+        }};
+    data = {};
+}
+
+void CSerializedNetMsg::Release() noexcept
+{
+    g_send_buffer_pool.Put(std::move(data));
+    data = {};
+    m_shared_data.reset();
+}
 
 size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
 {
     // Don't count the dynamic memory used for the m_type string, by assuming it fits in the
     // "small string" optimization area (which stores data inside the object itself, up to some
     // size; 15 bytes in modern libstdc++).
-    return sizeof(*this) + memusage::DynamicUsage(data);
+    // A shared payload is counted in full for every message that refers to it, as each of them
+    // keeps it alive until sent.
+    return sizeof(*this) + memusage::DynamicUsage(data) + (m_shared_data ? memusage::DynamicUsage(*m_shared_data) : 0);
 }
 
 void CConnman::AddAddrFetch(const std::string& strDest)
@@ -805,13 +853,13 @@ bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     AssertLockNotHeld(m_send_mutex);
     // Determine whether a new message can be set.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    if (m_sending_header || m_bytes_sent < m_message_to_send.Payload().size()) return false;
 
     // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    uint256 hash = Hash(msg.Payload());
 
     // create header
-    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.Payload().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -833,11 +881,11 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
         return {Span{m_header_to_send}.subspan(m_bytes_sent),
                 // We have more to send after the header if the message has payload, or if there
                 // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
+                have_next_message || !m_message_to_send.Payload().empty(),
                 m_message_to_send.m_type
                };
     } else {
-        return {Span{m_message_to_send.data}.subspan(m_bytes_sent),
+        return {m_message_to_send.Payload().subspan(m_bytes_sent),
                 // We only have more to send after this message's payload if there is another
                 // message.
                 have_next_message,
@@ -846,18 +894,30 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
     }
 }
 
+std::pair<Span<const uint8_t>, bool> V1Transport::GetFollowingBytesToSend(bool have_next_message) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    // While sending the header, the payload can be sent along with it.
+    if (m_sending_header) return {m_message_to_send.Payload(), have_next_message};
+    return {{}, have_next_message};
+}
+
 void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
     m_bytes_sent += bytes_sent;
-    if (m_sending_header && m_bytes_sent == m_header_to_send.size()) {
-        // We're done sending a message's header. Switch to sending its data bytes.
+    if (m_sending_header && m_bytes_sent >= m_header_to_send.size()) {
+        // We're done sending a message's header. Switch to sending its data bytes, some of which
+        // may have been sent along with it.
         m_sending_header = false;
-        m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
-        // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
-        ClearShrink(m_message_to_send.data);
+        m_bytes_sent -= m_header_to_send.size();
+    }
+    if (!m_sending_header && m_bytes_sent == m_message_to_send.Payload().size()) {
+        // We're done sending a message's data. Return its buffer to the pool (or drop our
+        // reference to a shared one) to reduce memory consumption.
+        m_message_to_send.Release();
         m_bytes_sent = 0;
     }
 }
@@ -1457,26 +1517,26 @@ bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
     // is available) and the send buffer is empty. This limits the number of messages in the send
     // buffer to just one, and leaves the responsibility for queueing them up to the caller.
     if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
-    // Construct contents (encoding message type + payload).
-    std::vector<uint8_t> contents;
+    // Encode the message type; the contents are that followed by the payload.
+    std::array<std::byte, 1 + CMessageHeader::COMMAND_SIZE> encoded_type{};
+    size_t encoded_type_len{1};
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
-        contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        encoded_type[0] = std::byte{*short_message_id};
     } else {
-        // Initialize with zeroes, and then write the message type string starting at offset 1.
-        // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::COMMAND_SIZE + msg.data.size(), 0);
-        std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::COMMAND_SIZE);
-    }
-    // Construct ciphertext in send buffer.
-    m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
-    m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(m_send_buffer));
+        // Write the message type string starting at offset 1. This means encoded_type[0] and the
+        // unused positions in encoded_type[1..13] remain 0x00.
+        std::transform(msg.m_type.begin(), msg.m_type.end(), encoded_type.begin() + 1, [](char c) { return std::byte(c); });
+        encoded_type_len += CMessageHeader::COMMAND_SIZE;
+    }
+    // Construct ciphertext in a pooled send buffer, encrypting straight from the payload.
+    const auto payload{MakeByteSpan(msg.Payload())};
+    m_send_buffer = g_send_buffer_pool.Get();
+    m_send_buffer.resize(encoded_type_len + payload.size() + BIP324Cipher::EXPANSION);
+    m_cipher.Encrypt(Span{encoded_type}.first(encoded_type_len), payload, {}, false, MakeWritableByteSpan(m_send_buffer));
     m_send_type = msg.m_type;
     // Release memory
-    ClearShrink(msg.data);
+    msg.Release();
     return true;
 }
 
@@ -1497,6 +1557,15 @@ Transport::BytesToSend V2Transport::GetBytesToSend(bool have_next_message) const
     };
 }
 
+std::pair<Span<const uint8_t>, bool> V2Transport::GetFollowingBytesToSend(bool have_next_message) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    if (m_send_state == SendState::V1) return m_v1_fallback.GetFollowingBytesToSend(have_next_message);
+    // All bytes to send are in m_send_buffer.
+    return {{}, have_next_message && m_send_state == SendState::READY};
+}
+
 void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -1512,10 +1581,11 @@ void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
     if (m_send_pos >= CMessageHeader::HEADER_SIZE) {
         m_sent_v1_header_worth = true;
     }
-    // Wipe the buffer when everything is sent.
+    // Return the buffer to the pool when everything is sent.
     if (m_send_pos == m_send_buffer.size()) {
         m_send_pos = 0;
-        ClearShrink(m_send_buffer);
+        g_send_buffer_pool.Put(std::move(m_send_buffer));
+        m_send_buffer = {};
     }
 }
 
@@ -1585,7 +1655,12 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 ++it;
             }
         }
-        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(it != node.vSendMsg.end());
+        const bool have_next_message{it != node.vSendMsg.end()};
+        const auto& [data, data_more, msg_type] = node.m_transport->GetBytesToSend(have_next_message);
+        // Bytes that directly follow data (such as a V1 message's payload after its header) are
+        // sent along with it, in a single scatter-gather call.
+        const auto [following, following_more] = data.empty() ? std::pair<Span<const uint8_t>, bool>{} : node.m_transport->GetFollowingBytesToSend(have_next_message);
+        const bool more{following.empty() ? data_more : following_more};
         // We rely on the 'more' value returned by GetBytesToSend to correctly predict whether more
         // bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
         // verify that the previously returned 'more' was correct.
@@ -1607,7 +1682,12 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 flags |= MSG_MORE;
             }
 #endif
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()), data.size(), flags);
+            if (following.empty()) {
+                nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()), data.size(), flags);
+            } else {
+                const Span<const uint8_t> chunks[]{data, following};
+                nBytes = node.m_sock->SendMany(chunks, flags);
+            }
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
@@ -1619,7 +1699,7 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 node.AccountForSentBytes(msg_type, nBytes);
             }
             nSentSize += nBytes;
-            if ((size_t)nBytes != data.size()) {
+            if ((size_t)nBytes != data.size() + following.size()) {
                 // could not send full message; stop sending more
                 break;
             }
@@ -2001,6 +2081,37 @@ bool CConnman::InactivityCheck(const CNode& node) const
     return false;
 }
 
+std::optional<SocketEventsMode> SocketEventsModeFromString(const std::string& str)
+{
+    if (str == SocketEventsModeToString(SocketEventsMode::WAIT_MANY)) return SocketEventsMode::WAIT_MANY;
+#ifdef USE_EPOLL
+    if (str == SocketEventsModeToString(SocketEventsMode::EPOLL)) return SocketEventsMode::EPOLL;
+#endif
+    return std::nullopt;
+}
+
+std::string SocketEventsModeToString(SocketEventsMode mode)
+{
+    switch (mode) {
+#ifdef USE_POLL
+    case SocketEventsMode::WAIT_MANY: return "poll";
+#else
+    case SocketEventsMode::WAIT_MANY: return "select";
+#endif
+    case SocketEventsMode::EPOLL: return "epoll";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+std::string GetSupportedSocketEventsModes()
+{
+    std::string modes{SocketEventsModeToString(SocketEventsMode::WAIT_MANY)};
+#ifdef USE_EPOLL
+    modes += ", " + SocketEventsModeToString(SocketEventsMode::EPOLL);
+#endif
+    return modes;
+}
+
 Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
 {
     Sock::EventsPerSock events_per_sock;
@@ -2036,6 +2147,10 @@ void CConnman::SocketHandler()
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
+#ifdef USE_EPOLL
+    if (m_epoll) return SocketHandlerEpoll();
+#endif
+
     Sock::EventsPerSock events_per_sock;
 
     {
@@ -2060,6 +2175,71 @@ void CConnman::SocketHandler()
     SocketHandlerListening(events_per_sock);
 }
 
+#ifdef USE_EPOLL
+void CConnman::SocketHandlerEpoll()
+{
+    AssertLockNotHeld(m_total_bytes_sent_mutex);
+
+    Sock::EventsPerSock listen_events;
+
+    {
+        const NodesSnapshot snap{*this, /*shuffle=*/false};
+
+        // Register the sockets of new nodes. A registered socket is reported
+        // once per readiness change, so its readiness is remembered in
+        // m_sock_events_ready until a recv or send on it would block. Don't
+        // wait if that is already known to be possible for some node.
+        bool ready{false};
+        for (CNode* pnode : snap.Nodes()) {
+            if (!pnode->m_sock_registered) {
+                LOCK(pnode->m_sock_mutex);
+                if (!pnode->m_sock) continue;
+                if (!m_epoll->Add(*pnode->m_sock, Sock::RECV | Sock::SEND, pnode->GetId(), /*edge_triggered=*/true)) {
+                    LogPrint(BCLog::NET, "failed to register socket for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(WSAGetLastError()));
+                    pnode->fDisconnect = true;
+                    continue;
+                }
+                pnode->m_sock_registered = true;
+                pnode->m_sock_events_ready = Sock::RECV | Sock::SEND;
+            }
+            if ((pnode->m_sock_events_ready & (Sock::RECV | Sock::ERR)) && !pnode->fPauseRecv) ready = true;
+        }
+
+        const auto timeout = ready ? 0ms : std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
+        if (!m_epoll->Wait(timeout, snap.Nodes().size() + vhListenSocket.size(), m_epoll_events)) {
+            interruptNet.sleep_for(timeout);
+        }
+
+        std::unordered_map<NodeId, Sock::Event> node_events;
+        for (const auto& [id, occurred] : m_epoll_events) {
+            if (id & EPOLL_LISTEN_SOCKET_ID) {
+                const size_t i{static_cast<size_t>(id & ~EPOLL_LISTEN_SOCKET_ID)};
+                if (i < vhListenSocket.size()) {
+                    listen_events.emplace(vhListenSocket[i].sock, Sock::Events{Sock::RECV}).first->second.occurred = occurred;
+                }
+            } else {
+                // Events of nodes that were deleted in the meantime are ignored.
+                node_events[static_cast<NodeId>(id)] |= occurred;
+            }
+        }
+
+        for (CNode* pnode : snap.Nodes()) {
+            if (interruptNet) return;
+
+            if (!node_events.empty()) {
+                const auto it{node_events.find(pnode->GetId())};
+                if (it != node_events.end()) pnode->m_sock_events_ready |= it->second;
+            }
+            Sock::Event occurred{pnode->m_sock_events_ready};
+            if (pnode->fPauseRecv) occurred &= ~(Sock::RECV | Sock::ERR);
+            pnode->m_sock_events_ready &= ~SocketHandlerNode(*pnode, occurred);
+        }
+    }
+
+    SocketHandlerListening(listen_events);
+}
+#endif // USE_EPOLL
+
 void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                                       const Sock::EventsPerSock& events_per_sock)
 {
@@ -2069,12 +2249,7 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
         if (interruptNet)
             return;
 
-        //
-        // Receive
-        //
-        bool recvSet = false;
-        bool sendSet = false;
-        bool errorSet = false;
+        Sock::Event occurred{0};
         {
             LOCK(pnode->m_sock_mutex);
             if (!pnode->m_sock) {
@@ -2082,77 +2257,98 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
             }
             const auto it = events_per_sock.find(pnode->m_sock);
             if (it != events_per_sock.end()) {
-                recvSet = it->second.occurred & Sock::RECV;
-                sendSet = it->second.occurred & Sock::SEND;
-                errorSet = it->second.occurred & Sock::ERR;
+                occurred = it->second.occurred;
             }
         }
+        SocketHandlerNode(*pnode, occurred);
+    }
+}
 
-        if (sendSet) {
-            // Send data
-            auto [bytes_sent, data_left] = WITH_LOCK(pnode->cs_vSend, return SocketSendData(*pnode));
-            if (bytes_sent) {
-                RecordBytesSent(bytes_sent);
+Sock::Event CConnman::SocketHandlerNode(CNode& node, Sock::Event occurred)
+{
+    AssertLockNotHeld(m_total_bytes_sent_mutex);
 
-                // If both receiving and (non-optimistic) sending were possible, we first attempt
-                // sending. If that succeeds, but does not fully drain the send queue, do not
-                // attempt to receive. This avoids needlessly queueing data if the remote peer
-                // is slow at receiving data, by means of TCP flow control. We only do this when
-                // sending actually succeeded to make sure progress is always made; otherwise a
-                // deadlock would be possible when both sides have data to send, but neither is
-                // receiving.
-                if (data_left) recvSet = false;
-            }
+    Sock::Event used_up{0};
+
+    //
+    // Receive
+    //
+    bool recvSet = occurred & Sock::RECV;
+    bool sendSet = occurred & Sock::SEND;
+    bool errorSet = occurred & Sock::ERR;
+
+    if (sendSet) {
+        // Send data
+        auto [bytes_sent, data_left] = WITH_LOCK(node.cs_vSend, return SocketSendData(node));
+        // Unsent data is left only if the socket's send buffer is full.
+        if (data_left) used_up |= Sock::SEND;
+        if (bytes_sent) {
+            RecordBytesSent(bytes_sent);
+
+            // If both receiving and (non-optimistic) sending were possible, we first attempt
+            // sending. If that succeeds, but does not fully drain the send queue, do not
+            // attempt to receive. This avoids needlessly queueing data if the remote peer
+            // is slow at receiving data, by means of TCP flow control. We only do this when
+            // sending actually succeeded to make sure progress is always made; otherwise a
+            // deadlock would be possible when both sides have data to send, but neither is
+            // receiving.
+            if (data_left) recvSet = false;
         }
+    }
 
-        if (recvSet || errorSet)
+    if (recvSet || errorSet)
+    {
+        // typical socket buffer is 8K-64K
+        uint8_t pchBuf[0x10000];
+        int nBytes = 0;
         {
-            // typical socket buffer is 8K-64K
-            uint8_t pchBuf[0x10000];
-            int nBytes = 0;
-            {
-                LOCK(pnode->m_sock_mutex);
-                if (!pnode->m_sock) {
-                    continue;
-                }
-                nBytes = pnode->m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+            LOCK(node.m_sock_mutex);
+            if (!node.m_sock) {
+                return used_up;
             }
-            if (nBytes > 0)
-            {
-                bool notify = false;
-                if (!pnode->ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
-                    pnode->CloseSocketDisconnect();
-                }
-                RecordBytesRecv(nBytes);
-                if (notify) {
-                    pnode->MarkReceivedMsgsForProcessing();
-                    WakeMessageHandler();
-                }
+            nBytes = node.m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+        }
+        // A short read means that the socket's receive buffer was emptied. An
+        // error or hangup stays reported until recv itself reports it.
+        if (nBytes < (int)sizeof(pchBuf)) used_up |= Sock::RECV;
+        if (nBytes <= 0) used_up |= Sock::ERR;
+        if (nBytes > 0)
+        {
+            bool notify = false;
+            if (!node.ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
+                node.CloseSocketDisconnect();
             }
-            else if (nBytes == 0)
-            {
-                // socket closed gracefully
-                if (!pnode->fDisconnect) {
-                    LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
-                }
-                pnode->CloseSocketDisconnect();
+            RecordBytesRecv(nBytes);
+            if (notify) {
+                node.MarkReceivedMsgsForProcessing();
+                WakeMessageHandler(node.GetId());
             }
-            else if (nBytes < 0)
+        }
+        else if (nBytes == 0)
+        {
+            // socket closed gracefully
+            if (!node.fDisconnect) {
+                LogPrint(BCLog::NET, "socket closed for peer=%d\n", node.GetId());
+            }
+            node.CloseSocketDisconnect();
+        }
+        else if (nBytes < 0)
+        {
+            // error
+            int nErr = WSAGetLastError();
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
             {
-                // error
-                int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
-                    }
-                    pnode->CloseSocketDisconnect();
+                if (!node.fDisconnect) {
+                    LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", node.GetId(), NetworkErrorString(nErr));
                 }
+                node.CloseSocketDisconnect();
             }
         }
-
-        if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
     }
+
+    if (InactivityCheck(node)) node.fDisconnect = true;
+
+    return used_up;
 }
 
 void CConnman::SocketHandlerListening(const Sock::EventsPerSock& events_per_sock)
@@ -2184,9 +2380,19 @@ void CConnman::WakeMessageHandler()
 {
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        std::fill(m_msghand_wake.begin(), m_msghand_wake.end(), true);
+    }
+    condMsgProc.notify_all();
+}
+
+void CConnman::WakeMessageHandler(NodeId id)
+{
+    {
+        LOCK(mutexMsgProc);
+        m_msghand_wake[MessageHandlerFor(id)] = true;
     }
-    condMsgProc.notify_one();
+    // All threads wait on the same condition variable.
+    condMsgProc.notify_all();
 }
 
 void CConnman::ThreadDNSAddressSeed()
@@ -2891,10 +3097,8 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
 
 Mutex NetEventsInterface::g_msgproc_mutex;
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(size_t worker)
 {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
     while (!flagInterruptMsgProc)
     {
         bool fMoreWork = false;
@@ -2906,9 +3110,13 @@ void CConnman::ThreadMessageHandler()
             const NodesSnapshot snap{*this, /*shuffle=*/true};
 
             for (CNode* pnode : snap.Nodes()) {
+                if (MessageHandlerFor(pnode->GetId()) != worker)
+                    continue;
                 if (pnode->fDisconnect)
                     continue;
 
+                LOCK(NetEventsInterface::g_msgproc_mutex);
+
                 // Receive messages
                 bool fMoreNodeWork = m_msgproc->ProcessMessages(pnode, flagInterruptMsgProc);
                 fMoreWork |= (fMoreNodeWork && !pnode->fPauseSend);
@@ -2924,9 +3132,9 @@ void CConnman::ThreadMessageHandler()
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this, worker]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return m_msghand_wake[worker]; });
         }
-        fMsgProcWake = false;
+        m_msghand_wake[worker] = false;
     }
 }
 
@@ -3226,6 +3434,25 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         semAddnode = std::make_unique<CSemaphore>(nMaxAddnode);
     }
 
+#ifdef USE_EPOLL
+    if (m_socket_events_mode == SocketEventsMode::EPOLL) {
+        m_epoll = std::make_unique<SockEpoll>();
+        if (!m_epoll->IsValid()) {
+            LogPrintf("Warning: failed to create epoll instance (%s), using %s instead\n",
+                      NetworkErrorString(WSAGetLastError()), SocketEventsModeToString(SocketEventsMode::WAIT_MANY));
+            m_epoll.reset();
+        }
+        for (size_t i = 0; m_epoll && i < vhListenSocket.size(); ++i) {
+            // Level-triggered, as only one connection is accepted per iteration.
+            if (!m_epoll->Add(*vhListenSocket[i].sock, Sock::RECV, EPOLL_LISTEN_SOCKET_ID | i, /*edge_triggered=*/false)) {
+                LogPrintf("Warning: failed to register listening socket with epoll (%s), using %s instead\n",
+                          NetworkErrorString(WSAGetLastError()), SocketEventsModeToString(SocketEventsMode::WAIT_MANY));
+                m_epoll.reset();
+            }
+        }
+    }
+#endif
+
     //
     // Start threads
     //
@@ -3234,11 +3461,6 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     interruptNet.reset();
     flagInterruptMsgProc = false;
 
-    {
-        LOCK(mutexMsgProc);
-        fMsgProcWake = false;
-    }
-
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
 
@@ -3265,7 +3487,10 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Process messages
-    threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    for (int i = 0; i < m_num_msghand_threads; ++i) {
+        const std::string name{m_num_msghand_threads == 1 ? "msghand" : strprintf("msghand.%i", i)};
+        m_msghand_threads.emplace_back(&util::TraceThread, name, [this, i] { ThreadMessageHandler(i); });
+    }
 
     if (m_i2p_sam_session) {
         threadI2PAcceptIncoming =
@@ -3322,8 +3547,10 @@ void CConnman::StopThreads()
     if (threadI2PAcceptIncoming.joinable()) {
         threadI2PAcceptIncoming.join();
     }
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (std::thread& thread : m_msghand_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    m_msghand_threads.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -3363,6 +3590,9 @@ void CConnman::StopNodes()
     }
     m_nodes_disconnected.clear();
     vhListenSocket.clear();
+#ifdef USE_EPOLL
+    m_epoll.reset();
+#endif
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -3720,7 +3950,18 @@ std::optional<std::pair<CNetMessage, bool>> CNode::PollMessage()
 {
     LOCK(m_msg_process_queue_mutex);
     if (m_msg_process_queue.empty()) return std::nullopt;
+    return PopMessage();
+}
 
+std::optional<std::pair<CNetMessage, bool>> CNode::PollMessageOfType(std::string_view msg_type)
+{
+    LOCK(m_msg_process_queue_mutex);
+    if (m_msg_process_queue.empty() || m_msg_process_queue.front().m_type != msg_type) return std::nullopt;
+    return PopMessage();
+}
+
+std::pair<CNetMessage, bool> CNode::PopMessage()
+{
     std::list<CNetMessage> msgs;
     // Just take one message
     msgs.splice(msgs.begin(), m_msg_process_queue, m_msg_process_queue.begin());
@@ -3738,10 +3979,11 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
-    size_t nMessageSize = msg.data.size();
+    const auto payload{msg.Payload()};
+    size_t nMessageSize = payload.size();
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type, nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /*is_incoming=*/false);
+        CaptureMessage(pnode->addr, msg.m_type, payload, /*is_incoming=*/false);
     }
 
     TRACE6(net, outbound_message,
@@ -3749,8 +3991,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->m_addr_name.c_str(),
         pnode->ConnectionTypeAsString().c_str(),
         msg.m_type.c_str(),
-        msg.data.size(),
-        msg.data.data()
+        payload.size(),
+        payload.data()
     );
 
     size_t nBytesSent = 0;
@@ -31,6 +31,7 @@
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -96,6 +97,34 @@ static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
 static constexpr bool DEFAULT_V2_TRANSPORT{false};
 
+/** Default number of message handler threads, see -msghandthreads. */
+static constexpr int DEFAULT_MESSAGE_HANDLER_THREADS{4};
+/** Maximum number of message handler threads. */
+static constexpr int MAX_MESSAGE_HANDLER_THREADS{16};
+/** Maximum number of idle send buffers kept in the SendBufferPool. */
+static constexpr size_t MAX_POOLED_SEND_BUFFERS{128};
+/** Buffers with a larger capacity are freed instead of returned to the SendBufferPool. */
+static constexpr size_t MAX_POOLED_SEND_BUFFER_SIZE{64 * 1024};
+
+/** How the socket handler thread waits for network activity. */
+enum class SocketEventsMode {
+    //! Pass all sockets to Sock::WaitMany() (poll(2) or select(2)) on every iteration.
+    WAIT_MANY,
+    //! Keep the sockets registered with epoll(7), edge-triggered.
+    EPOLL,
+};
+#ifdef USE_EPOLL
+static constexpr SocketEventsMode DEFAULT_SOCKET_EVENTS{SocketEventsMode::EPOLL};
+#else
+static constexpr SocketEventsMode DEFAULT_SOCKET_EVENTS{SocketEventsMode::WAIT_MANY};
+#endif
+
+/** Parse a -socketevents value, std::nullopt if it is not supported on this platform. */
+std::optional<SocketEventsMode> SocketEventsModeFromString(const std::string& str);
+std::string SocketEventsModeToString(SocketEventsMode mode);
+/** Comma-separated names of the -socketevents modes supported on this platform. */
+std::string GetSupportedSocketEventsModes();
+
 typedef int64_t NodeId;
 
 struct AddedNodeParams {
@@ -113,6 +142,32 @@ struct AddedNodeInfo {
 class CNodeStats;
 class CClientUIInterface;
 
+/**
+ * Recycles the buffers that messages are serialized into and that the transports send from, so
+ * that the send path does not need a fresh allocation per message. At most
+ * MAX_POOLED_SEND_BUFFERS buffers of up to MAX_POOLED_SEND_BUFFER_SIZE bytes are kept.
+ */
+class SendBufferPool
+{
+public:
+    SendBufferPool() { m_buffers.reserve(MAX_POOLED_SEND_BUFFERS); }
+
+    /** Get an empty buffer, with some capacity if a previously used one is available. */
+    std::vector<unsigned char> Get() noexcept EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Return a buffer that is no longer needed (or free it, if the pool is full or it is too large). */
+    void Put(std::vector<unsigned char> buffer) noexcept EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of idle buffers in the pool. */
+    size_t Size() const noexcept EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    mutable Mutex m_mutex;
+    std::vector<std::vector<unsigned char>> m_buffers GUARDED_BY(m_mutex);
+};
+
+extern SendBufferPool g_send_buffer_pool;
+
 struct CSerializedNetMsg {
     CSerializedNetMsg() = default;
     CSerializedNetMsg(CSerializedNetMsg&&) = default;
@@ -121,16 +176,32 @@ struct CSerializedNetMsg {
     CSerializedNetMsg(const CSerializedNetMsg& msg) = delete;
     CSerializedNetMsg& operator=(const CSerializedNetMsg&) = delete;
 
+    /** Copy this message. A shared payload (see Share()) is not copied, but shared by the copy. */
     CSerializedNetMsg Copy() const
     {
         CSerializedNetMsg copy;
         copy.data = data;
         copy.m_type = m_type;
+        copy.m_shared_data = m_shared_data;
         return copy;
     }
 
+    /** The payload: m_shared_data if set, data otherwise. */
+    Span<const unsigned char> Payload() const noexcept
+    {
+        return m_shared_data ? Span<const unsigned char>{*m_shared_data} : Span<const unsigned char>{data};
+    }
+
+    /** Turn data into a shared payload, for a message that is sent to several peers. */
+    void Share();
+
+    /** Drop the payload, returning data to the send buffer pool. */
+    void Release() noexcept;
+
     std::vector<unsigned char> data;
     std::string m_type;
+    /** Immutable payload that is shared by the copies of this message; takes precedence over data. */
+    std::shared_ptr<const std::vector<unsigned char>> m_shared_data;
 
     /** Compute total memory usage of this object (own memory + any dynamic memory). */
     size_t GetMemoryUsage() const noexcept;
@@ -352,9 +423,20 @@ public:
      */
     virtual BytesToSend GetBytesToSend(bool have_next_message) const noexcept = 0;
 
+    /** Get bytes that directly follow the to_send bytes of GetBytesToSend(), so that both can be
+     *  handed to a single scatter-gather send call (for V1Transport: the payload of the message
+     *  whose header is being sent).
+     *
+     * @param[in] have_next_message See GetBytesToSend().
+     * @return the following bytes (possibly empty), and the "more" value of GetBytesToSend() for
+     *         what comes after them.
+     */
+    virtual std::pair<Span<const uint8_t>, bool> GetFollowingBytesToSend(bool have_next_message) const noexcept = 0;
+
     /** Report how many bytes returned by the last GetBytesToSend() have been sent.
      *
-     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result.
+     * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result, plus the size
+     * of the bytes returned by GetFollowingBytesToSend().
      *
      * If bytes_sent=0, this call has no effect.
      */
@@ -415,7 +497,7 @@ private:
     CSerializedNetMsg m_message_to_send GUARDED_BY(m_send_mutex);
     /** Whether we're currently sending header bytes or message bytes. */
     bool m_sending_header GUARDED_BY(m_send_mutex) {false};
-    /** How many bytes have been sent so far (from m_header_to_send, or from m_message_to_send.data). */
+    /** How many bytes have been sent so far (from m_header_to_send, or from m_message_to_send's payload). */
     size_t m_bytes_sent GUARDED_BY(m_send_mutex) {0};
 
 public:
@@ -446,6 +528,7 @@ public:
 
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    std::pair<Span<const uint8_t>, bool> GetFollowingBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     bool ShouldReconnectV1() const noexcept override { return false; }
@@ -662,6 +745,7 @@ public:
     // Send side functions.
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    std::pair<Span<const uint8_t>, bool> GetFollowingBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
 
@@ -748,6 +832,15 @@ public:
     std::atomic_bool fPauseRecv{false};
     std::atomic_bool fPauseSend{false};
 
+    /**
+     * Readiness of the socket reported by the edge-triggered socket event loop
+     * that has not been used up yet (a recv or send did not block since), and
+     * whether the socket is registered with it. Only accessed by the socket
+     * handler thread.
+     */
+    Sock::Event m_sock_events_ready{0};
+    bool m_sock_registered{false};
+
     const ConnectionType m_conn_type;
 
     /** Move all messages from the received queue to the processing queue. */
@@ -762,6 +855,10 @@ public:
     std::optional<std::pair<CNetMessage, bool>> PollMessage()
         EXCLUSIVE_LOCKS_REQUIRED(!m_msg_process_queue_mutex);
 
+    /** Like PollMessage(), but only poll the next message if it is of type msg_type. */
+    std::optional<std::pair<CNetMessage, bool>> PollMessageOfType(std::string_view msg_type)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_msg_process_queue_mutex);
+
     /** Account for the total size of a sent message in the per msg type connection stats. */
     void AccountForSentBytes(const std::string& msg_type, size_t sent_bytes)
         EXCLUSIVE_LOCKS_REQUIRED(cs_vSend)
@@ -977,6 +1074,9 @@ private:
     std::list<CNetMessage> m_msg_process_queue GUARDED_BY(m_msg_process_queue_mutex);
     size_t m_msg_process_queue_size GUARDED_BY(m_msg_process_queue_mutex){0};
 
+    /** Take the first message of the non-empty processing queue. */
+    std::pair<CNetMessage, bool> PopMessage() EXCLUSIVE_LOCKS_REQUIRED(m_msg_process_queue_mutex);
+
     // Our address, as reported by the peer
     CService addrLocal GUARDED_BY(m_addr_local_mutex);
     mutable Mutex m_addr_local_mutex;
@@ -1069,9 +1169,11 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         bool m_i2p_accept_incoming;
+        SocketEventsMode m_socket_events_mode = DEFAULT_SOCKET_EVENTS;
+        int m_num_msghand_threads = 1;
     };
 
-    void Init(const Options& connOptions) EXCLUSIVE_LOCKS_REQUIRED(!m_added_nodes_mutex, !m_total_bytes_sent_mutex)
+    void Init(const Options& connOptions) EXCLUSIVE_LOCKS_REQUIRED(!m_added_nodes_mutex, !m_total_bytes_sent_mutex, !mutexMsgProc)
     {
         AssertLockNotHeld(m_total_bytes_sent_mutex);
 
@@ -1103,6 +1205,12 @@ public:
             }
         }
         m_onion_binds = connOptions.onion_binds;
+        m_socket_events_mode = connOptions.m_socket_events_mode;
+        m_num_msghand_threads = std::clamp(connOptions.m_num_msghand_threads, 1, MAX_MESSAGE_HANDLER_THREADS);
+        {
+            LOCK(mutexMsgProc);
+            m_msghand_wake.assign(m_num_msghand_threads, false);
+        }
     }
 
     CConnman(uint64_t seed0, uint64_t seed1, AddrMan& addrman, const NetGroupManager& netgroupman,
@@ -1242,7 +1350,10 @@ public:
     /** Get a unique deterministic randomizer. */
     CSipHasher GetDeterministicRandomizer(uint64_t id) const;
 
+    /** Wake all message handler threads. */
     void WakeMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /** Wake the message handler thread that processes the messages of the given node. */
+    void WakeMessageHandler(NodeId id) EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
 
     /** Return true if we should disconnect the peer for failing an inactivity check. */
     bool ShouldRunInactivityChecks(const CNode& node, std::chrono::seconds now) const;
@@ -1275,7 +1386,15 @@ private:
     void AddAddrFetch(const std::string& strDest) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex);
     void ProcessAddrFetch() EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_unused_i2p_sessions_mutex);
     void ThreadOpenConnections(std::vector<std::string> connect) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex, !m_unused_i2p_sessions_mutex, !m_reconnections_mutex);
-    void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /**
+     * Process messages of the nodes assigned to message handler thread `worker`.
+     * Each node is assigned to one thread (see MessageHandlerFor()), so its
+     * messages are processed in order. NetEventsInterface::g_msgproc_mutex is
+     * held while processing a node, so the threads only run in parallel while
+     * message processing releases it (e.g. during block validation).
+     */
+    void ThreadMessageHandler(size_t worker) EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    size_t MessageHandlerFor(NodeId id) const { return static_cast<size_t>(id) % m_num_msghand_threads; }
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket& hListenSocket);
 
@@ -1309,6 +1428,13 @@ private:
      */
     void SocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
 
+#ifdef USE_EPOLL
+    /**
+     * Same as SocketHandler(), but with the sockets kept registered with m_epoll.
+     */
+    void SocketHandlerEpoll() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
+#endif
+
     /**
      * Do the read/write for connected sockets that are ready for IO.
      * @param[in] nodes Nodes to process. The socket of each node is checked against `what`.
@@ -1318,6 +1444,15 @@ private:
                                 const Sock::EventsPerSock& events_per_sock)
         EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
 
+    /**
+     * Send and receive on a connected socket.
+     * @param[in] node The node to process.
+     * @param[in] occurred Events that occurred on the node's socket.
+     * @return the events that were used up, i.e. for which a send or recv would now block
+     */
+    Sock::Event SocketHandlerNode(CNode& node, Sock::Event occurred)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
+
     /**
      * Accept incoming connections, one from each read-ready listening socket.
      * @param[in] events_per_sock Sockets that are ready for IO.
@@ -1406,6 +1541,19 @@ private:
     unsigned int nReceiveFloodSize{0};
 
     std::vector<ListenSocket> vhListenSocket;
+
+    SocketEventsMode m_socket_events_mode{DEFAULT_SOCKET_EVENTS};
+#ifdef USE_EPOLL
+    /**
+     * Sockets of the listening sockets and connected nodes, if m_socket_events_mode
+     * is EPOLL. Nodes are registered by the socket handler thread on its first
+     * iteration after they were added, and dropped when their socket is closed.
+     */
+    std::unique_ptr<SockEpoll> m_epoll;
+    //! Buffer for the events returned by m_epoll, only used by the socket handler thread.
+    std::vector<SockEpoll::Event> m_epoll_events;
+#endif
+
     std::atomic<bool> fNetworkActive{true};
     bool fAddressesInitialized{false};
     AddrMan& addrman;
@@ -1494,8 +1642,9 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    /** flag for waking each of the message handler threads. */
+    std::vector<bool> m_msghand_wake GUARDED_BY(mutexMsgProc){false};
+    int m_num_msghand_threads{1};
 
     std::condition_variable condMsgProc;
     Mutex mutexMsgProc;
@@ -1520,7 +1669,7 @@ private:
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> m_msghand_threads;
     std::thread threadI2PAcceptIncoming;
 
     /** flag for deciding to connect to an extra outbound peer,
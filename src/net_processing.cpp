@@ -10,6 +10,7 @@
 #include <blockencodings.h>
 #include <blockfilter.h>
 #include <chainparams.h>
+#include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
@@ -22,6 +23,8 @@
 #include <merkleblock.h>
 #include <netbase.h>
 #include <netmessagemaker.h>
+#include <node/blockcache.h>
+#include <node/blockdownload.h>
 #include <node/blockstorage.h>
 #include <node/txreconciliation.h>
 #include <policy/fees.h>
@@ -47,7 +50,6 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <future>
 #include <memory>
 #include <optional>
 #include <typeinfo>
@@ -102,8 +104,15 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY{2s};
 static constexpr auto GETDATA_TX_INTERVAL{60s};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer, until its block
+ *  download window is sized by how fast it delivers them (see node::BlockDownloadStats). */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** How long the block validation is waiting for must have been in flight before it is also requested
+ *  from a faster peer, and how much faster that peer must be than the ones it is in flight from. */
+static constexpr auto BLOCK_REREQUEST_MIN_WAIT{1s};
+static constexpr int BLOCK_REREQUEST_MIN_SPEEDUP{2};
+/** Maximum number of peers a block is requested from in parallel by the block download scheduler */
+static constexpr size_t MAX_BLOCK_DOWNLOADS_PER_BLOCK{2};
 /** Default time during which a peer must stall block download progress before being disconnected.
  * the actual timeout is increased temporarily if peers are disconnected for hitting the timeout */
 static constexpr auto BLOCK_STALLING_TIMEOUT_DEFAULT{2s};
@@ -184,6 +193,8 @@ struct QueuedBlock {
     const CBlockIndex* pindex;
     /** Optional, used for CMPCTBLOCK downloads */
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
+    /** When the block was requested */
+    std::chrono::microseconds m_time_requested;
 };
 
 /**
@@ -423,6 +434,10 @@ struct CNodeState {
     std::list<QueuedBlock> vBlocksInFlight;
     //! When the first entry in vBlocksInFlight started downloading. Don't care when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
+    //! How fast this peer delivers the blocks we request
+    node::BlockDownloadStats m_block_download;
+    //! Number of blocks to keep in flight from this peer, set from m_block_download
+    int m_block_download_window{MAX_BLOCKS_IN_TRANSIT_PER_PEER};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload{false};
     /** Whether this peer wants invs or cmpctblocks (when possible) for block announcements. */
@@ -587,6 +602,27 @@ private:
     bool ProcessOrphanTx(Peer& peer)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex);
 
+    /** Deserialize the transaction of a TX message from pfrom, unless transactions from this
+     *  peer are not accepted at the moment.
+     *  @return the transaction, or nullptr if it has to be ignored. */
+    CTransactionRef ReadIncomingTx(CNode& pfrom, Peer& peer, CDataStream& vRecv)
+        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+
+    /** Update the download state for a transaction received from pfrom, and check whether
+     *  it still has to be submitted to the mempool. */
+    bool ShouldValidateTx(CNode& pfrom, const CTransaction& tx)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, !m_peer_mutex, !m_recent_confirmed_transactions_mutex);
+
+    /** Relay, store as orphan or reject a transaction received from pfrom, depending on the
+     *  result of submitting it to the mempool. */
+    void ProcessTxValidationResult(CNode& pfrom, Peer& peer, const CTransactionRef& ptx, const MempoolAcceptResult& result)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, !m_peer_mutex, !m_recent_confirmed_transactions_mutex, g_msgproc_mutex);
+
+    /** Process consecutive TX messages from pfrom together, so that the scripts of all
+     *  transactions are verified in parallel. Same as calling ProcessMessage() for each. */
+    void ProcessTxMessages(CNode& pfrom, Peer& peer, std::vector<CNetMessage>& msgs)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, g_msgproc_mutex);
+
     /** Process a single headers message from a peer.
      *
      * @param[in]   pfrom     CNode of the peer
@@ -663,10 +699,10 @@ private:
 
     void SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlock& block, const BlockTransactionsRequest& req);
 
-    /** Register with TxRequestTracker that an INV has been received from a
-     *  peer. The announcement parameters are decided in PeerManager and then
-     *  passed to TxRequestTracker. */
-    void AddTxAnnouncement(const CNode& node, const GenTxid& gtxid, std::chrono::microseconds current_time)
+    /** Register with TxRequestTracker that the transactions in an INV have
+     *  been announced by a peer. The announcement parameters are decided in
+     *  PeerManager and then passed to TxRequestTracker. */
+    void AddTxAnnouncements(const CNode& node, Span<const GenTxid> gtxids, std::chrono::microseconds current_time)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     /** Send a version message to a peer */
@@ -847,6 +883,8 @@ private:
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> m_most_recent_compact_block GUARDED_BY(m_most_recent_block_mutex);
     uint256 m_most_recent_block_hash GUARDED_BY(m_most_recent_block_mutex);
     std::unique_ptr<const std::map<uint256, CTransactionRef>> m_most_recent_block_txs GUARDED_BY(m_most_recent_block_mutex);
+    /** Messages about m_most_recent_block by message type (see GetMostRecentBlockMsg()), made on first use. */
+    std::map<std::string, CSerializedNetMsg> m_most_recent_block_msgs GUARDED_BY(m_most_recent_block_mutex);
 
     // Data about the low-work headers synchronization, aggregated from all peers' HeadersSyncStates.
     /** Mutex guarding the other m_headers_presync_* variables. */
@@ -890,12 +928,20 @@ private:
      */
     bool BlockRequested(NodeId nodeid, const CBlockIndex& block, std::list<QueuedBlock>::iterator** pit = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Update the block download statistics of a peer that sent us a block of `size` bytes, if we
+     *  requested it from that peer. Call before the request is removed. */
+    void BlockDownloaded(NodeId nodeid, const uint256& hash, size_t size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Whether to request `block`, which validation is waiting for and which is in flight from other
+     *  peers, from this peer too, because it is expected to deliver the block well before them. */
+    bool ShouldRequestBlockingBlock(const CNodeState& state, const CBlockIndex& block, std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     bool TipMayBeStale() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
      *  at most count entries.
      */
-    void FindNextBlocksToDownload(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void FindNextBlocksToDownload(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex*& blocking) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /** Request blocks for the background chainstate, if one is in use. */
     void TryDownloadingHistoricalBlocks(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, const CBlockIndex* from_tip, const CBlockIndex* target_block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -926,8 +972,12 @@ private:
     *                     indicates the download might be stalled because every
     *                     block in the window is in flight and no other peer is
     *                     trying to download the next block).
+    * \param blocking     Optional pointer that will receive the first block
+    *                     after pindexWalk that we don't have, if it is already
+    *                     in flight. This is the block validation is waiting
+    *                     for.
     */
-    void FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, const Peer& peer, CNodeState *state, const CBlockIndex *pindexWalk, unsigned int count, int nWindowEnd, const CChain* activeChain=nullptr, NodeId* nodeStaller=nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, const Peer& peer, CNodeState *state, const CBlockIndex *pindexWalk, unsigned int count, int nWindowEnd, const CChain* activeChain=nullptr, NodeId* nodeStaller=nullptr, const CBlockIndex** blocking=nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /* Multimap used to preserve insertion order */
     typedef std::multimap<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator>> BlockDownloadMap;
@@ -940,12 +990,25 @@ private:
     CTransactionRef FindTxForGetData(const Peer::TxRelay& tx_relay, const GenTxid& gtxid)
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, NetEventsInterface::g_msgproc_mutex);
 
+    /** If hash is the most recent block, get the message of type msg_type about it: a witness BLOCK,
+     *  a CMPCTBLOCK, or HEADERS announcing just that block. The message is serialized once, and its
+     *  payload shared by the copies sent to all peers. BLOCK and CMPCTBLOCK payloads are also shared
+     *  with the serialized block cache, which keeps serving them once the block is no longer the
+     *  most recent one. */
+    std::optional<CSerializedNetMsg> GetMostRecentBlockMsg(const uint256& hash, const std::string& msg_type)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
+
+    /** Get the CMPCTBLOCK message for a block near the tip from the serialized block cache, making it
+     *  from `block`, or else the block on disk, and caching it if it is not there. */
+    CSerializedNetMsg GetCompactBlockMsg(const CBlockIndex& index, const CBlock* block);
+
     void ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic<bool>& interruptMsgProc)
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex, peer.m_getdata_requests_mutex, NetEventsInterface::g_msgproc_mutex)
         LOCKS_EXCLUDED(::cs_main);
 
     /** Process a new block. Perform any post-processing housekeeping */
-    void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
+    void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked)
+        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
 
     /** Process compact block txns  */
     void ProcessCompactBlockTxns(CNode& pfrom, Peer& peer, const BlockTransactions& block_transactions)
@@ -1221,7 +1284,7 @@ bool PeerManagerImpl::BlockRequested(NodeId nodeid, const CBlockIndex& block, st
     RemoveBlockRequest(hash, nodeid);
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {&block, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr)});
+            {&block, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&m_mempool) : nullptr), GetTime<std::chrono::microseconds>()});
     if (state->vBlocksInFlight.size() == 1) {
         // We're starting a block download (batch) from this peer.
         state->m_downloading_since = GetTime<std::chrono::microseconds>();
@@ -1234,6 +1297,40 @@ bool PeerManagerImpl::BlockRequested(NodeId nodeid, const CBlockIndex& block, st
     return true;
 }
 
+void PeerManagerImpl::BlockDownloaded(NodeId nodeid, const uint256& hash, size_t size)
+{
+    for (auto range = mapBlocksInFlight.equal_range(hash); range.first != range.second; range.first++) {
+        const auto& [node_id, list_it] = range.first->second;
+        if (node_id != nodeid) continue;
+        CNodeState& state = *Assert(State(nodeid));
+        state.m_block_download.BlockReceived(list_it->m_time_requested, GetTime<std::chrono::microseconds>(), size);
+        return;
+    }
+}
+
+bool PeerManagerImpl::ShouldRequestBlockingBlock(const CNodeState& state, const CBlockIndex& block, std::chrono::microseconds now)
+{
+    const auto& stats{state.m_block_download};
+    if (!stats.HasEstimate()) return false;
+    const auto range{mapBlocksInFlight.equal_range(block.GetBlockHash())};
+    if (size_t(std::distance(range.first, range.second)) >= MAX_BLOCK_DOWNLOADS_PER_BLOCK) return false;
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto& [node_id, list_it] = it->second;
+        const CNodeState& holder{*Assert(State(node_id))};
+        // Already requested from this peer, or being reconstructed from a compact block
+        if (&holder == &state || list_it->partialBlock) return false;
+        // Only once the block is late compared to when we would expect it from this peer
+        if (now - list_it->m_time_requested < std::max<std::chrono::microseconds>(BLOCK_REREQUEST_MIN_WAIT, BLOCK_REREQUEST_MIN_SPEEDUP * stats.Latency())) {
+            return false;
+        }
+        const auto& holder_stats{holder.m_block_download};
+        if (holder_stats.HasEstimate() && holder_stats.ServiceTime() < BLOCK_REREQUEST_MIN_SPEEDUP * stats.ServiceTime()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid)
 {
     AssertLockHeld(cs_main);
@@ -1350,7 +1447,7 @@ void PeerManagerImpl::UpdateBlockAvailability(NodeId nodeid, const uint256 &hash
 }
 
 // Logic for calculating which blocks to download from a given peer, given our current tip.
-void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller)
+void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const CBlockIndex*& blocking)
 {
     if (count == 0)
         return;
@@ -1385,7 +1482,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int co
     // download that next block if the window were 1 larger.
     int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
 
-    FindNextBlocks(vBlocks, peer, state, pindexWalk, count, nWindowEnd, &m_chainman.ActiveChain(), &nodeStaller);
+    FindNextBlocks(vBlocks, peer, state, pindexWalk, count, nWindowEnd, &m_chainman.ActiveChain(), &nodeStaller, &blocking);
 }
 
 void PeerManagerImpl::TryDownloadingHistoricalBlocks(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, const CBlockIndex *from_tip, const CBlockIndex* target_block)
@@ -1417,11 +1514,12 @@ void PeerManagerImpl::TryDownloadingHistoricalBlocks(const Peer& peer, unsigned
     FindNextBlocks(vBlocks, peer, state, from_tip, count, std::min<int>(from_tip->nHeight + BLOCK_DOWNLOAD_WINDOW, target_block->nHeight));
 }
 
-void PeerManagerImpl::FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, const Peer& peer, CNodeState *state, const CBlockIndex *pindexWalk, unsigned int count, int nWindowEnd, const CChain* activeChain, NodeId* nodeStaller)
+void PeerManagerImpl::FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, const Peer& peer, CNodeState *state, const CBlockIndex *pindexWalk, unsigned int count, int nWindowEnd, const CChain* activeChain, NodeId* nodeStaller, const CBlockIndex** blocking)
 {
     std::vector<const CBlockIndex*> vToFetch;
     int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
+    bool found_missing{false};
     while (pindexWalk->nHeight < nMaxHeight) {
         // Read up to 128 (or more, if more blocks than that are needed) successors of pindexWalk (towards
         // pindexBestKnownBlock) into vToFetch. We fetch 128, because CBlockIndex::GetAncestor may be as expensive
@@ -1450,7 +1548,12 @@ void PeerManagerImpl::FindNextBlocks(std::vector<const CBlockIndex*>& vBlocks, c
             if (pindex->nStatus & BLOCK_HAVE_DATA || (activeChain && activeChain->Contains(pindex))) {
                 if (activeChain && pindex->HaveNumChainTxs())
                     state->pindexLastCommonBlock = pindex;
-            } else if (!IsBlockRequested(pindex->GetBlockHash())) {
+                continue;
+            }
+            if (!std::exchange(found_missing, true) && blocking && IsBlockRequested(pindex->GetBlockHash())) {
+                *blocking = pindex;
+            }
+            if (!IsBlockRequested(pindex->GetBlockHash())) {
                 // The block is not already downloaded, and not yet in flight.
                 if (pindex->nHeight > nWindowEnd) {
                     // We reached the end of the window.
@@ -1499,17 +1602,17 @@ void PeerManagerImpl::PushNodeVersion(CNode& pnode, const Peer& peer)
     }
 }
 
-void PeerManagerImpl::AddTxAnnouncement(const CNode& node, const GenTxid& gtxid, std::chrono::microseconds current_time)
+void PeerManagerImpl::AddTxAnnouncements(const CNode& node, Span<const GenTxid> gtxids, std::chrono::microseconds current_time)
 {
     AssertLockHeld(::cs_main); // For m_txrequest
+    if (gtxids.empty()) return;
     NodeId nodeid = node.GetId();
-    if (!node.HasPermission(NetPermissionFlags::Relay) && m_txrequest.Count(nodeid) >= MAX_PEER_TX_ANNOUNCEMENTS) {
-        // Too many queued announcements from this peer
-        return;
-    }
+    // Stop once there are too many queued announcements from this peer
+    const size_t max_announcements{node.HasPermission(NetPermissionFlags::Relay) ?
+        std::numeric_limits<size_t>::max() : size_t{MAX_PEER_TX_ANNOUNCEMENTS}};
     const CNodeState* state = State(nodeid);
 
-    // Decide the TxRequestTracker parameters for this announcement:
+    // Decide the TxRequestTracker parameters for these announcements:
     // - "preferred": if fPreferredDownload is set (= outbound, or NetPermissionFlags::NoBan permission)
     // - "reqtime": current time plus delays for:
     //   - NONPREF_PEER_TX_DELAY for announcements from non-preferred connections
@@ -1519,11 +1622,26 @@ void PeerManagerImpl::AddTxAnnouncement(const CNode& node, const GenTxid& gtxid,
     auto delay{0us};
     const bool preferred = state->fPreferredDownload;
     if (!preferred) delay += NONPREF_PEER_TX_DELAY;
-    if (!gtxid.IsWtxid() && m_wtxid_relay_peers > 0) delay += TXID_RELAY_DELAY;
     const bool overloaded = !node.HasPermission(NetPermissionFlags::Relay) &&
         m_txrequest.CountInFlight(nodeid) >= MAX_PEER_TX_REQUEST_IN_FLIGHT;
     if (overloaded) delay += OVERLOADED_PEER_TX_DELAY;
-    m_txrequest.ReceivedInv(nodeid, gtxid, preferred, current_time + delay);
+    const auto reqtime = [&](const GenTxid& gtxid) {
+        return current_time + delay + (!gtxid.IsWtxid() && m_wtxid_relay_peers > 0 ? TXID_RELAY_DELAY : 0us);
+    };
+
+    // The announcements are normally all of one kind: an INV only has those
+    // matching the peer's wtxidrelay setting, and orphan parents are fetched
+    // by txid. Hand them over in one go then.
+    const bool same_kind{std::all_of(gtxids.begin(), gtxids.end(), [&](const GenTxid& gtxid) {
+        return gtxid.IsWtxid() == gtxids.front().IsWtxid();
+    })};
+    if (same_kind) {
+        m_txrequest.ReceivedInvs(nodeid, gtxids, preferred, reqtime(gtxids.front()), max_announcements);
+    } else {
+        for (const GenTxid& gtxid : gtxids) {
+            m_txrequest.ReceivedInvs(nodeid, Span{&gtxid, 1}, preferred, reqtime(gtxid), max_announcements);
+        }
+    }
 }
 
 void PeerManagerImpl::UpdateLastBlockAnnounceTime(NodeId node, int64_t time_in_seconds)
@@ -1674,6 +1792,8 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        stats.m_block_download_window = state->m_block_download_window;
+        stats.m_block_download = state->m_block_download;
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1983,7 +2103,6 @@ void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &blo
 void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
 {
     auto pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs>(*pblock);
-    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
 
     LOCK(cs_main);
 
@@ -1994,8 +2113,6 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
     if (!DeploymentActiveAt(*pindex, m_chainman, Consensus::DEPLOYMENT_SEGWIT)) return;
 
     uint256 hashBlock(pblock->GetHash());
-    const std::shared_future<CSerializedNetMsg> lazy_ser{
-        std::async(std::launch::deferred, [&] { return msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock); })};
 
     {
         auto most_recent_block_txs = std::make_unique<std::map<uint256, CTransactionRef>>();
@@ -2009,9 +2126,10 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         m_most_recent_block = pblock;
         m_most_recent_compact_block = pcmpctblock;
         m_most_recent_block_txs = std::move(most_recent_block_txs);
+        m_most_recent_block_msgs.clear();
     }
 
-    m_connman.ForEachNode([this, pindex, &lazy_ser, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    m_connman.ForEachNode([this, pindex, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
         if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
@@ -2025,8 +2143,10 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
 
-            const CSerializedNetMsg& ser_cmpctblock{lazy_ser.get()};
-            m_connman.PushMessage(pnode, ser_cmpctblock.Copy());
+            // Serialized for the first such peer only, and shared by the others.
+            auto ser_cmpctblock{GetMostRecentBlockMsg(hashBlock, NetMsgType::CMPCTBLOCK)};
+            if (!Assume(ser_cmpctblock)) return;
+            m_connman.PushMessage(pnode, std::move(*ser_cmpctblock));
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -2221,11 +2341,9 @@ void PeerManagerImpl::RelayAddress(NodeId originator,
 void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv)
 {
     std::shared_ptr<const CBlock> a_recent_block;
-    std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
     {
         LOCK(m_most_recent_block_mutex);
         a_recent_block = m_most_recent_block;
-        a_recent_compact_block = m_most_recent_compact_block;
     }
 
     bool need_activate_chain = false;
@@ -2287,28 +2405,41 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     std::shared_ptr<const CBlock> pblock;
     if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
-    } else if (inv.IsMsgWitnessBlk()) {
-        // Fast-path: in this case it is possible to serve the block directly from disk,
-        // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!m_chainman.m_blockman.ReadRawBlockFromDisk(block_data, pindex->GetBlockPos())) {
-            assert(!"cannot load block from disk");
-        }
-        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, Span{block_data}));
-        // Don't set pblock as we've sent the block
+    }
+    // If a peer is asking for old blocks, we're almost guaranteed
+    // they won't have a useful mempool to match against a compact block,
+    // and we don't feel like constructing the object for them, so
+    // instead we respond with the full, non-compact block.
+    const bool send_compact{inv.IsMsgCmpctBlk() && CanDirectFetch() && pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_CMPCTBLOCK_DEPTH};
+    if (inv.IsMsgWitnessBlk() || (inv.IsMsgCmpctBlk() && !send_compact)) {
+        // Fast-path: the network format matches the format on disk, so the block
+        // is served as stored. Blocks near the tip, which many peers ask for, are
+        // kept in the serialized block cache.
+        auto msg{GetMostRecentBlockMsg(pindex->GetBlockHash(), NetMsgType::BLOCK)};
+        if (!msg) {
+            const bool cache_block{pindex->nHeight >= m_chainman.ActiveChain().Height() - node::SERIALIZED_BLOCK_CACHE_DEPTH};
+            msg.emplace();
+            msg->m_type = NetMsgType::BLOCK;
+            msg->m_shared_data = m_chainman.m_blockman.GetSerializedBlock(*pindex, pblock.get(), cache_block);
+            if (!msg->m_shared_data) {
+                assert(!"cannot load block from disk");
+            }
+        }
+        m_connman.PushMessage(&pfrom, std::move(*msg));
+    } else if (send_compact) {
+        auto msg{GetMostRecentBlockMsg(pindex->GetBlockHash(), NetMsgType::CMPCTBLOCK)};
+        m_connman.PushMessage(&pfrom, msg ? std::move(*msg) : GetCompactBlockMsg(*pindex, pblock.get()));
     } else {
-        // Send block from disk
-        std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-        if (!m_chainman.m_blockman.ReadBlockFromDisk(*pblockRead, *pindex)) {
-            assert(!"cannot load block from disk");
+        if (!pblock) {
+            // Send block from disk
+            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+            if (!m_chainman.m_blockman.ReadBlock(*pblockRead, *pindex)) {
+                assert(!"cannot load block from disk");
+            }
+            pblock = pblockRead;
         }
-        pblock = pblockRead;
-    }
-    if (pblock) {
         if (inv.IsMsgBlk()) {
             m_connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, *pblock));
-        } else if (inv.IsMsgWitnessBlk()) {
-            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
         } else if (inv.IsMsgFilteredBlk()) {
             bool sendMerkleBlock = false;
             CMerkleBlock merkleBlock;
@@ -2333,21 +2464,6 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             }
             // else
             // no response
-        } else if (inv.IsMsgCmpctBlk()) {
-            // If a peer is asking for old blocks, we're almost guaranteed
-            // they won't have a useful mempool to match against a compact block,
-            // and we don't feel like constructing the object for them, so
-            // instead we respond with the full, non-compact block.
-            if (CanDirectFetch() && pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_CMPCTBLOCK_DEPTH) {
-                if (a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
-                } else {
-                    CBlockHeaderAndShortTxIDs cmpctblock{*pblock};
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
-                }
-            } else {
-                m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
-            }
         }
     }
 
@@ -2386,6 +2502,54 @@ CTransactionRef PeerManagerImpl::FindTxForGetData(const Peer::TxRelay& tx_relay,
     return {};
 }
 
+std::optional<CSerializedNetMsg> PeerManagerImpl::GetMostRecentBlockMsg(const uint256& hash, const std::string& msg_type)
+{
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    LOCK(m_most_recent_block_mutex);
+    if (!m_most_recent_block || hash != m_most_recent_block_hash) return std::nullopt;
+    auto it{m_most_recent_block_msgs.find(msg_type)};
+    if (it == m_most_recent_block_msgs.end()) {
+        auto& block_cache{m_chainman.m_blockman.m_serialized_block_cache};
+        CSerializedNetMsg msg;
+        if (msg_type == NetMsgType::BLOCK || msg_type == NetMsgType::CMPCTBLOCK) {
+            const auto encoding{msg_type == NetMsgType::BLOCK ? node::BlockEncoding::STORED : node::BlockEncoding::COMPACT};
+            msg.m_type = msg_type;
+            msg.m_shared_data = block_cache.Get(hash, encoding);
+            if (!msg.m_shared_data) {
+                msg = encoding == node::BlockEncoding::STORED ? msgMaker.MakeShared(NetMsgType::BLOCK, *m_most_recent_block) :
+                                                                msgMaker.MakeShared(NetMsgType::CMPCTBLOCK, *m_most_recent_compact_block);
+                block_cache.Insert(hash, encoding, msg.m_shared_data);
+            }
+        } else if (msg_type == NetMsgType::HEADERS) {
+            msg = msgMaker.MakeShared(NetMsgType::HEADERS, std::vector<CBlock>{CBlock{m_most_recent_block->GetBlockHeader()}});
+        } else {
+            Assume(false);
+            return std::nullopt;
+        }
+        it = m_most_recent_block_msgs.emplace(msg_type, std::move(msg)).first;
+    }
+    return it->second.Copy();
+}
+
+CSerializedNetMsg PeerManagerImpl::GetCompactBlockMsg(const CBlockIndex& index, const CBlock* block)
+{
+    auto& block_cache{m_chainman.m_blockman.m_serialized_block_cache};
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::CMPCTBLOCK;
+    msg.m_shared_data = block_cache.Get(index.GetBlockHash(), node::BlockEncoding::COMPACT);
+    if (msg.m_shared_data) return msg;
+
+    CBlock block_read;
+    if (!block) {
+        const bool ret{m_chainman.m_blockman.ReadBlock(block_read, index)};
+        assert(ret);
+        block = &block_read;
+    }
+    msg = CNetMsgMaker{PROTOCOL_VERSION}.MakeShared(NetMsgType::CMPCTBLOCK, CBlockHeaderAndShortTxIDs{*block});
+    block_cache.Insert(index.GetBlockHash(), node::BlockEncoding::COMPACT, msg.m_shared_data);
+    return msg;
+}
+
 void PeerManagerImpl::ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic<bool>& interruptMsgProc)
 {
     AssertLockNotHeld(cs_main);
@@ -2647,6 +2811,48 @@ bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(Peer& peer, CNode& pfro
 
 bool PeerManagerImpl::TryLowWorkHeadersSync(Peer& peer, CNode& pfrom, const CBlockIndex* chain_start_header, std::vector<CBlockHeader>& headers)
 {
+    // Calculate the total work on this chain.
+    arith_uint256 total_work = chain_start_header->nChainWork + CalculateHeadersWork(headers);
+
+    // Our dynamic anti-DoS threshold (minimum work required on a headers chain
+    // before we'll store it)
+    arith_uint256 minimum_chain_work = GetAntiDoSWorkThreshold();
+
+    // Avoid DoS via low-difficulty-headers by only processing if the headers
+    // are part of a chain with sufficient work.
+    if (total_work < minimum_chain_work) {
+        // Only try to sync with this peer if their headers message was full;
+        // otherwise they don't have more headers after this so no point in
+        // trying to sync their too-little-work chain.
+        if (headers.size() == MAX_HEADERS_RESULTS) {
+            // Note: we could advance to the last header in this set that is
+            // known to us, rather than starting at the first header (which we
+            // may already have); however this is unlikely to matter much since
+            // ProcessHeadersMessage() already handles the case where all
+            // headers in a received message are already known and are
+            // ancestors of m_best_header or chainActive.Tip(), by skipping
+            // this logic in that case. So even if the first header in this set
+            // of headers is known, some header in this set must be new, so
+            // advancing to the first unknown header would be a small effect.
+            LOCK(peer.m_headers_sync_mutex);
+            peer.m_headers_sync.reset(new HeadersSyncState(peer.m_id, m_chainparams.GetConsensus(),
+                chain_start_header, minimum_chain_work,
+                /*signature_threads=*/std::clamp(GetNumCores() - 1, 0, MAX_HEADERS_SIGNATURE_THREADS)));
+
+            // Now a HeadersSyncState object for tracking this synchronization
+            // is created, process the headers using it as normal. Failures are
+            // handled inside of IsContinuationOfLowWorkHeadersSync.
+            (void)IsContinuationOfLowWorkHeadersSync(peer, pfrom, headers);
+        } else {
+            LogPrint(BCLog::NET, "Ignoring low-work chain (height=%u) from peer=%d\n", chain_start_header->nHeight + headers.size(), pfrom.GetId());
+        }
+
+        // The peer has not yet given us a chain that meets our work threshold,
+        // so we want to prevent further processing of the headers in any case.
+        headers = {};
+        return true;
+    }
+
     return false;
 }
 
@@ -2830,13 +3036,13 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     // We'll rely on headers having valid proof-of-work further down, as an
     // anti-DoS criteria (note: this check is required before passing any
     // headers into HeadersSyncState).
-    // if (!CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer)) {
-    //     // Misbehaving() calls are handled within CheckHeadersPoW(), so we can
-    //     // just return. (Note that even if a header is announced via compact
-    //     // block, the header itself should be valid, so this type of error can
-    //     // always be punished.)
-    //     return;
-    // }
+    if (!CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer)) {
+        // Misbehaving() calls are handled within CheckHeadersPoW(), so we can
+        // just return. (Note that even if a header is announced via compact
+        // block, the header itself should be valid, so this type of error can
+        // always be punished.)
+        return;
+    }
 
     const CBlockIndex *pindexLast = nullptr;
 
@@ -2925,9 +3131,13 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     // something new (if these headers are valid).
     bool received_new_header{last_received_header == nullptr};
 
-    // Now process all the headers.
+    // Now process all the headers. This can take long for a full batch, so
+    // let the other message handler threads go on meanwhile.
     BlockValidationState state;
-    if (!m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/false, state, &pindexLast)) {
+    LEAVE_CRITICAL_SECTION(g_msgproc_mutex);
+    const bool headers_accepted{m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/false, state, &pindexLast)};
+    ENTER_CRITICAL_SECTION(g_msgproc_mutex);
+    if (!headers_accepted) {
         if (state.IsInvalid()) {
             MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
             return;
@@ -2952,6 +3162,245 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     return;
 }
 
+CTransactionRef PeerManagerImpl::ReadIncomingTx(CNode& pfrom, Peer& peer, CDataStream& vRecv)
+{
+    if (RejectIncomingTxs(pfrom)) {
+        LogPrint(BCLog::NET, "transaction sent in violation of protocol peer=%d\n", pfrom.GetId());
+        pfrom.fDisconnect = true;
+        return nullptr;
+    }
+
+    // Stop processing the transaction early if we are still in IBD since we don't
+    // have enough information to validate it yet. Sending unsolicited transactions
+    // is not considered a protocol violation, so don't punish the peer.
+    if (m_chainman.IsInitialBlockDownload()) return nullptr;
+
+    CTransactionRef ptx;
+    vRecv >> ptx;
+
+    const uint256& hash = peer.m_wtxid_relay ? ptx->GetWitnessHash() : ptx->GetHash();
+    AddKnownTx(peer, hash);
+    return ptx;
+}
+
+bool PeerManagerImpl::ShouldValidateTx(CNode& pfrom, const CTransaction& tx)
+{
+    AssertLockHeld(cs_main);
+    const uint256& txid = tx.GetHash();
+    const uint256& wtxid = tx.GetWitnessHash();
+
+    m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
+    if (tx.HasWitness()) m_txrequest.ReceivedResponse(pfrom.GetId(), wtxid);
+
+    // We do the AlreadyHaveTx() check using wtxid, rather than txid - in the
+    // absence of witness malleation, this is strictly better, because the
+    // recent rejects filter may contain the wtxid but rarely contains
+    // the txid of a segwit transaction that has been rejected.
+    // In the presence of witness malleation, it's possible that by only
+    // doing the check with wtxid, we could overlook a transaction which
+    // was confirmed with a different witness, or exists in our mempool
+    // with a different witness, but this has limited downside:
+    // mempool validation does its own lookup of whether we have the txid
+    // already; and an adversary can already relay us old transactions
+    // (older than our recency filter) if trying to DoS us, without any need
+    // for witness malleation.
+    if (AlreadyHaveTx(GenTxid::Wtxid(wtxid))) {
+        if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
+            // Always relay transactions received from peers with forcerelay
+            // permission, even if they were already in the mempool, allowing
+            // the node to function as a gateway for nodes hidden behind it.
+            if (!m_mempool.exists(GenTxid::Txid(tx.GetHash()))) {
+                LogPrintf("Not relaying non-mempool transaction %s (wtxid=%s) from forcerelay peer=%d\n",
+                          tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), pfrom.GetId());
+            } else {
+                LogPrintf("Force relaying tx %s (wtxid=%s) from peer=%d\n",
+                          tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), pfrom.GetId());
+                RelayTransaction(tx.GetHash(), tx.GetWitnessHash());
+            }
+        }
+        // If a tx is detected by m_recent_rejects it is ignored. Because we haven't
+        // submitted the tx to our mempool, we won't have computed a DoS
+        // score for it or determined exactly why we consider it invalid.
+        //
+        // This means we won't penalize any peer subsequently relaying a DoSy
+        // tx (even if we penalized the first peer who gave it to us) because
+        // we have to account for m_recent_rejects showing false positives. In
+        // other words, we shouldn't penalize a peer if we aren't *sure* they
+        // submitted a DoSy tx.
+        //
+        // Note that m_recent_rejects doesn't just record DoSy or invalid
+        // transactions, but any tx not accepted by the mempool, which may be
+        // due to node policy (vs. consensus). So we can't blanket penalize a
+        // peer simply for relaying a tx that our m_recent_rejects has caught,
+        // regardless of false positives.
+        return false;
+    }
+    return true;
+}
+
+void PeerManagerImpl::ProcessTxValidationResult(CNode& pfrom, Peer& peer, const CTransactionRef& ptx, const MempoolAcceptResult& result)
+{
+    AssertLockHeld(cs_main);
+    const CTransaction& tx = *ptx;
+    const TxValidationState& state = result.m_state;
+
+    if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+        // As this version of the transaction was acceptable, we can forget about any
+        // requests for it.
+        m_txrequest.ForgetTxHash(tx.GetHash());
+        m_txrequest.ForgetTxHash(tx.GetWitnessHash());
+        RelayTransaction(tx.GetHash(), tx.GetWitnessHash());
+        m_orphanage.AddChildrenToWorkSet(tx);
+
+        pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+
+        LogPrint(BCLog::MEMPOOL, "AcceptToMemoryPool: peer=%d: accepted %s (wtxid=%s) (poolsz %u txn, %u kB)\n",
+            pfrom.GetId(),
+            tx.GetHash().ToString(),
+            tx.GetWitnessHash().ToString(),
+            m_mempool.size(), m_mempool.DynamicMemoryUsage() / 1000);
+
+        for (const CTransactionRef& removedTx : result.m_replaced_transactions.value()) {
+            AddToCompactExtraTransactions(removedTx);
+        }
+    }
+    else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS)
+    {
+        bool fRejectedParents = false; // It may be the case that the orphans parents have all been rejected
+
+        // Deduplicate parent txids, so that we don't have to loop over
+        // the same parent txid more than once down below.
+        std::vector<uint256> unique_parents;
+        unique_parents.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
+            // We start with all parents, and then remove duplicates below.
+            unique_parents.push_back(txin.prevout.hash);
+        }
+        std::sort(unique_parents.begin(), unique_parents.end());
+        unique_parents.erase(std::unique(unique_parents.begin(), unique_parents.end()), unique_parents.end());
+        for (const uint256& parent_txid : unique_parents) {
+            if (m_recent_rejects.contains(parent_txid)) {
+                fRejectedParents = true;
+                break;
+            }
+        }
+        if (!fRejectedParents) {
+            const auto current_time{GetTime<std::chrono::microseconds>()};
+
+            std::vector<GenTxid> parent_gtxids;
+            for (const uint256& parent_txid : unique_parents) {
+                // Here, we only have the txid (and not wtxid) of the
+                // inputs, so we only request in txid mode, even for
+                // wtxidrelay peers.
+                // Eventually we should replace this with an improved
+                // protocol for getting all unconfirmed parents.
+                const auto gtxid{GenTxid::Txid(parent_txid)};
+                AddKnownTx(peer, parent_txid);
+                if (!AlreadyHaveTx(gtxid)) parent_gtxids.push_back(gtxid);
+            }
+            AddTxAnnouncements(pfrom, parent_gtxids, current_time);
+
+            if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
+                AddToCompactExtraTransactions(ptx);
+            }
+
+            // Once added to the orphan pool, a tx is considered AlreadyHave, and we shouldn't request it anymore.
+            m_txrequest.ForgetTxHash(tx.GetHash());
+            m_txrequest.ForgetTxHash(tx.GetWitnessHash());
+
+            // DoS prevention: do not allow m_orphanage to grow unbounded (see CVE-2012-3789)
+            m_orphanage.LimitOrphans(m_opts.max_orphan_txs);
+        } else {
+            LogPrint(BCLog::MEMPOOL, "not keeping orphan with rejected parents %s (wtxid=%s)\n",
+                     tx.GetHash().ToString(),
+                     tx.GetWitnessHash().ToString());
+            // We will continue to reject this tx since it has rejected
+            // parents so avoid re-requesting it from other peers.
+            // Here we add both the txid and the wtxid, as we know that
+            // regardless of what witness is provided, we will not accept
+            // this, so we don't need to allow for redownload of this txid
+            // from any of our non-wtxidrelay peers.
+            m_recent_rejects.insert(tx.GetHash());
+            m_recent_rejects.insert(tx.GetWitnessHash());
+            m_txrequest.ForgetTxHash(tx.GetHash());
+            m_txrequest.ForgetTxHash(tx.GetWitnessHash());
+        }
+    } else {
+        if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
+            // We can add the wtxid of this transaction to our reject filter.
+            // Do not add txids of witness transactions or witness-stripped
+            // transactions to the filter, as they can have been malleated;
+            // adding such txids to the reject filter would potentially
+            // interfere with relay of valid transactions from peers that
+            // do not support wtxid-based relay. See
+            // https://github.com/bitcoin/bitcoin/issues/8279 for details.
+            // We can remove this restriction (and always add wtxids to
+            // the filter even for witness stripped transactions) once
+            // wtxid-based relay is broadly deployed.
+            // See also comments in https://github.com/bitcoin/bitcoin/pull/18044#discussion_r443419034
+            // for concerns around weakening security of unupgraded nodes
+            // if we start doing this too early.
+            m_recent_rejects.insert(tx.GetWitnessHash());
+            m_txrequest.ForgetTxHash(tx.GetWitnessHash());
+            // If the transaction failed for TX_INPUTS_NOT_STANDARD,
+            // then we know that the witness was irrelevant to the policy
+            // failure, since this check depends only on the txid
+            // (the scriptPubKey being spent is covered by the txid).
+            // Add the txid to the reject filter to prevent repeated
+            // processing of this transaction in the event that child
+            // transactions are later received (resulting in
+            // parent-fetching by txid via the orphan-handling logic).
+            if (state.GetResult() == TxValidationResult::TX_INPUTS_NOT_STANDARD && tx.GetWitnessHash() != tx.GetHash()) {
+                m_recent_rejects.insert(tx.GetHash());
+                m_txrequest.ForgetTxHash(tx.GetHash());
+            }
+            if (RecursiveDynamicUsage(*ptx) < 100000) {
+                AddToCompactExtraTransactions(ptx);
+            }
+        }
+    }
+
+    if (state.IsInvalid()) {
+        LogPrint(BCLog::MEMPOOLREJ, "%s (wtxid=%s) from peer=%d was not accepted: %s\n",
+            tx.GetHash().ToString(),
+            tx.GetWitnessHash().ToString(),
+            pfrom.GetId(),
+            state.ToString());
+        MaybePunishNodeForTx(pfrom.GetId(), state);
+    }
+}
+
+void PeerManagerImpl::ProcessTxMessages(CNode& pfrom, Peer& peer, std::vector<CNetMessage>& msgs)
+{
+    std::vector<CTransactionRef> txs;
+    txs.reserve(msgs.size());
+    for (CNetMessage& msg : msgs) {
+        LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(msg.m_type), msg.m_recv.size(), pfrom.GetId());
+        CTransactionRef ptx;
+        try {
+            ptx = ReadIncomingTx(pfrom, peer, msg.m_recv);
+        } catch (const std::exception& e) {
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' (%s) caught\n", __func__, SanitizeString(msg.m_type), msg.m_message_size, e.what(), typeid(e).name());
+        }
+        if (pfrom.fDisconnect) return;
+        if (!ptx) continue;
+
+        LOCK(cs_main);
+        // Duplicates within the batch would otherwise be rejected as already in the mempool.
+        const auto same_wtxid{[&](const CTransactionRef& other) { return other->GetWitnessHash() == ptx->GetWitnessHash(); }};
+        if (std::any_of(txs.begin(), txs.end(), same_wtxid) || !ShouldValidateTx(pfrom, *ptx)) continue;
+        txs.push_back(std::move(ptx));
+    }
+    if (txs.empty()) return;
+
+    const std::vector<MempoolAcceptResult> results{m_chainman.ProcessTransactions(txs)};
+
+    LOCK(cs_main);
+    for (size_t i = 0; i < txs.size(); ++i) {
+        ProcessTxValidationResult(pfrom, peer, txs[i], results[i]);
+    }
+}
+
 bool PeerManagerImpl::ProcessOrphanTx(Peer& peer)
 {
     AssertLockHeld(g_msgproc_mutex);
@@ -3205,7 +3654,12 @@ void PeerManagerImpl::ProcessGetCFCheckPt(CNode& node, Peer& peer, CDataStream&
 void PeerManagerImpl::ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked)
 {
     bool new_block{false};
-    m_chainman.ProcessNewBlock(block, force_processing, min_pow_checked, &new_block);
+    {
+        // Let the other message handler threads go on while the block is validated.
+        LEAVE_CRITICAL_SECTION(g_msgproc_mutex);
+        m_chainman.ProcessNewBlock(block, force_processing, min_pow_checked, &new_block);
+        ENTER_CRITICAL_SECTION(g_msgproc_mutex);
+    }
     if (new_block) {
         node.m_last_block_time = GetTime<std::chrono::seconds>();
         // In case this block came from a different peer than we requested
@@ -3830,6 +4284,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         const auto current_time{GetTime<std::chrono::microseconds>()};
         uint256* best_block{nullptr};
+        // Transactions to request, added to m_txrequest together
+        std::vector<GenTxid> tx_announcements;
 
         for (CInv& inv : vInv) {
             if (interruptMsgProc) return;
@@ -3869,12 +4325,13 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
                 AddKnownTx(*peer, inv.hash);
                 if (!fAlreadyHave && !m_chainman.IsInitialBlockDownload()) {
-                    AddTxAnnouncement(pfrom, gtxid, current_time);
+                    tx_announcements.push_back(gtxid);
                 }
             } else {
                 LogPrint(BCLog::NET, "Unknown inv type \"%s\" received from peer=%d\n", inv.ToString(), pfrom.GetId());
             }
         }
+        AddTxAnnouncements(pfrom, tx_announcements, current_time);
 
         if (best_block != nullptr) {
             // If we haven't started initial headers-sync with this peer, then
@@ -4131,201 +4588,14 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
     }
 
     if (msg_type == NetMsgType::TX) {
-        if (RejectIncomingTxs(pfrom)) {
-            LogPrint(BCLog::NET, "transaction sent in violation of protocol peer=%d\n", pfrom.GetId());
-            pfrom.fDisconnect = true;
-            return;
-        }
-
-        // Stop processing the transaction early if we are still in IBD since we don't
-        // have enough information to validate it yet. Sending unsolicited transactions
-        // is not considered a protocol violation, so don't punish the peer.
-        if (m_chainman.IsInitialBlockDownload()) return;
-
-        CTransactionRef ptx;
-        vRecv >> ptx;
-        const CTransaction& tx = *ptx;
-
-        const uint256& txid = ptx->GetHash();
-        const uint256& wtxid = ptx->GetWitnessHash();
-
-        const uint256& hash = peer->m_wtxid_relay ? wtxid : txid;
-        AddKnownTx(*peer, hash);
+        CTransactionRef ptx{ReadIncomingTx(pfrom, *peer, vRecv)};
+        if (!ptx) return;
 
         LOCK(cs_main);
-
-        m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
-        if (tx.HasWitness()) m_txrequest.ReceivedResponse(pfrom.GetId(), wtxid);
-
-        // We do the AlreadyHaveTx() check using wtxid, rather than txid - in the
-        // absence of witness malleation, this is strictly better, because the
-        // recent rejects filter may contain the wtxid but rarely contains
-        // the txid of a segwit transaction that has been rejected.
-        // In the presence of witness malleation, it's possible that by only
-        // doing the check with wtxid, we could overlook a transaction which
-        // was confirmed with a different witness, or exists in our mempool
-        // with a different witness, but this has limited downside:
-        // mempool validation does its own lookup of whether we have the txid
-        // already; and an adversary can already relay us old transactions
-        // (older than our recency filter) if trying to DoS us, without any need
-        // for witness malleation.
-        if (AlreadyHaveTx(GenTxid::Wtxid(wtxid))) {
-            if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
-                // Always relay transactions received from peers with forcerelay
-                // permission, even if they were already in the mempool, allowing
-                // the node to function as a gateway for nodes hidden behind it.
-                if (!m_mempool.exists(GenTxid::Txid(tx.GetHash()))) {
-                    LogPrintf("Not relaying non-mempool transaction %s (wtxid=%s) from forcerelay peer=%d\n",
-                              tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), pfrom.GetId());
-                } else {
-                    LogPrintf("Force relaying tx %s (wtxid=%s) from peer=%d\n",
-                              tx.GetHash().ToString(), tx.GetWitnessHash().ToString(), pfrom.GetId());
-                    RelayTransaction(tx.GetHash(), tx.GetWitnessHash());
-                }
-            }
-            // If a tx is detected by m_recent_rejects it is ignored. Because we haven't
-            // submitted the tx to our mempool, we won't have computed a DoS
-            // score for it or determined exactly why we consider it invalid.
-            //
-            // This means we won't penalize any peer subsequently relaying a DoSy
-            // tx (even if we penalized the first peer who gave it to us) because
-            // we have to account for m_recent_rejects showing false positives. In
-            // other words, we shouldn't penalize a peer if we aren't *sure* they
-            // submitted a DoSy tx.
-            //
-            // Note that m_recent_rejects doesn't just record DoSy or invalid
-            // transactions, but any tx not accepted by the mempool, which may be
-            // due to node policy (vs. consensus). So we can't blanket penalize a
-            // peer simply for relaying a tx that our m_recent_rejects has caught,
-            // regardless of false positives.
-            return;
-        }
+        if (!ShouldValidateTx(pfrom, *ptx)) return;
 
         const MempoolAcceptResult result = m_chainman.ProcessTransaction(ptx);
-        const TxValidationState& state = result.m_state;
-
-        if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
-            // As this version of the transaction was acceptable, we can forget about any
-            // requests for it.
-            m_txrequest.ForgetTxHash(tx.GetHash());
-            m_txrequest.ForgetTxHash(tx.GetWitnessHash());
-            RelayTransaction(tx.GetHash(), tx.GetWitnessHash());
-            m_orphanage.AddChildrenToWorkSet(tx);
-
-            pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
-
-            LogPrint(BCLog::MEMPOOL, "AcceptToMemoryPool: peer=%d: accepted %s (wtxid=%s) (poolsz %u txn, %u kB)\n",
-                pfrom.GetId(),
-                tx.GetHash().ToString(),
-                tx.GetWitnessHash().ToString(),
-                m_mempool.size(), m_mempool.DynamicMemoryUsage() / 1000);
-
-            for (const CTransactionRef& removedTx : result.m_replaced_transactions.value()) {
-                AddToCompactExtraTransactions(removedTx);
-            }
-        }
-        else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS)
-        {
-            bool fRejectedParents = false; // It may be the case that the orphans parents have all been rejected
-
-            // Deduplicate parent txids, so that we don't have to loop over
-            // the same parent txid more than once down below.
-            std::vector<uint256> unique_parents;
-            unique_parents.reserve(tx.vin.size());
-            for (const CTxIn& txin : tx.vin) {
-                // We start with all parents, and then remove duplicates below.
-                unique_parents.push_back(txin.prevout.hash);
-            }
-            std::sort(unique_parents.begin(), unique_parents.end());
-            unique_parents.erase(std::unique(unique_parents.begin(), unique_parents.end()), unique_parents.end());
-            for (const uint256& parent_txid : unique_parents) {
-                if (m_recent_rejects.contains(parent_txid)) {
-                    fRejectedParents = true;
-                    break;
-                }
-            }
-            if (!fRejectedParents) {
-                const auto current_time{GetTime<std::chrono::microseconds>()};
-
-                for (const uint256& parent_txid : unique_parents) {
-                    // Here, we only have the txid (and not wtxid) of the
-                    // inputs, so we only request in txid mode, even for
-                    // wtxidrelay peers.
-                    // Eventually we should replace this with an improved
-                    // protocol for getting all unconfirmed parents.
-                    const auto gtxid{GenTxid::Txid(parent_txid)};
-                    AddKnownTx(*peer, parent_txid);
-                    if (!AlreadyHaveTx(gtxid)) AddTxAnnouncement(pfrom, gtxid, current_time);
-                }
-
-                if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
-                    AddToCompactExtraTransactions(ptx);
-                }
-
-                // Once added to the orphan pool, a tx is considered AlreadyHave, and we shouldn't request it anymore.
-                m_txrequest.ForgetTxHash(tx.GetHash());
-                m_txrequest.ForgetTxHash(tx.GetWitnessHash());
-
-                // DoS prevention: do not allow m_orphanage to grow unbounded (see CVE-2012-3789)
-                m_orphanage.LimitOrphans(m_opts.max_orphan_txs);
-            } else {
-                LogPrint(BCLog::MEMPOOL, "not keeping orphan with rejected parents %s (wtxid=%s)\n",
-                         tx.GetHash().ToString(),
-                         tx.GetWitnessHash().ToString());
-                // We will continue to reject this tx since it has rejected
-                // parents so avoid re-requesting it from other peers.
-                // Here we add both the txid and the wtxid, as we know that
-                // regardless of what witness is provided, we will not accept
-                // this, so we don't need to allow for redownload of this txid
-                // from any of our non-wtxidrelay peers.
-                m_recent_rejects.insert(tx.GetHash());
-                m_recent_rejects.insert(tx.GetWitnessHash());
-                m_txrequest.ForgetTxHash(tx.GetHash());
-                m_txrequest.ForgetTxHash(tx.GetWitnessHash());
-            }
-        } else {
-            if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
-                // We can add the wtxid of this transaction to our reject filter.
-                // Do not add txids of witness transactions or witness-stripped
-                // transactions to the filter, as they can have been malleated;
-                // adding such txids to the reject filter would potentially
-                // interfere with relay of valid transactions from peers that
-                // do not support wtxid-based relay. See
-                // https://github.com/bitcoin/bitcoin/issues/8279 for details.
-                // We can remove this restriction (and always add wtxids to
-                // the filter even for witness stripped transactions) once
-                // wtxid-based relay is broadly deployed.
-                // See also comments in https://github.com/bitcoin/bitcoin/pull/18044#discussion_r443419034
-                // for concerns around weakening security of unupgraded nodes
-                // if we start doing this too early.
-                m_recent_rejects.insert(tx.GetWitnessHash());
-                m_txrequest.ForgetTxHash(tx.GetWitnessHash());
-                // If the transaction failed for TX_INPUTS_NOT_STANDARD,
-                // then we know that the witness was irrelevant to the policy
-                // failure, since this check depends only on the txid
-                // (the scriptPubKey being spent is covered by the txid).
-                // Add the txid to the reject filter to prevent repeated
-                // processing of this transaction in the event that child
-                // transactions are later received (resulting in
-                // parent-fetching by txid via the orphan-handling logic).
-                if (state.GetResult() == TxValidationResult::TX_INPUTS_NOT_STANDARD && tx.GetWitnessHash() != tx.GetHash()) {
-                    m_recent_rejects.insert(tx.GetHash());
-                    m_txrequest.ForgetTxHash(tx.GetHash());
-                }
-                if (RecursiveDynamicUsage(*ptx) < 100000) {
-                    AddToCompactExtraTransactions(ptx);
-                }
-            }
-        }
-
-        if (state.IsInvalid()) {
-            LogPrint(BCLog::MEMPOOLREJ, "%s (wtxid=%s) from peer=%d was not accepted: %s\n",
-                tx.GetHash().ToString(),
-                tx.GetWitnessHash().ToString(),
-                pfrom.GetId(),
-                state.ToString());
-            MaybePunishNodeForTx(pfrom.GetId(), state);
-        }
+        ProcessTxValidationResult(pfrom, *peer, ptx, result);
         return;
     }
 
@@ -4643,6 +4913,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             return;
         }
 
+        const size_t block_size{vRecv.size()};
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
 
@@ -4667,6 +4938,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // Always process the block if we requested it, since we may
             // need it even when it's not a candidate for a new best tip.
             forceProcessing = IsBlockRequested(hash);
+            BlockDownloaded(pfrom.GetId(), hash, block_size);
             RemoveBlockRequest(hash, pfrom.GetId());
             // mapBlockSource is only used for punishing peers and setting
             // which peers send us compact blocks, so the race between here and
@@ -5022,20 +5294,41 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     CNetMessage& msg{poll_result->first};
     bool fMoreWork = poll_result->second;
 
-    TRACE6(net, inbound_message,
-        pfrom->GetId(),
-        pfrom->m_addr_name.c_str(),
-        pfrom->ConnectionTypeAsString().c_str(),
-        msg.m_type.c_str(),
-        msg.m_recv.size(),
-        msg.m_recv.data()
-    );
+    const auto receive_message{[&](CNetMessage& received) {
+        TRACE6(net, inbound_message,
+            pfrom->GetId(),
+            pfrom->m_addr_name.c_str(),
+            pfrom->ConnectionTypeAsString().c_str(),
+            received.m_type.c_str(),
+            received.m_recv.size(),
+            received.m_recv.data()
+        );
 
-    if (m_opts.capture_messages) {
-        CaptureMessage(pfrom->addr, msg.m_type, MakeUCharSpan(msg.m_recv), /*is_incoming=*/true);
-    }
+        if (m_opts.capture_messages) {
+            CaptureMessage(pfrom->addr, received.m_type, MakeUCharSpan(received.m_recv), /*is_incoming=*/true);
+        }
+
+        received.SetVersion(pfrom->GetCommonVersion());
+    }};
+    receive_message(msg);
 
-    msg.SetVersion(pfrom->GetCommonVersion());
+    // Submit a burst of transactions from this peer to the mempool together.
+    if (msg.m_type == NetMsgType::TX && pfrom->fSuccessfullyConnected && m_opts.max_tx_accept_batch > 1) {
+        std::vector<CNetMessage> tx_msgs;
+        while (fMoreWork && tx_msgs.size() + 1 < m_opts.max_tx_accept_batch) {
+            auto next{pfrom->PollMessageOfType(NetMsgType::TX)};
+            if (!next) break;
+            fMoreWork = next->second;
+            receive_message(next->first);
+            tx_msgs.push_back(std::move(next->first));
+        }
+        if (!tx_msgs.empty()) {
+            tx_msgs.insert(tx_msgs.begin(), std::move(msg));
+            ProcessTxMessages(*pfrom, *peer, tx_msgs);
+            if (m_orphanage.HaveTxToReconsider(peer->m_id)) fMoreWork = true;
+            return fMoreWork;
+        }
+    }
 
     try {
         ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
@@ -5642,22 +5935,8 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", __func__,
                             vHeaders.front().GetHash().ToString(), pto->GetId());
 
-                    std::optional<CSerializedNetMsg> cached_cmpctblock_msg;
-                    {
-                        LOCK(m_most_recent_block_mutex);
-                        if (m_most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            cached_cmpctblock_msg = msgMaker.Make(NetMsgType::CMPCTBLOCK, *m_most_recent_compact_block);
-                        }
-                    }
-                    if (cached_cmpctblock_msg.has_value()) {
-                        m_connman.PushMessage(pto, std::move(cached_cmpctblock_msg.value()));
-                    } else {
-                        CBlock block;
-                        const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(block, *pBestIndex)};
-                        assert(ret);
-                        CBlockHeaderAndShortTxIDs cmpctblock{block};
-                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
-                    }
+                    auto cached_cmpctblock_msg{GetMostRecentBlockMsg(pBestIndex->GetBlockHash(), NetMsgType::CMPCTBLOCK)};
+                    m_connman.PushMessage(pto, cached_cmpctblock_msg ? std::move(*cached_cmpctblock_msg) : GetCompactBlockMsg(*pBestIndex, nullptr));
                     state.pindexBestHeaderSent = pBestIndex;
                 } else if (peer->m_prefers_headers) {
                     if (vHeaders.size() > 1) {
@@ -5669,7 +5948,9 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         LogPrint(BCLog::NET, "%s: sending header %s to peer=%d\n", __func__,
                                 vHeaders.front().GetHash().ToString(), pto->GetId());
                     }
-                    m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    // Announcements of just the tip are the same for all peers, so share one.
+                    auto cached_headers_msg{vHeaders.size() == 1 ? GetMostRecentBlockMsg(pBestIndex->GetBlockHash(), NetMsgType::HEADERS) : std::nullopt};
+                    m_connman.PushMessage(pto, cached_headers_msg ? std::move(*cached_headers_msg) : msgMaker.Make(NetMsgType::HEADERS, vHeaders));
                     state.pindexBestHeaderSent = pBestIndex;
                 } else
                     fRevertToInv = true;
@@ -5899,16 +6180,18 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.IsInitialBlockDownload()) && state.vBlocksInFlight.size() < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        state.m_block_download_window = state.m_block_download.Window(pto->m_min_ping_time.load(), MAX_BLOCKS_IN_TRANSIT_PER_PEER);
+        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.IsInitialBlockDownload()) && state.vBlocksInFlight.size() < size_t(state.m_block_download_window)) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
+            const CBlockIndex* blocking{nullptr};
             auto get_inflight_budget = [&state]() {
-                return std::max(0, MAX_BLOCKS_IN_TRANSIT_PER_PEER - static_cast<int>(state.vBlocksInFlight.size()));
+                return std::max(0, state.m_block_download_window - static_cast<int>(state.vBlocksInFlight.size()));
             };
 
             // If a snapshot chainstate is in use, we want to find its next blocks
             // before the background chainstate to prioritize getting to network tip.
-            FindNextBlocksToDownload(*peer, get_inflight_budget(), vToDownload, staller);
+            FindNextBlocksToDownload(*peer, get_inflight_budget(), vToDownload, staller, blocking);
             if (m_chainman.BackgroundSyncInProgress() && !IsLimitedPeer(*peer)) {
                 TryDownloadingHistoricalBlocks(
                     *peer,
@@ -5916,13 +6199,21 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     vToDownload, m_chainman.GetBackgroundSyncTip(),
                     Assert(m_chainman.GetSnapshotBaseBlock()));
             }
+            uint32_t nFetchFlags = GetFetchFlags(*peer);
             for (const CBlockIndex *pindex : vToDownload) {
-                uint32_t nFetchFlags = GetFetchFlags(*peer);
                 vGetData.emplace_back(MSG_BLOCK | nFetchFlags, pindex->GetBlockHash());
                 BlockRequested(pto->GetId(), *pindex);
                 LogPrint(BCLog::NET, "Requesting block %s (%d) peer=%d\n", pindex->GetBlockHash().ToString(),
                     pindex->nHeight, pto->GetId());
             }
+            // Don't let a slow peer hold up validation: request the block it is
+            // waiting for from this peer too, if it can deliver it sooner.
+            if (blocking && get_inflight_budget() > 0 && ShouldRequestBlockingBlock(state, *blocking, current_time)) {
+                vGetData.emplace_back(MSG_BLOCK | nFetchFlags, blocking->GetBlockHash());
+                BlockRequested(pto->GetId(), *blocking);
+                LogPrint(BCLog::NET, "Requesting block %s (%d) peer=%d, also in flight from slower peers\n", blocking->GetBlockHash().ToString(),
+                    blocking->nHeight, pto->GetId());
+            }
             if (state.vBlocksInFlight.empty() && staller != -1) {
                 if (State(staller)->m_stalling_since == 0us) {
                     State(staller)->m_stalling_since = current_time;
@@ -7,6 +7,7 @@
 #define BITCOIN_NET_PROCESSING_H
 
 #include <net.h>
+#include <node/blockdownload.h>
 #include <validationinterface.h>
 
 class AddrMan;
@@ -21,6 +22,8 @@ static const uint32_t DEFAULT_MAX_ORPHAN_TRANSACTIONS{100};
 /** Default number of non-mempool transactions to keep around for block reconstruction. Includes
     orphan, replaced, and rejected transactions. */
 static const uint32_t DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN{100};
+/** Default for -txacceptbatch, the maximum number of consecutive transactions from one peer submitted to the mempool together */
+static const uint32_t DEFAULT_MAX_TX_ACCEPT_BATCH{32};
 static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
@@ -34,6 +37,8 @@ struct CNodeStateStats {
     int m_starting_height = -1;
     std::chrono::microseconds m_ping_wait;
     std::vector<int> vHeightInFlight;
+    int m_block_download_window{0};
+    node::BlockDownloadStats m_block_download;
     bool m_relay_txs;
     CAmount m_fee_filter_received;
     uint64_t m_addr_processed = 0;
@@ -56,6 +61,9 @@ public:
         //! Number of non-mempool transactions to keep around for block reconstruction. Includes
         //! orphan, replaced, and rejected transactions.
         uint32_t max_extra_txs{DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN};
+        //! Maximum number of consecutive transactions from one peer that are submitted to the
+        //! mempool together, so that their scripts are verified in parallel. 1 disables batching.
+        uint32_t max_tx_accept_batch{DEFAULT_MAX_TX_ACCEPT_BATCH};
         //! Whether all P2P messages are captured to disk
         bool capture_messages{false};
         //! Whether or not the internal RNG behaves deterministically (this is
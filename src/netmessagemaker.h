@@ -19,6 +19,7 @@ public:
     {
         CSerializedNetMsg msg;
         msg.m_type = std::move(msg_type);
+        msg.data = g_send_buffer_pool.Get();
         CVectorWriter{nFlags | nVersion, msg.data, 0, std::forward<Args>(args)...};
         return msg;
     }
@@ -29,6 +30,21 @@ public:
         return Make(0, std::move(msg_type), std::forward<Args>(args)...);
     }
 
+    /** Make a message whose payload is shared (not copied) by its Copy()s, to send it to several peers. */
+    template <typename... Args>
+    CSerializedNetMsg MakeShared(int nFlags, std::string msg_type, Args&&... args) const
+    {
+        CSerializedNetMsg msg{Make(nFlags, std::move(msg_type), std::forward<Args>(args)...)};
+        msg.Share();
+        return msg;
+    }
+
+    template <typename... Args>
+    CSerializedNetMsg MakeShared(std::string msg_type, Args&&... args) const
+    {
+        return MakeShared(0, std::move(msg_type), std::forward<Args>(args)...);
+    }
+
 private:
     const int nVersion;
 };
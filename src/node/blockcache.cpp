@@ -0,0 +1,51 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockcache.h>
+
+namespace node {
+
+SerializedBlockCache::Data SerializedBlockCache::Get(const uint256& hash, BlockEncoding encoding)
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find({hash, encoding})};
+    if (it == m_index.end()) return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void SerializedBlockCache::Insert(const uint256& hash, BlockEncoding encoding, Data data)
+{
+    if (!data || data->size() > m_max_bytes) return;
+    LOCK(m_mutex);
+    const Key key{hash, encoding};
+    if (const auto it{m_index.find(key)}; it != m_index.end()) {
+        // Serializations of a block are interchangeable, so keep the one
+        // already handed out.
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+    while (!m_entries.empty() && m_bytes + data->size() > m_max_bytes) {
+        m_bytes -= m_entries.back().data->size();
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+    m_bytes += data->size();
+    m_entries.push_front({key, std::move(data)});
+    m_index.emplace(key, m_entries.begin());
+}
+
+size_t SerializedBlockCache::Count() const
+{
+    LOCK(m_mutex);
+    return m_entries.size();
+}
+
+size_t SerializedBlockCache::Bytes() const
+{
+    LOCK(m_mutex);
+    return m_bytes;
+}
+
+} // namespace node
@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCACHE_H
+#define BITCOIN_NODE_BLOCKCACHE_H
+
+#include <sync.h>
+#include <threadsafety.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace node {
+
+//! Blocks at most this deep below the tip are added to the serialized block
+//! cache when served. Deeper ones are fetched by syncing peers, each only once.
+static constexpr int SERIALIZED_BLOCK_CACHE_DEPTH{288};
+
+/** The encodings of a block the serialized block cache holds */
+enum class BlockEncoding : uint8_t {
+    STORED,  //!< As stored on disk, which is the network serialization with witness data
+    COMPACT, //!< A BIP 152 cmpctblock message payload
+};
+
+/**
+ * A size-bounded LRU cache of serialized blocks near the tip, shared by
+ * everything that serves them (P2P, REST and ZMQ), so a block many peers ask
+ * for is read from disk and serialized once. Entries are immutable and handed
+ * out by reference, so the same buffer can back any number of queued
+ * messages and replies.
+ */
+class SerializedBlockCache
+{
+public:
+    using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+    explicit SerializedBlockCache(size_t max_bytes) : m_max_bytes{max_bytes} {}
+
+    /** Look up an encoding of a block, marking it most recently used. Returns nullptr if it is not cached. */
+    Data Get(const uint256& hash, BlockEncoding encoding) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Add an encoding of a block, evicting the least recently used entries to
+     * stay within the size limit. Data larger than the limit is not cached.
+     */
+    void Insert(const uint256& hash, BlockEncoding encoding, Data data) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    size_t Count() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t Bytes() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t MaxBytes() const { return m_max_bytes; }
+
+private:
+    using Key = std::pair<uint256, BlockEncoding>;
+
+    struct KeyHasher {
+        size_t operator()(const Key& key) const { return BlockHasher{}(key.first) ^ size_t(key.second); }
+    };
+
+    struct Entry {
+        Key key;
+        Data data;
+    };
+
+    const size_t m_max_bytes;
+
+    mutable Mutex m_mutex;
+    //! Entries, most recently used first
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> m_index GUARDED_BY(m_mutex);
+    //! Total payload size of m_entries
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKCACHE_H
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockdownload.h>
+
+#include <algorithm>
+
+namespace node {
+
+namespace {
+//! Weight of a new sample in the moving averages is 1 / BLOCK_DOWNLOAD_AVERAGE_WEIGHT
+constexpr int BLOCK_DOWNLOAD_AVERAGE_WEIGHT{8};
+
+template <typename T>
+void UpdateAverage(T& average, T sample, bool first)
+{
+    average = first ? sample : average + (sample - average) / BLOCK_DOWNLOAD_AVERAGE_WEIGHT;
+}
+} // namespace
+
+void BlockDownloadStats::BlockReceived(std::chrono::microseconds requested, std::chrono::microseconds now, size_t size)
+{
+    const bool first{m_blocks == 0};
+    const auto latency{std::max(now - requested, std::chrono::microseconds{0})};
+    const auto service_time{std::max(now - std::max(requested, m_last_received), std::chrono::microseconds{0})};
+    UpdateAverage(m_latency, latency, first);
+    UpdateAverage(m_service_time, service_time, first);
+    UpdateAverage(m_block_size, double(size), first);
+    m_last_received = std::max(m_last_received, now);
+    ++m_blocks;
+    m_bytes += size;
+}
+
+int BlockDownloadStats::Window(std::chrono::microseconds rtt, int default_window) const
+{
+    if (!HasEstimate()) return default_window;
+    const auto horizon{std::min(rtt, m_latency) + BLOCK_DOWNLOAD_REFILL_TIME};
+    const int64_t window{1 + horizon / std::max(m_service_time, std::chrono::microseconds{1})};
+    return int(std::clamp<int64_t>(window, MIN_BLOCKS_IN_TRANSIT_PER_PEER, MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER));
+}
+
+double BlockDownloadStats::Rate() const
+{
+    if (!HasEstimate() || m_service_time.count() <= 0) return 0;
+    return m_block_size / std::chrono::duration<double>{m_service_time}.count();
+}
+
+} // namespace node
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKDOWNLOAD_H
+#define BITCOIN_NODE_BLOCKDOWNLOAD_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace node {
+
+//! Bounds of the adaptive number of blocks in flight from a single peer
+static constexpr int MIN_BLOCKS_IN_TRANSIT_PER_PEER{2};
+static constexpr int MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER{64};
+//! Number of blocks a peer must have delivered before its measurements are used
+static constexpr uint64_t BLOCK_DOWNLOAD_MIN_SAMPLES{4};
+//! Time it takes to request more blocks from a peer after one arrived, which
+//! its window must also cover: about one cycle of the message handler
+static constexpr auto BLOCK_DOWNLOAD_REFILL_TIME{std::chrono::milliseconds{100}};
+
+/**
+ * Measurements of how fast a peer delivers the blocks we request from it,
+ * used to size its block download window.
+ *
+ * The service time is the time the peer took per block: from the request, or
+ * from the previous block it delivered if that was later. While several
+ * blocks are in flight it is the time between consecutive blocks, which is
+ * what limits the throughput, rather than the round trip each block takes.
+ */
+class BlockDownloadStats
+{
+public:
+    /** Record a requested block of `size` bytes that was received at `now`. */
+    void BlockReceived(std::chrono::microseconds requested, std::chrono::microseconds now, size_t size);
+
+    /** Whether enough blocks were received for the averages to be used. */
+    bool HasEstimate() const { return m_blocks >= BLOCK_DOWNLOAD_MIN_SAMPLES; }
+
+    /**
+     * The number of blocks to keep in flight from this peer: as many as it
+     * delivers in a round trip plus the time to refill its window, within
+     * [MIN_BLOCKS_IN_TRANSIT_PER_PEER, MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER].
+     * `rtt` is the peer's minimum ping time, if known. Before there is an
+     * estimate, `default_window` is returned.
+     */
+    int Window(std::chrono::microseconds rtt, int default_window) const;
+
+    uint64_t Blocks() const { return m_blocks; }
+    uint64_t Bytes() const { return m_bytes; }
+    std::chrono::microseconds Latency() const { return m_latency; }
+    std::chrono::microseconds ServiceTime() const { return m_service_time; }
+    //! Average download rate in bytes per second, or 0 without an estimate
+    double Rate() const;
+
+private:
+    uint64_t m_blocks{0};
+    uint64_t m_bytes{0};
+    //! Moving averages of the time from request to receipt, the service time and the block size
+    std::chrono::microseconds m_latency{0};
+    std::chrono::microseconds m_service_time{0};
+    double m_block_size{0};
+    //! When the last block was received
+    std::chrono::microseconds m_last_received{0};
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKDOWNLOAD_H
@@ -11,7 +11,9 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 namespace node {
 util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Options& opts)
@@ -33,6 +35,13 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, BlockManager::Op
 
     if (auto value{args.GetBoolArg("-fastprune")}) opts.fast_prune = *value;
 
+    if (auto value{args.GetIntArg("-blockservecache")}) {
+        if (*value < 0) {
+            return util::Error{_("The block serving cache cannot be configured with a negative size.")};
+        }
+        opts.serialized_block_cache_bytes = size_t(std::min<int64_t>(*value, std::numeric_limits<int32_t>::max() >> 20)) << 20;
+    }
+
     return {};
 }
 } // namespace node
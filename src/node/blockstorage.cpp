@@ -1166,6 +1166,31 @@ bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatF
     return true;
 }
 
+SerializedBlockCache::Data BlockManager::GetSerializedBlock(const CBlockIndex& index, const CBlock* block, bool cache) const
+{
+    const uint256 hash{index.GetBlockHash()};
+    if (auto data{m_serialized_block_cache.Get(hash, BlockEncoding::STORED)}) return data;
+
+    auto data{std::make_shared<std::vector<uint8_t>>()};
+    if (block) {
+        data->reserve(::GetSerializeSize(*block, CLIENT_VERSION));
+        CVectorWriter{CLIENT_VERSION, *data, 0} << *block;
+    } else if (!ReadRawBlockFromDisk(*data, WITH_LOCK(cs_main, return index.GetBlockPos()))) {
+        return nullptr;
+    }
+    if (cache) m_serialized_block_cache.Insert(hash, BlockEncoding::STORED, data);
+    return data;
+}
+
+bool BlockManager::ReadBlock(CBlock& block, const CBlockIndex& index) const
+{
+    if (const auto data{m_serialized_block_cache.Get(index.GetBlockHash(), BlockEncoding::STORED)}) {
+        SpanReader{CLIENT_VERSION, *data} >> block;
+        return true;
+    }
+    return ReadBlockFromDisk(block, index);
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
@@ -13,6 +13,7 @@
 #include <kernel/chainparams.h>
 #include <kernel/cs_main.h>
 #include <kernel/messagestartchars.h>
+#include <node/blockcache.h>
 #include <sync.h>
 #include <util/fs.h>
 #include <util/hasher.h>
@@ -259,11 +260,15 @@ public:
     explicit BlockManager(const util::SignalInterrupt& interrupt, Options opts)
         : m_prune_mode{opts.prune_target > 0},
           m_opts{std::move(opts)},
-          m_interrupt{interrupt} {};
+          m_interrupt{interrupt},
+          m_serialized_block_cache{m_opts.serialized_block_cache_bytes} {};
 
     const util::SignalInterrupt& m_interrupt;
     std::atomic<bool> m_importing{false};
 
+    //! Serializations of recent blocks, for serving them (see GetSerializedBlock())
+    mutable SerializedBlockCache m_serialized_block_cache;
+
     BlockMap m_block_index GUARDED_BY(cs_main);
 
     /**
@@ -370,6 +375,18 @@ public:
     bool ReadBlockFromDisk(CBlock& block, const CBlockIndex& index) const;
     bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos) const;
 
+    /**
+     * Get a block as stored on disk, which is also how it is relayed: from the
+     * serialized block cache, else by serializing `block` if given, else from
+     * disk. If `cache` is set, a block that was not cached is added.
+     *
+     * @returns nullptr if the block could not be read from disk
+     */
+    SerializedBlockCache::Data GetSerializedBlock(const CBlockIndex& index, const CBlock* block, bool cache) const;
+
+    /** Read a block, deserializing its cached serialization instead of reading it from disk if there is one. */
+    bool ReadBlock(CBlock& block, const CBlockIndex& index) const;
+
     bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex& index) const;
 
     void CleanupBlockRevFiles() const;
@@ -14,5 +14,6 @@ void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
     // databases), but it'd be easy to parse database-specific options by adding
     // a database_type string or enum parameter to this function.
     if (auto value = args.GetBoolArg("-forcecompactdb")) options.force_compact = *value;
+    if (auto value = args.GetIntArg("-dbreadthreads")) options.read_threads = *value;
 }
 } // namespace node
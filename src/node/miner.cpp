@@ -160,7 +160,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     int nDescendantsUpdated = 0;
     if (m_mempool) {
         LOCK(m_mempool->cs);
-        addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        if (m_options.use_cluster_chunks) {
+            addChunks(*m_mempool, nPackagesSelected);
+        } else {
+            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+        }
     }
 
     const auto time_1{SteadyClock::now()};
@@ -260,7 +264,11 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     if (fAddTxs) {
         if (m_mempool) {
             LOCK(m_mempool->cs);
-            addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+            if (m_options.use_cluster_chunks) {
+                addChunks(*m_mempool, nPackagesSelected);
+            } else {
+                addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
+            }
         }
     }
 
@@ -375,6 +383,16 @@ bool BlockAssembler::TestPackageTransactions(const CTxMemPool::setEntries& packa
     return true;
 }
 
+bool BlockAssembler::TestPackageTransactions(const std::vector<CTxMemPool::txiter>& package) const
+{
+    for (CTxMemPool::txiter it : package) {
+        if (!IsFinalTx(it->GetTx(), nHeight, m_lock_time_cutoff)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
 {
     pblocktemplate->block.vtx.emplace_back(iter->GetSharedTx());
@@ -585,6 +603,74 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
 }
 
 
+// Each cluster of the mempool is kept linearized into chunks of decreasing
+// feerate, where every chunk only depends on earlier chunks of its cluster.
+// Merging the chunk lists of all clusters by feerate therefore yields a valid
+// block order, without having to recompute ancestor sets or track modified
+// packages as transactions are added.
+void BlockAssembler::addChunks(const CTxMemPool& mempool, int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    struct NextChunk {
+        const CTxMemPool::ClusterChunks* chunks;
+        size_t pos;
+    };
+    auto lower_feerate{[](const NextChunk& a, const NextChunk& b) {
+        const CTxMemPool::ClusterChunk& ca{(*a.chunks)[a.pos]};
+        const CTxMemPool::ClusterChunk& cb{(*b.chunks)[b.pos]};
+        return double(ca.fee) * cb.vsize < double(cb.fee) * ca.vsize;
+    }};
+    std::vector<NextChunk> heap;
+    for (const CTxMemPool::ClusterChunks* chunks : mempool.GetClusterChunks()) {
+        heap.push_back({chunks, 0});
+    }
+    std::make_heap(heap.begin(), heap.end(), lower_feerate);
+
+    // Limit the number of attempts to add transactions to the block when it is
+    // close to full, as in addPackageTxs().
+    const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
+    int64_t nConsecutiveFailed = 0;
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), lower_feerate);
+        const NextChunk next{heap.back()};
+        heap.pop_back();
+        const CTxMemPool::ClusterChunk& chunk{(*next.chunks)[next.pos]};
+
+        if (chunk.fee < m_options.blockMinFeeRate.GetFee(chunk.vsize)) {
+            // Everything else we might consider has a lower fee rate
+            return;
+        }
+
+        // If a chunk cannot be added, the rest of its cluster is skipped as it
+        // may depend on it.
+        if (!TestPackage(chunk.vsize, chunk.sigop_cost)) {
+            ++nConsecutiveFailed;
+            if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight >
+                    m_options.nBlockMaxWeight - 4000) {
+                // Give up if we're close to full and haven't succeeded in a while
+                break;
+            }
+            continue;
+        }
+        if (!TestPackageTransactions(chunk.txs)) {
+            continue;
+        }
+
+        nConsecutiveFailed = 0;
+        for (CTxMemPool::txiter it : chunk.txs) {
+            AddToBlock(it);
+        }
+        ++nPackagesSelected;
+
+        if (next.pos + 1 < next.chunks->size()) {
+            heap.push_back({next.chunks, next.pos + 1});
+            std::push_heap(heap.begin(), heap.end(), lower_feerate);
+        }
+    }
+}
+
 #ifdef ENABLE_WALLET
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -20,6 +20,10 @@ void ApplyArgsManOptions(const ArgsManager& argsman, PeerManager::Options& optio
         options.max_extra_txs = uint32_t((std::clamp<int64_t>(*value, 0, std::numeric_limits<uint32_t>::max())));
     }
 
+    if (auto value{argsman.GetIntArg("-txacceptbatch")}) {
+        options.max_tx_accept_batch = uint32_t((std::clamp<int64_t>(*value, 1, std::numeric_limits<uint32_t>::max())));
+    }
+
     if (auto value{argsman.GetBoolArg("-capturemessages")}) options.capture_messages = *value;
 
     if (auto value{argsman.GetBoolArg("-blocksonly")}) options.ignore_incoming_txs = *value;
@@ -8,6 +8,8 @@
 #include <clientversion.h>
 #include <common/system.h>
 #include <consensus/amount.h>
+#include <crypto/common.h>
+#include <hash.h>
 #include <kernel/mempool_entry.h>
 #include <logging.h>
 #include <policy/feerate.h>
@@ -61,6 +63,30 @@ struct EncodedDoubleFormatter
     }
 };
 
+/** A confirmed transaction in the journal: blocks it took to confirm and its feerate. */
+struct ConfirmedTxFormatter
+{
+    template<typename Stream> void Ser(Stream& s, const std::pair<unsigned int, double>& v)
+    {
+        s << v.first << Using<EncodedDoubleFormatter>(v.second);
+    }
+
+    template<typename Stream> void Unser(Stream& s, std::pair<unsigned int, double>& v)
+    {
+        s >> v.first >> Using<EncodedDoubleFormatter>(v.second);
+    }
+};
+
+//! Upper bound on the size of a single fee estimates journal record, to detect corruption.
+static constexpr uint32_t MAX_JOURNAL_RECORD_SIZE{32 * 1024 * 1024};
+
+std::chrono::hours GetFileAge(const fs::path& filepath)
+{
+    auto file_time = std::filesystem::last_write_time(filepath);
+    auto now = std::filesystem::file_time_type::clock::now();
+    return std::chrono::duration_cast<std::chrono::hours>(now - file_time);
+}
+
 } // namespace
 
 /**
@@ -110,8 +136,22 @@ private:
     // transactions still unconfirmed after GetMaxConfirms for each bucket
     std::vector<int> oldUnconfTxs;
 
+    // Cumulative sums of unconfTxs over the confirmation count, as seen from
+    // block height m_unconf_sums_height, so that estimates don't have to loop
+    // over all confirmation counts for each bucket:
+    // m_unconf_sums[Y][X] = number of txs in bucket X unconfirmed for Y to GetMaxConfirms() - 1 blocks
+    mutable std::vector<std::vector<int>> m_unconf_sums;
+    mutable unsigned int m_unconf_sums_height{0};
+    mutable bool m_unconf_sums_valid{false};
+
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Recompute m_unconf_sums for the given height, unless it is up to date already. */
+    void UpdateUnconfSums(unsigned int nBlockHeight) const;
+
+    /** Add delta to unconfTxs[blockIndex][bucketindex], keeping m_unconf_sums in sync. */
+    void AdjustUnconfTxs(unsigned int blockIndex, unsigned int bucketindex, int delta);
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -141,6 +181,9 @@ public:
     void removeTx(unsigned int entryHeight, unsigned int nBestSeenHeight,
                   unsigned int bucketIndex, bool inBlock);
 
+    /** Record a transaction that left the mempool unconfirmed after blocksAgo blocks */
+    void RecordFailure(unsigned int blocksAgo, unsigned int bucketindex);
+
     /** Update our estimates by decaying our historical moving average and updating
         with the data gathered from the current block */
     void UpdateMovingAverages();
@@ -198,6 +241,42 @@ void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
         unconfTxs[i].resize(newbuckets);
     }
     oldUnconfTxs.resize(newbuckets);
+    m_unconf_sums_valid = false;
+}
+
+void TxConfirmStats::UpdateUnconfSums(unsigned int nBlockHeight) const
+{
+    if (m_unconf_sums_valid && m_unconf_sums_height == nBlockHeight) return;
+    const unsigned int bins = unconfTxs.size();
+    m_unconf_sums.resize(bins + 1);
+    for (auto& sums : m_unconf_sums) sums.assign(oldUnconfTxs.size(), 0);
+    for (unsigned int confct = bins; confct-- > 0;) {
+        const std::vector<int>& unconf = unconfTxs[(nBlockHeight - confct) % bins];
+        for (unsigned int bucket = 0; bucket < unconf.size(); ++bucket) {
+            m_unconf_sums[confct][bucket] = m_unconf_sums[confct + 1][bucket] + unconf[bucket];
+        }
+    }
+    m_unconf_sums_height = nBlockHeight;
+    m_unconf_sums_valid = true;
+}
+
+void TxConfirmStats::AdjustUnconfTxs(unsigned int blockIndex, unsigned int bucketindex, int delta)
+{
+    unconfTxs[blockIndex][bucketindex] += delta;
+    if (!m_unconf_sums_valid) return;
+    const unsigned int bins = unconfTxs.size();
+    if (m_unconf_sums_height + 1 < bins) {
+        // Below this height the slots wrap around the unsigned range and don't map to
+        // a single confirmation count; just recompute on the next estimate.
+        m_unconf_sums_valid = false;
+        return;
+    }
+    // The slot holds the txs unconfirmed for confct blocks, which are counted
+    // in the sums for all lower confirmation counts.
+    const unsigned int confct = (m_unconf_sums_height % bins + bins - blockIndex) % bins;
+    for (unsigned int i = 0; i <= confct; ++i) {
+        m_unconf_sums[i][bucketindex] += delta;
+    }
 }
 
 // Roll the unconfirmed txs circular buffer
@@ -207,6 +286,7 @@ void TxConfirmStats::ClearCurrent(unsigned int nBlockHeight)
         oldUnconfTxs[j] += unconfTxs[nBlockHeight % unconfTxs.size()][j];
         unconfTxs[nBlockHeight%unconfTxs.size()][j] = 0;
     }
+    m_unconf_sums_valid = false;
 }
 
 
@@ -261,12 +341,14 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int bestFarBucket = maxbucketindex;
 
     bool foundAnswer = false;
-    unsigned int bins = unconfTxs.size();
     bool newBucketRange = true;
     bool passing = true;
     EstimatorBucket passBucket;
     EstimatorBucket failBucket;
 
+    UpdateUnconfSums(nBlockHeight);
+    const std::vector<int>& unconfSums = m_unconf_sums[std::min<unsigned int>(confTarget, GetMaxConfirms())];
+
     // Start counting from highest feerate transactions
     for (int bucket = maxbucketindex; bucket >= 0; --bucket) {
         if (newBucketRange) {
@@ -277,8 +359,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
         nConf += confAvg[periodTarget - 1][bucket];
         totalNum += txCtAvg[bucket];
         failNum += failAvg[periodTarget - 1][bucket];
-        for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
-            extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
+        extraNum += unconfSums[bucket];
         extraNum += oldUnconfTxs[bucket];
         // If we have enough transaction data points in this range of buckets,
         // we can test for success
@@ -461,7 +542,7 @@ unsigned int TxConfirmStats::NewTx(unsigned int nBlockHeight, double val)
 {
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
     unsigned int blockIndex = nBlockHeight % unconfTxs.size();
-    unconfTxs[blockIndex][bucketindex]++;
+    AdjustUnconfTxs(blockIndex, bucketindex, 1);
     return bucketindex;
 }
 
@@ -487,13 +568,18 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
     else {
         unsigned int blockIndex = entryHeight % unconfTxs.size();
         if (unconfTxs[blockIndex][bucketindex] > 0) {
-            unconfTxs[blockIndex][bucketindex]--;
+            AdjustUnconfTxs(blockIndex, bucketindex, -1);
         } else {
             LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy error, mempool tx removed from blockIndex=%u,bucketIndex=%u already\n",
                      blockIndex, bucketindex);
         }
     }
-    if (!inBlock && (unsigned int)blocksAgo >= scale) { // Only counts as a failure if not confirmed for entire period
+    if (!inBlock) RecordFailure(blocksAgo, bucketindex);
+}
+
+void TxConfirmStats::RecordFailure(unsigned int blocksAgo, unsigned int bucketindex)
+{
+    if (blocksAgo >= scale) { // Only counts as a failure if not confirmed for entire period
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
@@ -518,6 +604,12 @@ bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
     AssertLockHeld(m_cs_fee_estimator);
     std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
+        if (pos->second.blockHeight != nBestSeenHeight) {
+            // Txs that were in the mempool when the last block came in are counted in the
+            // estimates, see TxConfirmStats::EstimateMedianVal.
+            m_estimate_cache.clear();
+            if (!inBlock && !m_journal_filepath.empty()) m_journal_failed.emplace_back(nBestSeenHeight - pos->second.blockHeight, pos->second.bucketIndex);
+        }
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
@@ -528,8 +620,9 @@ bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
     }
 }
 
-CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath, const bool read_stale_estimates)
-    : m_estimation_filepath{estimation_filepath}
+CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath, const bool read_stale_estimates, const bool use_journal)
+    : m_estimation_filepath{estimation_filepath},
+      m_journal_filepath{use_journal ? estimation_filepath + ".journal" : fs::path{}}
 {
     static_assert(MIN_BUCKET_FEERATE > 0, "Min feerate must be nonzero");
     size_t bucketIndex = 0;
@@ -550,18 +643,29 @@ CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath
 
     if (est_file.IsNull()) {
         LogPrintf("%s is not found. Continue anyway.\n", fs::PathToString(m_estimation_filepath));
-        return;
-    }
-
-    std::chrono::hours file_age = GetFeeEstimatorFileAge();
-    if (file_age > MAX_FILE_AGE && !read_stale_estimates) {
+    } else if (std::chrono::hours file_age = GetFeeEstimatorFileAge(); file_age > MAX_FILE_AGE && !read_stale_estimates) {
         LogPrintf("Fee estimation file %s too old (age=%lld > %lld hours) and will not be used to avoid serving stale estimates.\n", fs::PathToString(m_estimation_filepath), Ticks<std::chrono::hours>(file_age), Ticks<std::chrono::hours>(MAX_FILE_AGE));
-        return;
+    } else if (!Read(est_file)) {
+        LogPrintf("Failed to read fee estimates from %s. Continue anyway.\n", fs::PathToString(m_estimation_filepath));
     }
 
-    if (!Read(est_file)) {
-        LogPrintf("Failed to read fee estimates from %s. Continue anyway.\n", fs::PathToString(m_estimation_filepath));
+    if (m_journal_filepath.empty()) return;
+    AutoFile journal_file{fsbridge::fopen(m_journal_filepath, "rb")};
+    if (journal_file.IsNull()) return;
+    if (std::chrono::hours file_age = GetFileAge(m_journal_filepath); file_age > MAX_FILE_AGE && !read_stale_estimates) {
+        LogPrintf("Fee estimation journal %s too old (age=%lld > %lld hours) and will not be used to avoid serving stale estimates.\n", fs::PathToString(m_journal_filepath), Ticks<std::chrono::hours>(file_age), Ticks<std::chrono::hours>(MAX_FILE_AGE));
+        // New records must not be appended to the ones that were skipped.
+        journal_file.fclose();
+        std::error_code ec;
+        fs::remove(m_journal_filepath, ec);
+        return;
     }
+    const unsigned int num_records{ReplayJournal(journal_file)};
+    journal_file.fclose();
+    LogPrintf("Replayed %u blocks of fee estimation data from %s.\n", num_records, fs::PathToString(m_journal_filepath.filename()));
+    // Fold the journal into a new fee_estimates.dat, so that new records aren't appended
+    // after a record that was cut short.
+    FlushFeeEstimates();
 }
 
 CBlockPolicyEstimator::~CBlockPolicyEstimator() = default;
@@ -630,6 +734,7 @@ bool CBlockPolicyEstimator::processBlockTx(unsigned int nBlockHeight, const CTxM
     feeStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
     shortStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
     longStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+    if (!m_journal_filepath.empty()) m_journal_confirmed.emplace_back(blocksToConfirm, (double)feeRate.GetFeePerK());
     return true;
 }
 
@@ -646,6 +751,8 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
         return;
     }
 
+    m_estimate_cache.clear();
+
     // Must update nBestSeenHeight in sync with ClearCurrent so that
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
@@ -680,6 +787,8 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    if (!m_journal_filepath.empty()) AppendJournal(nBlockHeight);
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -839,6 +948,25 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(m_cs_fee_estimator);
 
+    // Only cache results for targets we track, so the cache stays bounded.
+    if (confTarget <= 0 || (unsigned int)confTarget > longStats->GetMaxConfirms()) {
+        return estimateSmartFeeUncached(confTarget, feeCalc, conservative);
+    }
+    const auto key{std::make_pair(confTarget, conservative)};
+    auto it{m_estimate_cache.find(key)};
+    if (it == m_estimate_cache.end()) {
+        CachedEstimate estimate;
+        estimate.feerate = estimateSmartFeeUncached(confTarget, &estimate.calc, conservative);
+        it = m_estimate_cache.emplace(key, std::move(estimate)).first;
+    }
+    if (feeCalc) *feeCalc = it->second.calc;
+    return it->second.feerate;
+}
+
+CFeeRate CBlockPolicyEstimator::estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -921,17 +1049,31 @@ void CBlockPolicyEstimator::Flush() {
 void CBlockPolicyEstimator::FlushFeeEstimates()
 {
     AutoFile est_file{fsbridge::fopen(m_estimation_filepath, "wb")};
-    if (est_file.IsNull() || !Write(est_file)) {
+    LOCK(m_cs_fee_estimator);
+    if (est_file.IsNull() || !_Write(est_file) || est_file.fclose() != 0) {
         LogPrintf("Failed to write fee estimates to %s. Continue anyway.\n", fs::PathToString(m_estimation_filepath));
     } else {
         LogPrintf("Flushed fee estimates to %s.\n", fs::PathToString(m_estimation_filepath.filename()));
+        if (!m_journal_filepath.empty()) {
+            // Everything in the journal is part of the file just written.
+            m_journal_confirmed.clear();
+            m_journal_failed.clear();
+            std::error_code ec;
+            fs::remove(m_journal_filepath, ec);
+        }
     }
 }
 
 bool CBlockPolicyEstimator::Write(AutoFile& fileout) const
 {
+    LOCK(m_cs_fee_estimator);
+    return _Write(fileout);
+}
+
+bool CBlockPolicyEstimator::_Write(AutoFile& fileout) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
     try {
-        LOCK(m_cs_fee_estimator);
         fileout << 149900; // version required to read: 0.14.99 or later
         fileout << CLIENT_VERSION; // version that wrote the file
         fileout << nBestSeenHeight;
@@ -1006,6 +1148,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            m_estimate_cache.clear();
         }
     }
     catch (const std::exception& e) {
@@ -1015,6 +1158,84 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
     return true;
 }
 
+void CBlockPolicyEstimator::AppendJournal(unsigned int nBlockHeight)
+{
+    AssertLockHeld(m_cs_fee_estimator);
+    // Each record is the size and the double-SHA256 based checksum of the data,
+    // so that a record cut short by a crash is detected when replaying.
+    DataStream record{};
+    record << nBlockHeight;
+    record << Using<VectorFormatter<ConfirmedTxFormatter>>(m_journal_confirmed);
+    record << m_journal_failed;
+    m_journal_confirmed.clear();
+    m_journal_failed.clear();
+
+    AutoFile journal_file{fsbridge::fopen(m_journal_filepath, "ab")};
+    try {
+        if (journal_file.IsNull()) throw std::runtime_error("unable to open file");
+        journal_file << static_cast<uint32_t>(record.size()) << Span{record} << ReadLE32(Hash(record).begin());
+        if (journal_file.fclose() != 0) throw std::runtime_error("unable to close file");
+    } catch (const std::exception& e) {
+        LogPrint(BCLog::ESTIMATEFEE, "Failed to append to fee estimation journal %s (non-fatal): %s\n", fs::PathToString(m_journal_filepath), e.what());
+    }
+}
+
+unsigned int CBlockPolicyEstimator::ReplayJournal(AutoFile& filein)
+{
+    LOCK(m_cs_fee_estimator);
+    unsigned int num_records{0};
+    try {
+        while (true) {
+            uint32_t size;
+            filein >> size;
+            if (size > MAX_JOURNAL_RECORD_SIZE) throw std::runtime_error("record too large");
+            DataStream record{};
+            record.resize(size);
+            filein.read(record);
+            uint32_t checksum;
+            filein >> checksum;
+            if (checksum != ReadLE32(Hash(record).begin())) throw std::runtime_error("checksum mismatch");
+
+            unsigned int height;
+            std::vector<std::pair<unsigned int, double>> confirmed;
+            std::vector<std::pair<unsigned int, unsigned int>> failed;
+            record >> height >> Using<VectorFormatter<ConfirmedTxFormatter>>(confirmed) >> failed;
+            if (height <= nBestSeenHeight) continue;
+
+            // Same order of updates as processBlock, so the result is identical. There are no
+            // mempool txs tracked yet, so there are no unconfirmed counts to update.
+            for (const auto& [blocks_ago, bucket_index] : failed) {
+                if (bucket_index >= buckets.size()) throw std::runtime_error("bucket index out of range");
+                feeStats->RecordFailure(blocks_ago, bucket_index);
+                shortStats->RecordFailure(blocks_ago, bucket_index);
+                longStats->RecordFailure(blocks_ago, bucket_index);
+            }
+            nBestSeenHeight = height;
+            feeStats->UpdateMovingAverages();
+            shortStats->UpdateMovingAverages();
+            longStats->UpdateMovingAverages();
+            for (const auto& [blocks_to_confirm, feerate] : confirmed) {
+                feeStats->Record(blocks_to_confirm, feerate);
+                shortStats->Record(blocks_to_confirm, feerate);
+                longStats->Record(blocks_to_confirm, feerate);
+            }
+            if (!confirmed.empty()) {
+                // The replayed blocks extend the history read from fee_estimates.dat.
+                if (historicalFirst == 0) historicalFirst = height;
+                historicalBest = height;
+            }
+            ++num_records;
+        }
+    } catch (const std::exception& e) {
+        // Reaching the end of the file is the expected way out of the loop.
+        if (!filein.feof()) {
+            LogPrint(BCLog::ESTIMATEFEE, "Stopped replaying fee estimation journal (non-fatal): %s\n", e.what());
+        }
+    }
+    m_estimate_cache.clear();
+    return num_records;
+}
+
 void CBlockPolicyEstimator::FlushUnconfirmed()
 {
     const auto startclear{SteadyClock::now()};
@@ -1031,9 +1252,7 @@ void CBlockPolicyEstimator::FlushUnconfirmed()
 
 std::chrono::hours CBlockPolicyEstimator::GetFeeEstimatorFileAge()
 {
-    auto file_time = std::filesystem::last_write_time(m_estimation_filepath);
-    auto now = std::filesystem::file_time_type::clock::now();
-    return std::chrono::duration_cast<std::chrono::hours>(now - file_time);
+    return GetFileAge(m_estimation_filepath);
 }
 
 static std::set<double> MakeFeeSet(const CFeeRate& min_incremental_fee,
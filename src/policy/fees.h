@@ -19,6 +19,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -142,6 +143,10 @@ struct FeeCalculation
  *  We want to be able to estimate feerates that are needed on tx's to be included in
  * a certain number of blocks.  Every time a block is added to the best chain, this class records
  * stats on the transactions included in that block
+ *
+ * The stats are written to fee_estimates.dat periodically and at shutdown. In between, the
+ * data points recorded for each block are appended to a journal next to it, which is replayed
+ * on top of fee_estimates.dat at startup so that an unclean shutdown loses little history.
  */
 class CBlockPolicyEstimator
 {
@@ -195,9 +200,11 @@ private:
     static constexpr double FEE_SPACING = 1.05;
 
     const fs::path m_estimation_filepath;
+    //! Journal of the data recorded since fee_estimates.dat was written, empty if not journaling
+    const fs::path m_journal_filepath;
 public:
     /** Create new BlockPolicyEstimator and initialize stats tracking classes with default values */
-    CBlockPolicyEstimator(const fs::path& estimation_filepath, const bool read_stale_estimates);
+    CBlockPolicyEstimator(const fs::path& estimation_filepath, const bool read_stale_estimates, const bool use_journal = true);
     ~CBlockPolicyEstimator();
 
     /** Process all the transactions that have been included in a block */
@@ -289,9 +296,26 @@ private:
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
     std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
 
+    //! Confirmed txs (blocks to confirm, feerate) and failed txs (blocks unconfirmed, bucket
+    //! index) recorded since the last journal record was written
+    std::vector<std::pair<unsigned int, double>> m_journal_confirmed GUARDED_BY(m_cs_fee_estimator);
+    std::vector<std::pair<unsigned int, unsigned int>> m_journal_failed GUARDED_BY(m_cs_fee_estimator);
+
+    struct CachedEstimate
+    {
+        CFeeRate feerate;
+        FeeCalculation calc;
+    };
+    /** Results of estimateSmartFee() by target and conservative flag. Only the data recorded when
+     *  blocks come in (or txs leave the mempool after having seen a block) changes the estimates,
+     *  so this is cleared at those points rather than for every new mempool transaction. */
+    mutable std::map<std::pair<int, bool>, CachedEstimate> m_estimate_cache GUARDED_BY(m_cs_fee_estimator);
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** Helper for estimateSmartFee, bypassing the cache */
+    CFeeRate estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
@@ -306,6 +330,19 @@ private:
     /** A non-thread-safe helper for the removeTx function */
     bool _removeTx(const uint256& hash, bool inBlock)
         EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** A non-thread-safe helper for the Write function */
+    bool _Write(AutoFile& fileout) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** Append the data recorded for a block to the journal */
+    void AppendJournal(unsigned int nBlockHeight)
+        EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+
+    /** Apply the journal records for blocks after nBestSeenHeight, up to the first incomplete
+     *  record. Returns the number of records applied. */
+    unsigned int ReplayJournal(AutoFile& filein)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
 };
 
 class FeeFilterRounder
@@ -12,6 +12,7 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
+#include <node/blockcache.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -29,8 +30,10 @@
 #include <validation.h>
 #include <version.h>
 
+#include <algorithm>
 #include <any>
 #include <string>
+#include <vector>
 
 #include <univalue.h>
 
@@ -39,6 +42,12 @@ using node::NodeContext;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+//! Maximum number of headers streamed by one /rest/headerrange/ request
+static constexpr unsigned int MAX_REST_HEADER_RANGE_RESULTS = 100000;
+//! Maximum number of blocks streamed by one /rest/blockrange/ request
+static constexpr unsigned int MAX_REST_BLOCK_RANGE_RESULTS = 1000;
+//! Number of headers serialized into each chunk of a /rest/headerrange/ reply
+static constexpr size_t REST_HEADER_RANGE_CHUNK = 2000;
 
 static const struct {
     RESTResponseFormat rf;
@@ -277,6 +286,24 @@ static bool rest_headers(const std::any& context,
     }
 }
 
+/**
+ * Get a block in the serialization REST clients get. Blocks are stored on
+ * disk with witness data, so unless -rpcserialversion=0 is set they are
+ * served as stored, without being deserialized, and blocks near the tip
+ * from the serialized block cache shared with P2P block serving.
+ */
+static node::SerializedBlockCache::Data GetSerializedBlock(const node::BlockManager& blockman, const CBlockIndex& index, bool cache)
+{
+    if (RPCSerializationFlags() == 0) {
+        return blockman.GetSerializedBlock(index, nullptr, cache);
+    }
+    CBlock block;
+    if (!blockman.ReadBlock(block, index)) return nullptr;
+    auto data{std::make_shared<std::vector<uint8_t>>()};
+    CVectorWriter{PROTOCOL_VERSION | RPCSerializationFlags(), *data, 0} << block;
+    return data;
+}
+
 static bool rest_block(const std::any& context,
                        HTTPRequest* req,
                        const std::string& strURIPart,
@@ -291,7 +318,6 @@ static bool rest_block(const std::any& context,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
     const CBlockIndex* pblockindex = nullptr;
     const CBlockIndex* tip = nullptr;
     ChainstateManager* maybe_chainman = GetChainman(context, req);
@@ -307,33 +333,36 @@ static bool rest_block(const std::any& context,
 
         if (chainman.m_blockman.IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
-
-    }
-
-    if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
+    const bool cache_block{pblockindex->nHeight >= tip->nHeight - node::SERIALIZED_BLOCK_CACHE_DEPTH};
 
     switch (rf) {
     case RESTResponseFormat::BINARY: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string binaryBlock = ssBlock.str();
+        const auto block_data{GetSerializedBlock(chainman.m_blockman, *pblockindex, cache_block)};
+        if (!block_data) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, MakeByteSpan(*block_data));
         return true;
     }
 
     case RESTResponseFormat::HEX: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock) + "\n";
+        const auto block_data{GetSerializedBlock(chainman.m_blockman, *pblockindex, cache_block)};
+        if (!block_data) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
+        std::string strHex = HexStr(*block_data) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RESTResponseFormat::JSON: {
+        CBlock block;
+        if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
         UniValue objBlock = blockToJSON(chainman.m_blockman, block, tip, pblockindex, tx_verbosity);
         std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
@@ -357,6 +386,127 @@ static bool rest_block_notxdetails(const std::any& context, HTTPRequest* req, co
     return rest_block(context, req, strURIPart, TxVerbosity::SHOW_TXID);
 }
 
+/**
+ * Parse a /rest/<endpoint>/<hash>.bin?count=<count> request, and look up the
+ * (at most count) consecutive blocks of the active chain starting at hash.
+ *
+ * @returns false if an error reply was sent.
+ */
+static bool ParseChainRange(const std::any& context, HTTPRequest* req, const std::string& strURIPart,
+                            const std::string& endpoint, unsigned int max_count,
+                            std::vector<const CBlockIndex*>& range)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RESTResponseFormat rf = ParseDataFormat(hashStr, strURIPart);
+    if (rf != RESTResponseFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin)");
+    }
+
+    std::string raw_count;
+    try {
+        raw_count = req->GetQueryParameter("count").value_or("1");
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    const auto parsed_count{ToIntegral<unsigned int>(raw_count)};
+    if (!parsed_count.has_value() || *parsed_count < 1 || *parsed_count > max_count) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Count is invalid or out of acceptable range (1-%u): %s", max_count, raw_count));
+    }
+
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Invalid hash: %s. Expected /rest/%s/<hash>.bin?count=<count>", hashStr, endpoint));
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    ChainstateManager& chainman = *maybe_chainman;
+    LOCK(cs_main);
+    const CChain& active_chain = chainman.ActiveChain();
+    const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(hash);
+    if (!pindex || !active_chain.Contains(pindex)) {
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found in active chain");
+    }
+    const int end_height{std::min<int>(active_chain.Height(), pindex->nHeight + *parsed_count - 1)};
+    range.reserve(end_height - pindex->nHeight + 1);
+    for (int height = pindex->nHeight; height <= end_height; ++height) {
+        range.push_back(active_chain[height]);
+    }
+    return true;
+}
+
+/**
+ * Stream up to count consecutive headers of the active chain. Headers use the
+ * same serialization as in the P2P headers message, which includes the stake
+ * prevout and block signature of proof-of-stake blocks.
+ */
+static bool rest_header_range(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    std::vector<const CBlockIndex*> range;
+    if (!ParseChainRange(context, req, strURIPart, "headerrange", MAX_REST_HEADER_RANGE_RESULTS, range)) {
+        return false;
+    }
+
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->StartChunkedReply(HTTP_OK);
+    for (size_t begin = 0; begin < range.size(); begin += REST_HEADER_RANGE_CHUNK) {
+        const size_t end{std::min(range.size(), begin + REST_HEADER_RANGE_CHUNK)};
+        std::vector<unsigned char> chunk;
+        CVectorWriter writer{PROTOCOL_VERSION, chunk, 0};
+        for (size_t i = begin; i < end; ++i) {
+            writer << range[i]->GetBlockHeader();
+        }
+        if (!req->WriteReplyChunk(std::move(chunk))) break;
+    }
+    req->EndChunkedReply();
+    return true;
+}
+
+/**
+ * Stream up to count consecutive blocks of the active chain, read from the
+ * block files one at a time, so memory use does not depend on the count.
+ */
+static bool rest_block_range(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    std::vector<const CBlockIndex*> range;
+    if (!ParseChainRange(context, req, strURIPart, "blockrange", MAX_REST_BLOCK_RANGE_RESULTS, range)) {
+        return false;
+    }
+
+    ChainstateManager& chainman = *Assert(GetChainman(context, req));
+    int cache_min_height;
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* pindex : range) {
+            if (chainman.m_blockman.IsBlockPruned(pindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, pindex->GetBlockHash().GetHex() + " not available (pruned data)");
+            }
+        }
+        cache_min_height = chainman.ActiveChain().Height() - node::SERIALIZED_BLOCK_CACHE_DEPTH;
+    }
+
+    // Check the first block can be read, so the common failure is reported
+    // before the reply is started. Later failures can only end it early.
+    auto block_data{GetSerializedBlock(chainman.m_blockman, *range.front(), range.front()->nHeight >= cache_min_height)};
+    if (!block_data) {
+        return RESTERR(req, HTTP_NOT_FOUND, range.front()->GetBlockHash().GetHex() + " not found");
+    }
+
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->StartChunkedReply(HTTP_OK);
+    for (size_t i = 0; i < range.size(); ++i) {
+        if (i > 0 && !(block_data = GetSerializedBlock(chainman.m_blockman, *range[i], range[i]->nHeight >= cache_min_height))) {
+            LogPrintf("REST: failed to read block %s, ending block range reply early\n", range[i]->GetBlockHash().ToString());
+            break;
+        }
+        if (!req->WriteReplyChunk(std::move(block_data))) break;
+    }
+    req->EndChunkedReply();
+    return true;
+}
+
 static bool rest_filter_header(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req)) return false;
@@ -1012,6 +1162,8 @@ static const struct {
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/", rest_mempool},
       {"/rest/headers/", rest_headers},
+      {"/rest/headerrange/", rest_header_range},
+      {"/rest/blockrange/", rest_block_range},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
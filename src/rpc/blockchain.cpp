@@ -11,6 +11,7 @@
 #include <clientversion.h>
 #include <coins.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
@@ -29,6 +30,7 @@
 #include <node/transaction.h>
 #include <node/utxo_snapshot.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -51,6 +53,7 @@
 #include <stdint.h>
 
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -168,19 +171,24 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
-UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+/** Header fields and sizes of a block, i.e. everything blockToJSON returns but the transactions. */
+static UniValue blockSummaryToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex)
 {
     UniValue result = blockheaderToJSON(tip, blockindex);
 
     result.pushKV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
     result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
     result.pushKV("weight", (int)::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
+    return result;
+}
 
+/** Pass the JSON of each transaction of the block to fn, in order. */
+static void blockTxsToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* blockindex, TxVerbosity verbosity, const std::function<void(UniValue&&)>& fn)
+{
     switch (verbosity) {
         case TxVerbosity::SHOW_TXID:
             for (const CTransactionRef& tx : block.vtx) {
-                txs.push_back(tx->GetHash().GetHex());
+                fn(UniValue{tx->GetHash().GetHex()});
             }
             break;
 
@@ -196,16 +204,34 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
                 const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
                 UniValue objTx(UniValue::VOBJ);
                 TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, RPCSerializationFlags(), txundo, verbosity);
-                txs.push_back(std::move(objTx));
+                fn(std::move(objTx));
             }
             break;
     }
+}
+
+UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+{
+    UniValue result = blockSummaryToJSON(block, tip, blockindex);
 
+    UniValue txs(UniValue::VARR);
+    blockTxsToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) { txs.push_back(std::move(tx)); });
     result.pushKV("tx", std::move(txs));
 
     return result;
 }
 
+void blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity, JSONStreamWriter& out)
+{
+    out.BeginObject();
+    out.ObjectMembers(blockSummaryToJSON(block, tip, blockindex));
+    out.Key("tx");
+    out.BeginArray();
+    blockTxsToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) { out.Value(tx); });
+    out.EndArray();
+    out.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -761,6 +787,12 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
+    if (tx_verbosity != TxVerbosity::SHOW_TXID && request.result_stream) {
+        // Send the decoded transactions as they are produced instead of
+        // building the whole result in memory first.
+        blockToJSON(chainman.m_blockman, block, tip, pblockindex, tx_verbosity, request.result_stream->Start());
+        return UniValue{};
+    }
     return blockToJSON(chainman.m_blockman, block, tip, pblockindex, tx_verbosity);
 },
     };
@@ -864,7 +896,8 @@ static std::optional<kernel::CCoinsStats> GetUTXOStats(CCoinsView* view, node::B
     // best block.
     CHECK_NONFATAL(!pindex || pindex->GetBlockHash() == view->GetBestBlock());
 
-    return kernel::ComputeUTXOStats(hash_type, view, blockman, interruption_point);
+    return kernel::ComputeUTXOStats(hash_type, view, blockman, interruption_point,
+                                    /*muhash_threads=*/std::clamp(GetNumCores() - 1, 0, kernel::MAX_MUHASH_THREADS));
 }
 
 static RPCHelpMan gettxoutsetinfo()
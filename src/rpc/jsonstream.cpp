@@ -0,0 +1,89 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+
+#include <util/check.h>
+
+#include <utility>
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t chunk_size)
+    : m_sink{std::move(sink)}, m_chunk_size{chunk_size}
+{
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONStreamWriter::BeginValue()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (m_empty.empty()) return;
+    if (!m_empty.back()) m_buffer += ',';
+    m_empty.back() = false;
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    m_buffer += '{';
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    m_buffer += '}';
+    m_empty.pop_back();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    m_buffer += '[';
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    m_buffer += ']';
+    m_empty.pop_back();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Key(std::string_view key)
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    BeginValue();
+    // A string value is escaped the same way as a key.
+    m_buffer += UniValue{std::string{key}}.write();
+    m_buffer += ':';
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    BeginValue();
+    m_buffer += value.write();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::ObjectMembers(const UniValue& obj)
+{
+    const std::vector<std::string>& keys{obj.getKeys()};
+    const std::vector<UniValue>& values{obj.getValues()};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        KeyValue(keys[i], values[i]);
+    }
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    m_sink(m_buffer);
+    m_buffer.clear();
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <univalue.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Writes a JSON document incrementally, passing the text to a sink in chunks
+ * of about chunk_size bytes, so that large documents never have to be held in
+ * memory as a whole. The output is identical to UniValue::write() of the
+ * equivalent UniValue.
+ *
+ * Values are written by opening and closing objects and arrays, and by
+ * writing complete UniValue values (for instance one per array element).
+ */
+class JSONStreamWriter
+{
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE{64 * 1024};
+
+    explicit JSONStreamWriter(Sink sink, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the name of the next member of the current object. */
+    void Key(std::string_view key);
+    /** Write a complete value, as an array element or after Key(). */
+    void Value(const UniValue& value);
+    void KeyValue(std::string_view key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    /** Write all members of an object value into the current object. */
+    void ObjectMembers(const UniValue& obj);
+
+    /** Pass everything written so far to the sink. */
+    void Flush();
+
+private:
+    void BeginValue();
+    void MaybeFlush()
+    {
+        if (m_buffer.size() >= m_chunk_size) Flush();
+    }
+
+    const Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    //! For each object or array being written, whether nothing was written to it yet
+    std::vector<bool> m_empty;
+    //! Whether a key was just written, so the next value doesn't need a separator
+    bool m_after_key{false};
+};
+
+/**
+ * Lets an RPC method stream its result to the client instead of returning it,
+ * see JSONRPCRequest::result_stream.
+ */
+class RPCResultStream
+{
+public:
+    virtual ~RPCResultStream() = default;
+
+    /**
+     * Start sending the reply and return the writer for the result. The method
+     * has to write exactly one JSON value to it, and return a null UniValue.
+     * Errors can't be reported to the client once the reply has started, so
+     * all checks should be done before calling this.
+     */
+    virtual JSONStreamWriter& Start() = 0;
+
+    /** Whether Start() was called. */
+    virtual bool Started() const = 0;
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
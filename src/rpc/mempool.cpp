@@ -14,6 +14,8 @@
 #include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
+#include <rpc/mempool.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -23,7 +25,10 @@
 #include <util/moneystr.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <string>
 #include <utility>
+#include <vector>
 
 using kernel::DumpMempool;
 
@@ -376,6 +381,40 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+void MempoolToJSON(const CTxMemPool& pool, JSONStreamWriter& out)
+{
+    std::vector<uint256> txids;
+    {
+        LOCK(pool.cs);
+        const auto entries{pool.entryAll()};
+        txids.reserve(entries.size());
+        for (const CTxMemPoolEntry& e : entries) {
+            txids.push_back(e.GetTx().GetHash());
+        }
+    }
+    out.BeginObject();
+    std::vector<std::pair<std::string, UniValue>> batch;
+    for (size_t start{0}; start < txids.size(); start += MEMPOOL_JSON_BATCH_SIZE) {
+        batch.clear();
+        {
+            LOCK(pool.cs);
+            for (size_t i{start}; i < std::min(start + MEMPOOL_JSON_BATCH_SIZE, txids.size()); ++i) {
+                // Skip transactions that left the mempool since the snapshot.
+                const auto it{pool.GetIter(txids[i])};
+                if (!it) continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(pool, info, **it);
+                batch.emplace_back(txids[i].ToString(), std::move(info));
+            }
+        }
+        // Write outside of the lock, writing may block until the client has read enough.
+        for (const auto& [txid, info] : batch) {
+            out.KeyValue(txid, info);
+        }
+    }
+    out.EndObject();
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -421,6 +460,10 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
+    if (fVerbose && !include_mempool_sequence && request.result_stream) {
+        MempoolToJSON(EnsureAnyMemPool(request.context), request.result_stream->Start());
+        return UniValue{};
+    }
     return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
 },
     };
@@ -5,13 +5,28 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <cstddef>
+
 class CTxMemPool;
+class JSONStreamWriter;
 class UniValue;
 
+//! Number of mempool entries converted to JSON per mempool lock when streaming
+static constexpr size_t MEMPOOL_JSON_BATCH_SIZE{1000};
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/**
+ * Verbose mempool to a JSON stream, with the same output as MempoolToJSON(pool, true).
+ * The entries are read in batches of MEMPOOL_JSON_BATCH_SIZE, without holding
+ * the mempool lock in between, so the result is not an atomic snapshot: an
+ * entry reflects the mempool at the time its batch was read, and transactions
+ * that were removed in the meantime are left out.
+ */
+void MempoolToJSON(const CTxMemPool& pool, JSONStreamWriter& out);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
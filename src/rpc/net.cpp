@@ -147,6 +147,15 @@ static RPCHelpMan getpeerinfo()
                     {
                         {RPCResult::Type::NUM, "n", "The heights of blocks we're currently asking from this peer"},
                     }},
+                    {RPCResult::Type::OBJ, "blockdownload", "How fast this peer delivers the blocks we request from it",
+                    {
+                        {RPCResult::Type::NUM, "window", "The number of blocks we keep in flight from this peer, sized by its measured speed"},
+                        {RPCResult::Type::NUM, "blocks", "The number of requested blocks received from this peer"},
+                        {RPCResult::Type::NUM, "bytes", "The total size of those blocks"},
+                        {RPCResult::Type::NUM, "latency", "The average time in seconds from requesting a block to receiving it"},
+                        {RPCResult::Type::NUM, "servicetime", "The average time in seconds the peer took per block, which is shorter than the latency while several blocks are in flight"},
+                        {RPCResult::Type::NUM, "rate", "The average download rate in bytes per second, or 0 if too few blocks were received to tell"},
+                    }},
                     {RPCResult::Type::BOOL, "addr_relay_enabled", "Whether we participate in address relay with this peer"},
                     {RPCResult::Type::NUM, "addr_processed", "The total number of addresses processed, excluding those dropped due to rate limiting"},
                     {RPCResult::Type::NUM, "addr_rate_limited", "The total number of addresses dropped due to rate limiting"},
@@ -253,6 +262,14 @@ static RPCHelpMan getpeerinfo()
             heights.push_back(height);
         }
         obj.pushKV("inflight", heights);
+        UniValue block_download(UniValue::VOBJ);
+        block_download.pushKV("window", statestats.m_block_download_window);
+        block_download.pushKV("blocks", statestats.m_block_download.Blocks());
+        block_download.pushKV("bytes", statestats.m_block_download.Bytes());
+        block_download.pushKV("latency", Ticks<SecondsDouble>(statestats.m_block_download.Latency()));
+        block_download.pushKV("servicetime", Ticks<SecondsDouble>(statestats.m_block_download.ServiceTime()));
+        block_download.pushKV("rate", statestats.m_block_download.Rate());
+        obj.pushKV("blockdownload", block_download);
         obj.pushKV("addr_relay_enabled", statestats.m_addr_relay_enabled);
         obj.pushKV("addr_processed", statestats.m_addr_processed);
         obj.pushKV("addr_rate_limited", statestats.m_addr_rate_limited);
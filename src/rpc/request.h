@@ -11,6 +11,8 @@
 
 #include <univalue.h>
 
+class RPCResultStream;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -36,6 +38,8 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    //! If set, large results may be streamed to the client through it instead of being returned
+    RPCResultStream* result_stream{nullptr};
 
     void parse(const UniValue& valRequest);
 };
@@ -7,6 +7,7 @@
 
 #include <common/args.h>
 #include <common/system.h>
+#include <httpserver.h>
 #include <logging.h>
 #include <rpc/util.h>
 #include <shutdown.h>
@@ -17,11 +18,16 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 static GlobalMutex g_rpc_warmup_mutex;
 static std::atomic<bool> g_rpc_running{false};
@@ -224,6 +230,18 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::OBJ, "work_queue", /*optional=*/true, "Statistics of the HTTP work queue, if the HTTP server is running",
+                        {
+                            {RPCResult::Type::NUM, "depth", "Number of requests waiting for a worker thread"},
+                            {RPCResult::Type::NUM, "max_depth", "Depth above which new connections are not accepted until the queue drained (-rpcworkqueue)"},
+                            {RPCResult::Type::NUM, "requests", "Total number of requests queued"},
+                            {RPCResult::Type::NUM, "rejected", "Number of requests rejected because the queue was full"},
+                            {RPCResult::Type::NUM, "stolen", "Number of requests a worker thread took over from another one"},
+                            {RPCResult::Type::NUM, "backpressure", "Number of times accepting new connections was paused"},
+                            {RPCResult::Type::NUM, "wait_p50", "Estimated median time requests waited in the queue, in microseconds"},
+                            {RPCResult::Type::NUM, "wait_p99", "Estimated 99th percentile of the time requests waited in the queue, in microseconds"},
+                            {RPCResult::Type::NUM, "wait_max", "Longest time a request waited in the queue, in microseconds"},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -247,6 +265,20 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    if (const auto stats{GetHTTPWorkQueueStats()}) {
+        UniValue work_queue(UniValue::VOBJ);
+        work_queue.pushKV("depth", uint64_t{stats->depth});
+        work_queue.pushKV("max_depth", uint64_t{stats->max_depth});
+        work_queue.pushKV("requests", stats->requests);
+        work_queue.pushKV("rejected", stats->rejected);
+        work_queue.pushKV("stolen", stats->stolen);
+        work_queue.pushKV("backpressure", stats->backpressure);
+        work_queue.pushKV("wait_p50", int64_t{stats->wait_p50.count()});
+        work_queue.pushKV("wait_p99", int64_t{stats->wait_p99.count()});
+        work_queue.pushKV("wait_max", int64_t{stats->wait_max.count()});
+        result.pushKV("work_queue", work_queue);
+    }
+
     return result;
 }
     };
@@ -379,12 +411,96 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+/**
+ * Methods that only read state, so that the requests of a batch made up of
+ * them can be executed in parallel and in any order.
+ */
+static const std::set<std::string> PARALLEL_BATCH_METHODS{
+    "decodepsbt",
+    "decoderawtransaction",
+    "decodescript",
+    "getbestblockhash",
+    "getblock",
+    "getblockcount",
+    "getblockfilter",
+    "getblockhash",
+    "getblockheader",
+    "getblockstats",
+    "getmempoolancestors",
+    "getmempooldescendants",
+    "getmempoolentry",
+    "getrawtransaction",
+    "gettxout",
+    "gettxoutproof",
+    "validateaddress",
+    "verifytxoutproof",
+};
+
+static bool CanExecuteInParallel(const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    for (const UniValue& req : vReq.getValues()) {
+        // Malformed requests only produce an error reply, in any order
+        if (!req.isObject()) continue;
+        const UniValue& method{req.find_value("method")};
+        if (method.isStr() && !PARALLEL_BATCH_METHODS.count(method.get_str())) return false;
+    }
+    return true;
+}
+
+namespace {
+/** The requests of a batch, shared by the threads executing them. */
+struct BatchExecution {
+    const JSONRPCRequest jreq;
+    const UniValue requests;
+    //! One reply per request, each only written by the thread executing the request
+    std::vector<UniValue> replies;
+    std::atomic<size_t> next{0};
+    Mutex mutex;
+    std::condition_variable cv;
+    size_t done GUARDED_BY(mutex){0};
+
+    BatchExecution(const JSONRPCRequest& jreq_in, const UniValue& requests_in)
+        : jreq{jreq_in}, requests{requests_in}, replies(requests_in.size()) {}
 
+    //! Execute requests until none are left
+    void Run() EXCLUSIVE_LOCKS_REQUIRED(!mutex)
+    {
+        for (size_t i{next++}; i < requests.size(); i = next++) {
+            replies[i] = JSONRPCExecOne(jreq, requests[i]);
+            LOCK(mutex);
+            if (++done == requests.size()) cv.notify_all();
+        }
+    }
+};
+} // namespace
+
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskRunner& run_task, int max_threads)
+{
+    const size_t helpers{vReq.size() > 1 && run_task ? std::min<size_t>(std::max(max_threads, 1) - 1, vReq.size() - 1) : 0};
+    if (helpers == 0 || !CanExecuteInParallel(vReq)) {
+        UniValue ret(UniValue::VARR);
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+
+        return ret.write() + "\n";
+    }
+
+    // Queued helpers may only start after all requests were executed and
+    // this function returned, so they share ownership of the batch. The
+    // calling thread executes requests too, and never waits for a helper
+    // that didn't start, so batches can't deadlock on a busy queue.
+    auto batch{std::make_shared<BatchExecution>(jreq, vReq)};
+    for (size_t i{0}; i < helpers; ++i) {
+        if (!run_task([batch] { batch->Run(); })) break;
+    }
+    batch->Run();
+    {
+        WAIT_LOCK(batch->mutex, lock);
+        batch->cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(batch->mutex) { return batch->done == vReq.size(); });
+    }
+
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(batch->replies);
     return ret.write() + "\n";
 }
 
@@ -181,7 +181,18 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Runs a task on another thread, returning false if it couldn't be scheduled */
+using RPCTaskRunner = std::function<bool(std::function<void()>)>;
+
+/**
+ * Execute a batch of requests and return the replies, in request order.
+ *
+ * If run_task is given and all requests are for methods that only read
+ * state, up to max_threads - 1 helper tasks are started with it to execute
+ * requests in parallel with the calling thread.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskRunner& run_task = {}, int max_threads = 1);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
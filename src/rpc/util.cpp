@@ -9,6 +9,7 @@
 #include <script/interpreter.h>
 #include <key_io.h>
 #include <outputtype.h>
+#include <rpc/jsonstream.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
 #include <script/signingprovider.h>
@@ -618,7 +619,9 @@ UniValue RPCHelpMan::HandleRequest(const JSONRPCRequest& request) const
     m_req = &request;
     UniValue ret = m_fun(*this, request);
     m_req = nullptr;
-    if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
+    // A streamed result was already sent and can't be checked here.
+    const bool streamed{request.result_stream && request.result_stream->Started()};
+    if (!streamed && gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
         UniValue mismatch{UniValue::VARR};
         for (const auto& res : m_results.m_results) {
             UniValue match{res.MatchesType(ret)};
@@ -0,0 +1,93 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockdownload.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+using node::BlockDownloadStats;
+using node::MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER;
+using node::MIN_BLOCKS_IN_TRANSIT_PER_PEER;
+
+namespace {
+constexpr int DEFAULT_WINDOW{16};
+constexpr auto NO_PING{std::chrono::microseconds::max()};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(blockdownload_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(no_estimate)
+{
+    BlockDownloadStats stats;
+    BOOST_CHECK(!stats.HasEstimate());
+    BOOST_CHECK_EQUAL(stats.Window(NO_PING, DEFAULT_WINDOW), DEFAULT_WINDOW);
+    BOOST_CHECK_EQUAL(stats.Rate(), 0);
+
+    // Blocks received one second apart, too few to use
+    for (int i = 0; i < 3; ++i) {
+        stats.BlockReceived(std::chrono::seconds{i}, std::chrono::seconds{i + 1}, 1000);
+    }
+    BOOST_CHECK(!stats.HasEstimate());
+    BOOST_CHECK_EQUAL(stats.Window(NO_PING, DEFAULT_WINDOW), DEFAULT_WINDOW);
+    BOOST_CHECK_EQUAL(stats.Blocks(), 3U);
+    BOOST_CHECK_EQUAL(stats.Bytes(), 3000U);
+    BOOST_CHECK(stats.Latency() == 1s);
+    BOOST_CHECK(stats.ServiceTime() == 1s);
+}
+
+BOOST_AUTO_TEST_CASE(fast_peer)
+{
+    // 64 blocks of 1 MB, requested at once from a peer with a 100ms round trip,
+    // arrive 5ms apart after the first one.
+    BlockDownloadStats stats;
+    for (int i = 0; i < 64; ++i) {
+        stats.BlockReceived(0us, 100ms + i * 5ms, 1'000'000);
+    }
+    BOOST_CHECK(stats.HasEstimate());
+    // The service time converges to the time between blocks, not the latency
+    BOOST_CHECK(stats.ServiceTime() > 5ms && stats.ServiceTime() < 6ms);
+    BOOST_CHECK(stats.Latency() > 100ms);
+    BOOST_CHECK(stats.Rate() > 160e6 && stats.Rate() < 200e6);
+
+    // Enough blocks to cover the round trip plus the refill time stay in flight
+    const int window{stats.Window(100ms, DEFAULT_WINDOW)};
+    BOOST_CHECK(window > DEFAULT_WINDOW);
+    BOOST_CHECK_EQUAL(window, 1 + (100ms + node::BLOCK_DOWNLOAD_REFILL_TIME) / stats.ServiceTime());
+    // Without a ping measurement, the latency bounds the round trip
+    BOOST_CHECK(stats.Window(NO_PING, DEFAULT_WINDOW) >= window);
+    // A faster peer still has a bounded window
+    BOOST_CHECK_EQUAL(stats.Window(10s, DEFAULT_WINDOW), MAX_ADAPTIVE_BLOCKS_IN_TRANSIT_PER_PEER);
+}
+
+BOOST_AUTO_TEST_CASE(slow_peer)
+{
+    // One block every three seconds
+    BlockDownloadStats stats;
+    for (int i = 0; i < 8; ++i) {
+        stats.BlockReceived(0s, std::chrono::seconds{3 * (i + 1)}, 1'000'000);
+    }
+    BOOST_CHECK(stats.ServiceTime() == 3s);
+    BOOST_CHECK_EQUAL(stats.Window(100ms, DEFAULT_WINDOW), MIN_BLOCKS_IN_TRANSIT_PER_PEER);
+    BOOST_CHECK(stats.Rate() > 333e3 && stats.Rate() < 334e3);
+}
+
+BOOST_AUTO_TEST_CASE(idle_gaps)
+{
+    // Blocks requested one at a time, after the previous one arrived: the
+    // service time is the full round trip of each.
+    BlockDownloadStats stats;
+    for (int i = 0; i < 8; ++i) {
+        const auto requested{std::chrono::seconds{10 * i}};
+        stats.BlockReceived(requested, requested + 200ms, 1000);
+    }
+    BOOST_CHECK(stats.ServiceTime() == 200ms);
+    BOOST_CHECK(stats.Latency() == 200ms);
+    BOOST_CHECK_EQUAL(stats.Window(200ms, DEFAULT_WINDOW), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,11 +4,13 @@
 
 #include <chainparams.h>
 #include <clientversion.h>
+#include <node/blockcache.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <streams.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
@@ -17,9 +19,11 @@
 #include <test/util/setup_common.h>
 
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockEncoding;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
+using node::SerializedBlockCache;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -201,4 +205,105 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(serialized_block_cache_lru)
+{
+    const auto make_data{[](size_t size, uint8_t fill) {
+        return std::make_shared<const std::vector<uint8_t>>(size, fill);
+    }};
+    const uint256 hash1{1}, hash2{2}, hash3{3};
+    SerializedBlockCache cache{300};
+
+    BOOST_CHECK(!cache.Get(hash1, BlockEncoding::STORED));
+    cache.Insert(hash1, BlockEncoding::STORED, make_data(100, 1));
+    cache.Insert(hash1, BlockEncoding::COMPACT, make_data(50, 2));
+    cache.Insert(hash2, BlockEncoding::STORED, make_data(100, 3));
+    BOOST_CHECK_EQUAL(cache.Count(), 3U);
+    BOOST_CHECK_EQUAL(cache.Bytes(), 250U);
+    // Encodings of a block are cached separately
+    BOOST_CHECK_EQUAL(cache.Get(hash1, BlockEncoding::STORED)->front(), 1);
+    BOOST_CHECK_EQUAL(cache.Get(hash1, BlockEncoding::COMPACT)->front(), 2);
+    BOOST_CHECK(!cache.Get(hash2, BlockEncoding::COMPACT));
+
+    // Re-inserting keeps the entry already handed out
+    const auto stored1{cache.Get(hash1, BlockEncoding::STORED)};
+    cache.Insert(hash1, BlockEncoding::STORED, make_data(100, 4));
+    BOOST_CHECK_EQUAL(cache.Get(hash1, BlockEncoding::STORED), stored1);
+    BOOST_CHECK_EQUAL(cache.Bytes(), 250U);
+
+    // hash2 is now the least recently used, and evicted to make room
+    cache.Insert(hash3, BlockEncoding::STORED, make_data(100, 5));
+    BOOST_CHECK(!cache.Get(hash2, BlockEncoding::STORED));
+    BOOST_CHECK(cache.Get(hash1, BlockEncoding::COMPACT));
+    BOOST_CHECK_EQUAL(cache.Count(), 3U);
+    BOOST_CHECK_EQUAL(cache.Bytes(), 250U);
+
+    // An evicted entry stays valid for whoever still holds it
+    BOOST_CHECK_EQUAL(stored1->size(), 100U);
+
+    // Data larger than the whole cache is not cached
+    cache.Insert(hash2, BlockEncoding::STORED, make_data(301, 6));
+    BOOST_CHECK(!cache.Get(hash2, BlockEncoding::STORED));
+    BOOST_CHECK_EQUAL(cache.Count(), 3U);
+
+    // A disabled cache holds nothing
+    SerializedBlockCache disabled{0};
+    disabled.Insert(hash1, BlockEncoding::STORED, make_data(1, 7));
+    BOOST_CHECK(!disabled.Get(hash1, BlockEncoding::STORED));
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_serialized_block_cache)
+{
+    KernelNotifications notifications{m_node.exit_status};
+    node::BlockManager::Options blockman_opts{
+        .chainparams = Params(),
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+    };
+    BlockManager blockman{m_node.kernel->interrupt, blockman_opts};
+
+    CBlock block1;
+    block1.nVersion = 1;
+    CBlock block2;
+    block2.nVersion = 2;
+    const uint256 hash1{block1.GetHash()}, hash2{block2.GetHash()};
+    CBlockIndex index1{block1}, index2{block2};
+    index1.phashBlock = &hash1;
+    index2.phashBlock = &hash2;
+    {
+        LOCK(::cs_main);
+        const FlatFilePos pos1{blockman.SaveBlockToDisk(block1, /*nHeight=*/1, /*dbp=*/nullptr)};
+        index1.nFile = pos1.nFile;
+        index1.nDataPos = pos1.nPos;
+        index1.nStatus |= BLOCK_HAVE_DATA;
+    }
+    std::vector<uint8_t> expected1;
+    CVectorWriter{CLIENT_VERSION, expected1, 0} << block1;
+
+    // Read from disk, without caching it
+    const auto data1{blockman.GetSerializedBlock(index1, /*block=*/nullptr, /*cache=*/false)};
+    BOOST_REQUIRE(data1);
+    BOOST_CHECK(*data1 == expected1);
+    BOOST_CHECK_EQUAL(blockman.m_serialized_block_cache.Count(), 0U);
+
+    // Read from disk and cached; served from the cache afterwards
+    const auto cached1{blockman.GetSerializedBlock(index1, /*block=*/nullptr, /*cache=*/true)};
+    BOOST_REQUIRE(cached1);
+    BOOST_CHECK(*cached1 == expected1);
+    BOOST_CHECK_EQUAL(blockman.GetSerializedBlock(index1, /*block=*/nullptr, /*cache=*/true), cached1);
+
+    // ReadBlock deserializes the cached block. The test block has no valid
+    // proof of work, so reading it from disk would fail.
+    CBlock read_block;
+    BOOST_CHECK(blockman.ReadBlock(read_block, index1));
+    BOOST_CHECK_EQUAL(read_block.GetHash(), hash1);
+
+    // A block that is passed in is serialized instead of being read from disk,
+    // where block2 was never written
+    const auto data2{blockman.GetSerializedBlock(index2, &block2, /*cache=*/true)};
+    BOOST_REQUIRE(data2);
+    BOOST_CHECK_EQUAL(data2->size(), expected1.size());
+    BOOST_CHECK_EQUAL(blockman.GetSerializedBlock(index2, /*block=*/nullptr, /*cache=*/true), data2);
+    BOOST_CHECK_EQUAL(blockman.m_serialized_block_cache.Count(), 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
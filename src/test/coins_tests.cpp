@@ -14,6 +14,7 @@
 #include <undo.h>
 #include <util/strencodings.h>
 
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -1084,6 +1085,118 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_get_coins)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCacheTest parent{&base};
+    CCoinsViewCacheTest child{&parent};
+
+    // Store coins in the database, then bring one of them into the child cache
+    // and spend another one there.
+    std::vector<COutPoint> outpoints;
+    std::vector<Coin> coins;
+    for (int i = 0; i < 300; ++i) {
+        outpoints.emplace_back(InsecureRand256(), 0);
+        coins.push_back(MakeCoin());
+        parent.AddCoin(outpoints.back(), Coin(coins.back()), false);
+    }
+    parent.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(parent.Flush());
+    BOOST_CHECK(child.HaveCoin(outpoints[0]));
+    BOOST_CHECK(child.SpendCoin(outpoints[1]));
+    const COutPoint missing{InsecureRand256(), 0};
+
+    std::vector<COutPoint> request{outpoints};
+    request.push_back(missing);
+    request.push_back(outpoints[2]);
+
+    const auto result{child.GetCoins(request)};
+    BOOST_REQUIRE_EQUAL(result.size(), request.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (i == 1) {
+            BOOST_CHECK(!result[i].has_value());
+            continue;
+        }
+        BOOST_REQUIRE(result[i].has_value());
+        BOOST_CHECK(*result[i] == coins[i]);
+    }
+    BOOST_CHECK(!result[outpoints.size()].has_value());
+    BOOST_REQUIRE(result.back().has_value());
+    BOOST_CHECK(*result.back() == coins[2]);
+
+    // Fetched coins are now cached at both levels, and the caches are consistent.
+    for (size_t i = 2; i < outpoints.size(); ++i) {
+        BOOST_CHECK(child.HaveCoinInCache(outpoints[i]));
+        BOOST_CHECK(parent.HaveCoinInCache(outpoints[i]));
+    }
+    BOOST_CHECK(!child.HaveCoinInCache(missing));
+    child.SelfTest();
+    parent.SelfTest();
+
+    // The database returns the same coins directly.
+    const auto db_result{base.GetCoins(outpoints)};
+    BOOST_REQUIRE_EQUAL(db_result.size(), outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        BOOST_REQUIRE(db_result[i].has_value());
+        BOOST_CHECK(*db_result[i] == coins[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_background_flush)
+{
+    CCoinsViewDB base{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {.background_flush = true}};
+    CCoinsViewCacheTest cache{&base};
+
+    // Write a first set of coins synchronously.
+    std::vector<COutPoint> outpoints;
+    std::vector<Coin> coins;
+    for (int i = 0; i < 100; ++i) {
+        outpoints.emplace_back(InsecureRand256(), 0);
+        coins.push_back(MakeCoin());
+        cache.AddCoin(outpoints.back(), Coin(coins.back()), false);
+    }
+    const uint256 first_block{InsecureRand256()};
+    cache.SetBestBlock(first_block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(base.GetBestBlock() == first_block);
+
+    // Spend one coin, add a new one, and add and spend a FRESH one.
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    const COutPoint added{InsecureRand256(), 0};
+    const Coin added_coin{MakeCoin()};
+    cache.AddCoin(added, Coin(added_coin), false);
+    const COutPoint transient{InsecureRand256(), 0};
+    cache.AddCoin(transient, MakeCoin(), false);
+    BOOST_CHECK(cache.SpendCoin(transient));
+    const uint256 second_block{InsecureRand256()};
+    cache.SetBestBlock(second_block);
+
+    CCoinsFlushBatch batch{cache.TakeFlushBatch()};
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK(batch.hashBlock == second_block);
+    BOOST_CHECK_EQUAL(batch.coins.size(), 2U);
+    BOOST_CHECK(batch.coins.at(outpoints[0]).coin.IsSpent());
+    BOOST_CHECK(batch.coins.count(transient) == 0);
+
+    std::atomic<bool> completed{false};
+    BOOST_CHECK(base.BatchWriteInBackground(std::move(batch), [&] { completed = true; }));
+
+    // The cache sees the new state whether or not the write has finished.
+    BOOST_CHECK(!cache.HaveCoin(outpoints[0]));
+    BOOST_CHECK(cache.AccessCoin(added) == added_coin);
+    BOOST_CHECK(cache.AccessCoin(outpoints[1]) == coins[1]);
+    BOOST_CHECK(cache.GetBestBlock() == second_block);
+
+    BOOST_CHECK(base.WaitForBackgroundWrite());
+    BOOST_CHECK(completed);
+    BOOST_CHECK(base.GetBestBlock() == second_block);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    BOOST_CHECK(!base.HaveCoin(outpoints[0]));
+    BOOST_CHECK(base.HaveCoin(added));
+    BOOST_CHECK(!base.HaveCoin(transient));
+    cache.SelfTest();
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used)
 {
     CCoinsMapMemoryResource resource;
@@ -7,6 +7,7 @@
 #include <interfaces/chain.h>
 #include <kernel/coinstats.h>
 #include <test/util/index.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <test/util/validation.h>
 #include <validation.h>
@@ -118,4 +119,47 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_parallel_muhash, BasicTestingSetup)
+{
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (int i = 0; i < 2000; ++i) {
+        Coin coin;
+        coin.out.nValue = InsecureRandMoneyAmount();
+        coin.out.scriptPubKey.assign(InsecureRandRange(40), 0x51);
+        coin.nHeight = InsecureRandRange(1000);
+        coin.fCoinBase = InsecureRandBool();
+        coins.emplace_back(COutPoint{InsecureRand256(), uint32_t(InsecureRandRange(10))}, coin);
+    }
+
+    // Add all coins in two rounds and remove every third, one at a time.
+    MuHash3072 expected;
+    for (size_t i = 0; i < coins.size(); ++i) {
+        kernel::ApplyCoinHash(expected, coins[i].first, coins[i].second);
+    }
+    for (size_t i = 0; i < coins.size(); i += 3) {
+        kernel::RemoveCoinHash(expected, coins[i].first, coins[i].second);
+    }
+    uint256 expected_hash;
+    expected.Finalize(expected_hash);
+
+    for (const int threads : {0, 1, 3}) {
+        kernel::ParallelMuHash parallel{threads};
+        MuHash3072 muhash;
+        for (size_t i = 0; i < coins.size() / 2; ++i) {
+            parallel.Insert(coins[i].first, coins[i].second);
+        }
+        parallel.Apply(muhash);
+        for (size_t i = coins.size() / 2; i < coins.size(); ++i) {
+            parallel.Insert(coins[i].first, coins[i].second);
+        }
+        for (size_t i = 0; i < coins.size(); i += 3) {
+            parallel.Remove(coins[i].first, coins[i].second);
+        }
+        parallel.Apply(muhash);
+        uint256 hash;
+        muhash.Finalize(hash);
+        BOOST_CHECK_EQUAL(hash, expected_hash);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -838,6 +838,43 @@ BOOST_AUTO_TEST_CASE(chacha20_midblock)
     BOOST_CHECK(Span{block}.last(52) == Span{b3});
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_multiblock)
+{
+    // Requests of several blocks may be served by a vectorized implementation; compare them with
+    // block-by-block output, also across an overflow of the 32-bit block counter.
+    const auto key = ParseHex<std::byte>("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    ChaCha20Aligned c20{key};
+    for (const uint32_t seek : {0U, 0xfffffff0U, 0xfffffffdU}) {
+        for (size_t blocks = 1; blocks <= 21; ++blocks) {
+            std::vector<std::byte> expected(blocks * ChaCha20Aligned::BLOCKLEN);
+            c20.Seek({0, 0xdeadbeef12345678}, seek);
+            for (size_t i = 0; i < blocks; ++i) {
+                c20.Keystream(Span{expected}.subspan(i * ChaCha20Aligned::BLOCKLEN, ChaCha20Aligned::BLOCKLEN));
+            }
+
+            std::vector<std::byte> keystream(expected.size());
+            c20.Seek({0, 0xdeadbeef12345678}, seek);
+            c20.Keystream(keystream);
+            BOOST_CHECK(keystream == expected);
+
+            const auto msg{g_insecure_rand_ctx.randbytes<std::byte>(expected.size())};
+            std::vector<std::byte> cipher(expected.size());
+            c20.Seek({0, 0xdeadbeef12345678}, seek);
+            c20.Crypt(msg, cipher);
+            for (size_t i = 0; i < msg.size(); ++i) expected[i] ^= msg[i];
+            BOOST_CHECK(cipher == expected);
+
+            // The block counter continues where the multi-block request left it.
+            std::byte next[ChaCha20Aligned::BLOCKLEN], next_expected[ChaCha20Aligned::BLOCKLEN];
+            c20.Keystream(next);
+            const uint64_t next_block{uint64_t{seek} + blocks};
+            c20.Seek({uint32_t(next_block >> 32), 0xdeadbeef12345678}, uint32_t(next_block));
+            c20.Keystream(next_expected);
+            BOOST_CHECK(Span{next} == Span{next_expected});
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
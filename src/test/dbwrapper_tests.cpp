@@ -160,6 +160,51 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_read_many)
+{
+    // Perform tests both obfuscated and non-obfuscated, and both serially and
+    // across several reader threads.
+    for (const bool obfuscate : {false, true}) {
+        for (const int read_threads : {1, 4}) {
+            fs::path ph = m_args.GetDataDirBase() / fs::u8path(strprintf("dbwrapper_read_many_%d_%d", obfuscate, read_threads));
+            CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate, .options = {.read_threads = read_threads}});
+
+            // Write every other key, so that half of the lookups miss.
+            using Key = std::pair<uint8_t, uint32_t>;
+            const uint32_t num_keys{1000};
+            std::vector<uint256> in(num_keys);
+            CDBBatch batch(dbw);
+            for (uint32_t i = 0; i < num_keys; i += 2) {
+                in[i] = InsecureRand256();
+                batch.Write(Key{'k', i}, in[i]);
+            }
+            BOOST_CHECK(dbw.WriteBatch(batch));
+
+            // Request keys in reverse order, with a duplicate, to check that
+            // results come back in the order they were asked for.
+            std::vector<Key> keys;
+            for (uint32_t i = num_keys; i-- > 0;) {
+                keys.emplace_back('k', i);
+            }
+            keys.emplace_back('k', 0);
+
+            const auto res{dbw.ReadMany<uint256>(Span<const Key>{keys})};
+            BOOST_REQUIRE_EQUAL(res.size(), keys.size());
+            for (size_t j = 0; j < keys.size(); ++j) {
+                const uint32_t i{keys[j].second};
+                if (i % 2 == 0) {
+                    BOOST_REQUIRE(res[j].has_value());
+                    BOOST_CHECK_EQUAL(res[j]->ToString(), in[i].ToString());
+                } else {
+                    BOOST_CHECK(!res[j].has_value());
+                }
+            }
+
+            BOOST_CHECK(dbw.ReadMany<uint256>(Span<const Key>{}).empty());
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <crypto/siphash.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/densemap.h>
+#include <util/hasher.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+
+namespace {
+struct SipHasher64 {
+    size_t operator()(uint64_t v) const { return CSipHasher(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL).Write(v).Finalize(); }
+};
+
+/** Hash with very few distinct values, to force long probe sequences and wrap-around. */
+struct CollidingHasher {
+    size_t operator()(uint64_t v) const { return v % 7; }
+};
+
+template <typename Map>
+void CheckEqual(const Map& map, const std::unordered_map<uint64_t, uint64_t>& ref)
+{
+    BOOST_REQUIRE_EQUAL(map.size(), ref.size());
+    for (const auto& [key, value] : ref) {
+        const auto it{map.find(key)};
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second, value);
+    }
+    size_t visited{0};
+    for (const auto& [key, value] : map) {
+        BOOST_CHECK_EQUAL(ref.at(key), value);
+        ++visited;
+    }
+    BOOST_CHECK_EQUAL(visited, ref.size());
+}
+
+template <typename Hasher>
+void RandomOperations(int num_ops, uint64_t key_range)
+{
+    DenseHashMap<uint64_t, uint64_t, Hasher> map;
+    std::unordered_map<uint64_t, uint64_t> ref;
+    for (int i = 0; i < num_ops; ++i) {
+        const uint64_t key{InsecureRandRange(key_range)};
+        switch (InsecureRandRange(4)) {
+        case 0:
+        case 1: {
+            const uint64_t value{InsecureRandBits(64)};
+            const auto [it, inserted]{map.try_emplace(key, value)};
+            const auto [ref_it, ref_inserted]{ref.try_emplace(key, value)};
+            BOOST_CHECK_EQUAL(inserted, ref_inserted);
+            BOOST_CHECK_EQUAL(it->second, ref_it->second);
+            break;
+        }
+        case 2:
+            BOOST_CHECK_EQUAL(map.erase(key), ref.erase(key));
+            break;
+        case 3:
+            BOOST_CHECK_EQUAL(map.count(key), ref.count(key));
+            break;
+        }
+    }
+    CheckEqual(map, ref);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(densemap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(densemap_random_operations)
+{
+    RandomOperations<SipHasher64>(20000, 2000);
+    RandomOperations<std::hash<uint64_t>>(20000, 2000);
+    RandomOperations<CollidingHasher>(5000, 300);
+}
+
+BOOST_AUTO_TEST_CASE(densemap_erase_while_iterating)
+{
+    DenseHashMap<uint64_t, uint64_t, CollidingHasher> map;
+    std::unordered_map<uint64_t, uint64_t> ref;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        map.try_emplace(i, i * 3);
+        ref.emplace(i, i * 3);
+    }
+
+    // Erase every odd value while iterating; each element must be visited once.
+    std::set<uint64_t> visited;
+    for (auto it = map.begin(); it != map.end();) {
+        BOOST_CHECK(visited.insert(it->first).second);
+        if (it->first % 2) {
+            ref.erase(it->first);
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    BOOST_CHECK_EQUAL(visited.size(), 1000U);
+    CheckEqual(map, ref);
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(0) == map.end());
+    map[5] = 7;
+    BOOST_CHECK_EQUAL(map.at(5), 7U);
+    BOOST_CHECK_THROW(map.at(6), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(densemap_memory_usage)
+{
+    using CoinsDenseMap = DenseHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher>;
+    CoinsDenseMap map;
+    const size_t empty_usage{map.DynamicMemoryUsage()};
+    map.reserve(10000);
+    const size_t buckets{map.bucket_count()};
+    const size_t reserved_usage{map.DynamicMemoryUsage()};
+    BOOST_CHECK(reserved_usage > empty_usage);
+
+    // Filling up to the reserved size neither rehashes nor allocates.
+    for (uint32_t i = 0; i < 10000; ++i) {
+        map.try_emplace(COutPoint{InsecureRand256(), i}, Coin{}, CCoinsCacheEntry::DIRTY);
+    }
+    BOOST_CHECK_EQUAL(map.bucket_count(), buckets);
+    BOOST_CHECK_EQUAL(map.DynamicMemoryUsage(), reserved_usage);
+    BOOST_CHECK(map.DynamicMemoryUsage() >= 10000 * sizeof(CoinsDenseMap::value_type));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -134,6 +134,14 @@ ssize_t FuzzedSock::Send(const void* data, size_t len, int flags) const
     return r;
 }
 
+ssize_t FuzzedSock::SendMany(Span<const Span<const uint8_t>> chunks, int flags) const
+{
+    // Send() does not look at the data, only at its size.
+    size_t len{0};
+    for (const auto& chunk : chunks) len += chunk.size();
+    return Send(nullptr, len, flags);
+}
+
 ssize_t FuzzedSock::Recv(void* buf, size_t len, int flags) const
 {
     // Have a permanent error at recv_errnos[0] because when the fuzzed data is exhausted
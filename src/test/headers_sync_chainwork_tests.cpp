@@ -6,6 +6,7 @@
 #include <chainparams.h>
 #include <consensus/params.h>
 #include <headerssync.h>
+#include <key.h>
 #include <pow.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
@@ -24,6 +25,13 @@ struct HeadersGeneratorSetup : public RegTestingSetup {
     void GenerateHeaders(std::vector<CBlockHeader>& headers, size_t count,
             const uint256& starting_hash, const int nVersion, int prev_time,
             const uint256& merkle_root, const uint32_t nBits);
+    /**
+     * Generate proof-of-stake headers in the same way, each staking a
+     * different (made up) output and signed with the given key.
+     */
+    void GenerateStakeHeaders(std::vector<CBlockHeader>& headers, size_t count,
+            const uint256& starting_hash, int prev_time, const uint32_t nBits,
+            const CKey& key);
 };
 
 void HeadersGeneratorSetup::FindProofOfWork(CBlockHeader& starting_header)
@@ -55,6 +63,28 @@ void HeadersGeneratorSetup::GenerateHeaders(std::vector<CBlockHeader>& headers,
     return;
 }
 
+void HeadersGeneratorSetup::GenerateStakeHeaders(std::vector<CBlockHeader>& headers,
+        size_t count, const uint256& starting_hash, int prev_time,
+        const uint32_t nBits, const CKey& key)
+{
+    uint256 prev_hash = starting_hash;
+
+    while (headers.size() < count) {
+        headers.emplace_back();
+        CBlockHeader& next_header = headers.back();
+        next_header.nVersion = Params().GenesisBlock().nVersion;
+        next_header.hashPrevBlock = prev_hash;
+        next_header.nTime = prev_time+1;
+        next_header.nBits = nBits;
+        next_header.nNonce = 0xD0D0FACE;
+        next_header.prevoutStake = COutPoint{prev_hash, uint32_t(headers.size())};
+        BOOST_REQUIRE(key.Sign(next_header.GetHashWithoutSign(), next_header.vchBlockSig));
+
+        prev_hash = next_header.GetHash();
+        prev_time = next_header.nTime;
+    }
+}
+
 BOOST_FIXTURE_TEST_SUITE(headers_sync_chainwork_tests, HeadersGeneratorSetup)
 
 // In this test, we construct two sets of headers from genesis, one with
@@ -143,4 +173,93 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(result.success);
 }
 
+BOOST_AUTO_TEST_CASE(header_signature)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<CBlockHeader> headers;
+    GenerateStakeHeaders(headers, 1, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nTime, Params().GenesisBlock().nBits, key);
+    CBlockHeader header = headers.front();
+    BOOST_CHECK(CheckHeaderSignature(header));
+
+    // Proof-of-work headers carry no signature
+    BOOST_CHECK(CheckHeaderSignature(Params().GenesisBlock().GetBlockHeader()));
+    CBlockHeader pow_header = Params().GenesisBlock().GetBlockHeader();
+    pow_header.vchBlockSig = header.vchBlockSig;
+    BOOST_CHECK(!CheckHeaderSignature(pow_header));
+
+    // Missing or malformed signatures
+    header.vchBlockSig.clear();
+    BOOST_CHECK(!CheckHeaderSignature(header));
+    header.vchBlockSig = {0x30, 0x06, 0x02, 0x01, 0x00, 0x02, 0x01, 0x01};
+    BOOST_CHECK(!CheckHeaderSignature(header));
+}
+
+// Proof-of-stake headers keep their stake and signature through the
+// REDOWNLOAD buffer, and have their signatures checked when redownloaded.
+BOOST_AUTO_TEST_CASE(headers_sync_state_pos)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<CBlockHeader> chain;
+    const int target_blocks = 5000;
+    arith_uint256 chain_work = target_blocks*2;
+
+    // A few proof-of-work headers, then proof-of-stake ones.
+    GenerateHeaders(chain, 10, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(0), Params().GenesisBlock().nBits);
+    std::vector<CBlockHeader> stake_headers;
+    GenerateStakeHeaders(stake_headers, target_blocks - chain.size(), chain.back().GetHash(),
+            chain.back().nTime, Params().GenesisBlock().nBits, key);
+    chain.insert(chain.end(), stake_headers.begin(), stake_headers.end());
+
+    const CBlockIndex* chain_start = WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(Params().GenesisBlock().GetHash()));
+
+    // Deliver the chain in full-sized messages, twice.
+    auto sync = [&](HeadersSyncState& hss, const std::vector<CBlockHeader>& headers) {
+        HeadersSyncState::ProcessingResult result;
+        std::vector<CBlockHeader> accepted;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i = 0; i < headers.size(); i += 2000) {
+                const std::vector<CBlockHeader> batch(headers.begin() + i, headers.begin() + std::min(i + 2000, headers.size()));
+                result = hss.ProcessNextHeaders(batch, true);
+                accepted.insert(accepted.end(), result.pow_validated_headers.begin(), result.pow_validated_headers.end());
+                if (!result.success || hss.GetState() == HeadersSyncState::State::FINAL) return std::make_pair(result, accepted);
+                if (pass == 0 && hss.GetState() == HeadersSyncState::State::REDOWNLOAD) break;
+            }
+        }
+        return std::make_pair(result, accepted);
+    };
+
+    for (int threads : {0, 3}) {
+        HeadersSyncState hss(0, Params().GetConsensus(), chain_start, chain_work, threads);
+        const auto [result, accepted] = sync(hss, chain);
+        BOOST_CHECK(result.success);
+        BOOST_CHECK(hss.GetState() == HeadersSyncState::State::FINAL);
+        BOOST_REQUIRE_EQUAL(accepted.size(), chain.size());
+        for (size_t i = 0; i < chain.size(); ++i) {
+            BOOST_CHECK_EQUAL(accepted[i].GetHash(), chain[i].GetHash());
+            BOOST_CHECK(accepted[i].prevoutStake == chain[i].prevoutStake);
+            BOOST_CHECK(accepted[i].vchBlockSig == chain[i].vchBlockSig);
+        }
+    }
+
+    // A header with a bad signature passes PRESYNC, which doesn't check
+    // signatures, but fails REDOWNLOAD.
+    std::vector<CBlockHeader> bad_chain{chain};
+    bad_chain[4321].vchBlockSig = {0x30, 0x06, 0x02, 0x01, 0x00, 0x02, 0x01, 0x01};
+    for (size_t i = 4322; i < bad_chain.size(); ++i) {
+        bad_chain[i].hashPrevBlock = bad_chain[i - 1].GetHash();
+    }
+    for (int threads : {0, 3}) {
+        HeadersSyncState hss(0, Params().GetConsensus(), chain_start, chain_work, threads);
+        const auto [result, accepted] = sync(hss, bad_chain);
+        BOOST_CHECK(!result.success);
+        BOOST_CHECK(hss.GetState() == HeadersSyncState::State::FINAL);
+        BOOST_CHECK(accepted.empty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,7 @@
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <set>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -800,4 +801,89 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+/** Check the cluster chunks of the pool for consistency and return the chunks (as sets of
+ *  txids) of the cluster containing txid. */
+static std::vector<std::set<uint256>> GetChunksOf(const CTxMemPool& pool, const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    std::vector<std::set<uint256>> result;
+    std::set<uint256> all;
+    for (const CTxMemPool::ClusterChunks* chunks : pool.GetClusterChunks()) {
+        std::set<uint256> in_cluster;
+        for (size_t i = 0; i < chunks->size(); ++i) {
+            const CTxMemPool::ClusterChunk& chunk{(*chunks)[i]};
+            BOOST_CHECK(!chunk.txs.empty());
+            if (i > 0) {
+                // Feerates do not increase.
+                const CTxMemPool::ClusterChunk& prev{(*chunks)[i - 1]};
+                BOOST_CHECK(chunk.fee * prev.vsize <= prev.fee * chunk.vsize);
+            }
+            CAmount fee{0};
+            for (const CTxMemPool::txiter& it : chunk.txs) {
+                // Parents come first.
+                for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                    BOOST_CHECK(in_cluster.count(parent.GetTx().GetHash()));
+                }
+                in_cluster.insert(it->GetTx().GetHash());
+                BOOST_CHECK(all.insert(it->GetTx().GetHash()).second);
+                fee += it->GetModifiedFee();
+            }
+            BOOST_CHECK_EQUAL(fee, chunk.fee);
+        }
+        if (in_cluster.count(tx->GetHash())) {
+            for (const CTxMemPool::ClusterChunk& chunk : *chunks) {
+                result.emplace_back();
+                for (const CTxMemPool::txiter& it : chunk.txs) result.back().insert(it->GetTx().GetHash());
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(all.size(), pool.size());
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(MempoolClusterChunksTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CTransactionRef tx_a = make_tx(/*output_values=*/{10 * COIN});
+    pool.addUnchecked(entry.Fee(10000LL).FromTx(tx_a));
+    BOOST_CHECK(GetChunksOf(pool, tx_a) == std::vector<std::set<uint256>>({{tx_a->GetHash()}}));
+
+    // A low-fee parent with a high-fee child (CPFP) forms a single chunk.
+    CTransactionRef tx_p = make_tx(/*output_values=*/{11 * COIN});
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx_p));
+    CTransactionRef tx_c = make_tx(/*output_values=*/{9 * COIN}, /*inputs=*/{tx_p});
+    pool.addUnchecked(entry.Fee(50000LL).FromTx(tx_c));
+    BOOST_CHECK(GetChunksOf(pool, tx_c) == std::vector<std::set<uint256>>({{tx_p->GetHash(), tx_c->GetHash()}}));
+
+    // Diamond: tx4 pays for itself; tx7 pays for tx5 and tx6.
+    CTransactionRef tx4 = make_tx(/*output_values=*/{COIN, COIN});
+    CTransactionRef tx5 = make_tx(/*output_values=*/{COIN}, /*inputs=*/{tx4}, /*input_indices=*/{0});
+    CTransactionRef tx6 = make_tx(/*output_values=*/{COIN}, /*inputs=*/{tx4}, /*input_indices=*/{1});
+    CTransactionRef tx7 = make_tx(/*output_values=*/{COIN}, /*inputs=*/{tx5, tx6});
+    pool.addUnchecked(entry.Fee(7000LL).FromTx(tx4));
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx5));
+    pool.addUnchecked(entry.Fee(1100LL).FromTx(tx6));
+    pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 3U);
+    BOOST_CHECK(GetChunksOf(pool, tx4) == std::vector<std::set<uint256>>({{tx4->GetHash()}, {tx5->GetHash(), tx6->GetHash(), tx7->GetHash()}}));
+    // Other clusters are unaffected.
+    BOOST_CHECK(GetChunksOf(pool, tx_c) == std::vector<std::set<uint256>>({{tx_p->GetHash(), tx_c->GetHash()}}));
+
+    // Removing tx7 leaves tx5 and tx6 to be ordered by their own feerate.
+    pool.removeRecursive(*tx7, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(GetChunksOf(pool, tx4) == std::vector<std::set<uint256>>({{tx4->GetHash()}, {tx6->GetHash()}, {tx5->GetHash()}}));
+
+    // Prioritising tx5 makes it pay for tx4.
+    pool.PrioritiseTransaction(tx5->GetHash(), 20000);
+    BOOST_CHECK(GetChunksOf(pool, tx4) == std::vector<std::set<uint256>>({{tx4->GetHash(), tx5->GetHash()}, {tx6->GetHash()}}));
+
+    // Removing the parent of a cluster splits it.
+    pool.removeForBlock({tx4}, 1);
+    BOOST_CHECK_EQUAL(pool.GetClusterChunks().size(), 4U);
+    BOOST_CHECK(GetChunksOf(pool, tx5) == std::vector<std::set<uint256>>({{tx5->GetHash()}}));
+    BOOST_CHECK(GetChunksOf(pool, tx6) == std::vector<std::set<uint256>>({{tx6->GetHash()}}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1565,4 +1565,70 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(send_buffer_pool)
+{
+    SendBufferPool pool;
+    BOOST_CHECK(pool.Get().capacity() == 0);
+
+    std::vector<unsigned char> buffer(1000, 0xaa);
+    pool.Put(std::move(buffer));
+    BOOST_CHECK_EQUAL(pool.Size(), 1U);
+    buffer = pool.Get();
+    BOOST_CHECK(buffer.empty());
+    BOOST_CHECK(buffer.capacity() >= 1000);
+    BOOST_CHECK_EQUAL(pool.Size(), 0U);
+
+    // Large buffers are not kept.
+    pool.Put(std::vector<unsigned char>(MAX_POOLED_SEND_BUFFER_SIZE + 1));
+    BOOST_CHECK_EQUAL(pool.Size(), 0U);
+    // Neither are more than MAX_POOLED_SEND_BUFFERS.
+    for (size_t i = 0; i < MAX_POOLED_SEND_BUFFERS + 1; ++i) pool.Put(std::vector<unsigned char>(1));
+    BOOST_CHECK_EQUAL(pool.Size(), MAX_POOLED_SEND_BUFFERS);
+}
+
+BOOST_AUTO_TEST_CASE(v1transport_shared_payload)
+{
+    const auto payload{g_insecure_rand_ctx.randbytes<uint8_t>(100000)};
+    const CSerializedNetMsg msg{CNetMsgMaker(INIT_PROTO_VERSION).MakeShared(NetMsgType::BLOCK, Span{payload})};
+    CSerializedNetMsg copy{msg.Copy()};
+    // The copy shares the payload.
+    BOOST_CHECK(copy.Payload().data() == msg.Payload().data());
+    BOOST_CHECK(copy.Payload() == Span{payload});
+
+    V1Transport sender{0, SER_NETWORK, INIT_PROTO_VERSION};
+    V1Transport receiver{1, SER_NETWORK, INIT_PROTO_VERSION};
+    BOOST_REQUIRE(sender.SetMessageToSend(copy));
+
+    // The header is followed by the payload, which is sent from the shared buffer itself.
+    const auto& [header, header_more, msg_type] = sender.GetBytesToSend(/*have_next_message=*/false);
+    BOOST_CHECK_EQUAL(header.size(), CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(header_more);
+    BOOST_CHECK_EQUAL(msg_type, NetMsgType::BLOCK);
+    const auto [following, following_more] = sender.GetFollowingBytesToSend(/*have_next_message=*/false);
+    BOOST_CHECK(following.data() == msg.Payload().data());
+    BOOST_CHECK_EQUAL(following.size(), payload.size());
+    BOOST_CHECK(!following_more);
+
+    // Send the header and a part of the payload at once, then the rest.
+    std::vector<uint8_t> wire(header.begin(), header.end());
+    wire.insert(wire.end(), following.begin(), following.end());
+    sender.MarkBytesSent(header.size() + 1000);
+    const auto& [rest, rest_more, rest_type] = sender.GetBytesToSend(/*have_next_message=*/false);
+    BOOST_CHECK(rest.data() == msg.Payload().data() + 1000);
+    BOOST_CHECK_EQUAL(rest.size(), payload.size() - 1000);
+    BOOST_CHECK(sender.GetFollowingBytesToSend(/*have_next_message=*/false).first.empty());
+    sender.MarkBytesSent(rest.size());
+    BOOST_CHECK(std::get<0>(sender.GetBytesToSend(/*have_next_message=*/false)).empty());
+
+    Span<const uint8_t> to_receive{wire};
+    while (!to_receive.empty()) BOOST_REQUIRE(receiver.ReceivedBytes(to_receive));
+    BOOST_REQUIRE(receiver.ReceivedMessageComplete());
+    bool reject{false};
+    CNetMessage received{receiver.GetReceivedMessage(std::chrono::microseconds{0}, reject)};
+    BOOST_CHECK(!reject);
+    BOOST_CHECK_EQUAL(received.m_type, NetMsgType::BLOCK);
+    BOOST_CHECK(Span{received.m_recv} == MakeByteSpan(payload));
+    BOOST_CHECK(msg.Payload() == Span{payload});
+}
+
 BOOST_AUTO_TEST_SUITE_END()
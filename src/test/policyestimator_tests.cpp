@@ -4,6 +4,7 @@
 
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <uint256.h>
@@ -13,6 +14,31 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <list>
+
+namespace {
+struct FeeEstimates
+{
+    std::vector<CFeeRate> smart;
+    std::vector<CFeeRate> raw;
+
+    explicit FeeEstimates(const CBlockPolicyEstimator& est)
+    {
+        for (int target = 1; target <= 1008; ++target) {
+            for (const bool conservative : {false, true}) {
+                smart.push_back(est.estimateSmartFee(target, nullptr, conservative));
+            }
+            for (const auto horizon : ALL_FEE_ESTIMATE_HORIZONS) {
+                raw.push_back(est.estimateRawFee(target, 0.85, horizon));
+            }
+        }
+    }
+
+    bool operator==(const FeeEstimates& other) const { return smart == other.smart && raw == other.raw; }
+};
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(policyestimator_tests, ChainTestingSetup)
 
 BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
@@ -182,4 +208,82 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(BlockPolicyEstimatesJournal)
+{
+    const fs::path est_path{m_args.GetDataDirNet() / "fee_estimates_journal_test.dat"};
+    const fs::path journal_path{est_path + ".journal"};
+    CBlockPolicyEstimator est{est_path, /*read_stale_estimates=*/false};
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+
+    // Txs with a higher fee confirm sooner, and some low fee txs are evicted
+    // from the mempool unconfirmed.
+    std::list<CTxMemPoolEntry> pending;
+    const auto mine_block{[&](unsigned int height, bool confirm_all) {
+        std::vector<const CTxMemPoolEntry*> block;
+        for (auto it = pending.begin(); it != pending.end();) {
+            const unsigned int age{height - it->GetHeight()};
+            if (confirm_all || age * it->GetFee() >= 6000) {
+                block.push_back(&*it);
+            } else if (height % 7 == 0 && age > 2) {
+                est.removeTx(it->GetTx().GetHash(), /*inBlock=*/false);
+                it = pending.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        est.processBlock(height, block);
+        pending.remove_if([&](const CTxMemPoolEntry& e) { return std::find(block.begin(), block.end(), &e) != block.end(); });
+    }};
+    const auto add_txs{[&](unsigned int height, CAmount fee_step) {
+        for (int j = 1; j <= 10; ++j) {
+            tx.vin[0].prevout.n = 100 * height + j;
+            pending.push_back(entry.Fee(j * fee_step).Height(height).FromTx(tx));
+            est.processTransaction(pending.back(), /*validFeeEstimate=*/true);
+        }
+    }};
+
+    unsigned int height{0};
+    while (height < 60) {
+        add_txs(height, /*fee_step=*/1000);
+        mine_block(++height, /*confirm_all=*/false);
+    }
+    mine_block(++height, /*confirm_all=*/true);
+    BOOST_REQUIRE(pending.empty());
+    const FeeEstimates expected{est};
+    BOOST_CHECK(expected.smart[2 * 4] != CFeeRate(0));
+    BOOST_CHECK(fs::exists(journal_path));
+    BOOST_CHECK(!fs::exists(est_path));
+
+    // Replaying the journal gives the same estimates, and folds it into a new file.
+    {
+        CBlockPolicyEstimator replayed{est_path, /*read_stale_estimates=*/false};
+        BOOST_CHECK(FeeEstimates{replayed} == expected);
+        BOOST_CHECK(FeeEstimates{est} == expected);
+    }
+    BOOST_CHECK(!fs::exists(journal_path));
+    BOOST_CHECK(fs::exists(est_path));
+    {
+        CBlockPolicyEstimator from_file{est_path, /*read_stale_estimates=*/false};
+        BOOST_CHECK(FeeEstimates{from_file} == expected);
+    }
+
+    // A record cut short by a crash is ignored, the ones before it are used.
+    while (height < 70) {
+        add_txs(height, /*fee_step=*/1300);
+        mine_block(++height, /*confirm_all=*/true);
+    }
+    const FeeEstimates expected_next{est};
+    BOOST_CHECK(!(expected_next == expected));
+    {
+        AutoFile journal{fsbridge::fopen(journal_path, "ab")};
+        journal << uint32_t{100} << uint8_t{0};
+    }
+    CBlockPolicyEstimator recovered{est_path, /*read_stale_estimates=*/false};
+    BOOST_CHECK(FeeEstimates{recovered} == expected_next);
+    BOOST_CHECK(!fs::exists(journal_path));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,13 +7,21 @@
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
+#include <txmempool.h>
 #include <univalue.h>
 #include <util/time.h>
 
 #include <any>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -581,4 +589,136 @@ BOOST_AUTO_TEST_CASE(help_example)
     BOOST_CHECK_NE(HelpExampleRpcNamed("foo", {{"arg", true}}), HelpExampleRpcNamed("foo", {{"arg", "true"}}));
 }
 
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    const UniValue value{JSON(R"({"a":[1,"two",{"x\"y":null,"z":[]},[[true]],{}],"b\n":{"c":-1.5,"d":{"e":[false]}},"f":"\u0001"})")};
+    for (const size_t chunk_size : {size_t{1}, size_t{7}, JSONStreamWriter::DEFAULT_CHUNK_SIZE}) {
+        std::string out;
+        size_t chunks{0};
+        JSONStreamWriter writer{[&](std::string_view chunk) { out += chunk; ++chunks; }, chunk_size};
+        writer.BeginObject();
+        writer.Key("a");
+        writer.BeginArray();
+        for (const UniValue& elem : value["a"].getValues()) writer.Value(elem);
+        writer.EndArray();
+        writer.Key("b\n");
+        writer.BeginObject();
+        writer.ObjectMembers(value["b\n"]);
+        writer.EndObject();
+        writer.KeyValue("f", value["f"]);
+        writer.EndObject();
+        writer.Flush();
+        BOOST_CHECK_EQUAL(out, value.write());
+        BOOST_CHECK(chunk_size > out.size() ? chunks == 1 : chunks > 1);
+    }
+}
+
+/** Result stream collecting the streamed result into a string. */
+class StringResultStream final : public RPCResultStream
+{
+    std::optional<JSONStreamWriter> m_writer;
+
+public:
+    std::string m_result;
+
+    JSONStreamWriter& Start() override
+    {
+        m_writer.emplace([this](std::string_view chunk) { m_result += chunk; }, /*chunk_size=*/100);
+        return *m_writer;
+    }
+    bool Started() const override { return m_writer.has_value(); }
+    void Finish() { m_writer->Flush(); }
+};
+
+BOOST_AUTO_TEST_CASE(rpc_stream_results)
+{
+    const auto check_streamed{[&](const std::string& method, const UniValue& params) {
+        JSONRPCRequest request;
+        request.context = &m_node;
+        request.strMethod = method;
+        request.params = params;
+        if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+        const UniValue expected{tableRPC.execute(request)};
+
+        StringResultStream stream;
+        request.result_stream = &stream;
+        BOOST_CHECK(tableRPC.execute(request).isNull());
+        BOOST_REQUIRE(stream.Started());
+        stream.Finish();
+        BOOST_CHECK_EQUAL(stream.m_result, expected.write());
+    }};
+
+    const std::string genesis{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Genesis()->GetBlockHash().GetHex())};
+    for (const int verbosity : {2, 3}) {
+        UniValue params{UniValue::VARR};
+        params.push_back(genesis);
+        params.push_back(verbosity);
+        check_streamed("getblock", params);
+    }
+
+    // Summaries that are small anyway are returned as usual.
+    JSONRPCRequest request;
+    request.context = &m_node;
+    request.strMethod = "getblock";
+    request.params = UniValue{UniValue::VARR};
+    request.params.push_back(genesis);
+    StringResultStream stream;
+    request.result_stream = &stream;
+    BOOST_CHECK(tableRPC.execute(request).isObject());
+    BOOST_CHECK(!stream.Started());
+
+    CTxMemPool& pool{*Assert(m_node.mempool)};
+    {
+        LOCK2(cs_main, pool.cs);
+        TestMemPoolEntryHelper entry;
+        for (int i = 0; i < 3; ++i) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].scriptSig = CScript() << OP_1;
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = i;
+            pool.addUnchecked(entry.Fee(1000 * i).FromTx(tx));
+        }
+    }
+    UniValue params{UniValue::VARR};
+    params.push_back(true);
+    check_streamed("getrawmempool", params);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_parallel_batch)
+{
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    JSONRPCRequest jreq;
+    jreq.context = &m_node;
+
+    UniValue batch{UniValue::VARR};
+    for (int i = 0; i < 50; ++i) {
+        batch.push_back(JSONRPCRequestObj(i % 2 ? "getblockcount" : "getblockhash", JSON(i % 3 ? "[0]" : "[1]"), i));
+    }
+    batch.push_back(JSON("[]"));
+    batch.push_back(JSONRPCRequestObj("getblockhash", JSON("[]"), "missing param"));
+    const std::string expected{JSONRPCExecBatch(jreq, batch)};
+    BOOST_CHECK_EQUAL(JSON(expected).size(), batch.size());
+
+    std::vector<std::thread> threads;
+    int tasks{0};
+    const RPCTaskRunner run_task{[&](std::function<void()> task) {
+        ++tasks;
+        threads.emplace_back(std::move(task));
+        return true;
+    }};
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, run_task, /*max_threads=*/4), expected);
+    BOOST_CHECK_EQUAL(tasks, 3);
+    // Tasks that can't be started leave the work to the calling thread.
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, [&](std::function<void()>) { ++tasks; return false; }, /*max_threads=*/4), expected);
+    BOOST_CHECK_EQUAL(tasks, 4);
+    for (auto& thread : threads) thread.join();
+
+    // A method with side effects makes the whole batch sequential.
+    batch.push_back(JSONRPCRequestObj("setmocktime", JSON("[0]"), "side effect"));
+    JSONRPCExecBatch(jreq, batch, run_task, /*max_threads=*/4);
+    BOOST_CHECK_EQUAL(tasks, 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
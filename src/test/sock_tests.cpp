@@ -11,7 +11,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cassert>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -125,6 +127,24 @@ BOOST_AUTO_TEST_CASE(send_and_receive)
     BOOST_CHECK(SocketIsClosed(s[1]));
 }
 
+BOOST_AUTO_TEST_CASE(send_many)
+{
+    int s[2];
+    CreateSocketPair(s);
+
+    Sock sender(s[0]);
+    Sock receiver(s[1]);
+
+    const uint8_t first[]{'a', 'b'};
+    const uint8_t last[]{'c', 'd', 'e'};
+    const Span<const uint8_t> chunks[]{first, {}, last};
+    BOOST_CHECK_EQUAL(sender.SendMany(chunks, 0), 5);
+
+    char recv_buf[10];
+    BOOST_CHECK_EQUAL(receiver.Recv(recv_buf, sizeof(recv_buf), 0), 5);
+    BOOST_CHECK_EQUAL(strncmp("abcde", recv_buf, 5), 0);
+}
+
 BOOST_AUTO_TEST_CASE(wait)
 {
     int s[2];
@@ -169,6 +189,53 @@ BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
     receiver.join();
 }
 
+#ifdef USE_EPOLL
+BOOST_AUTO_TEST_CASE(epoll_edge_triggered)
+{
+    int s[2];
+    CreateSocketPair(s);
+    Sock sock0(s[0]);
+    auto sock1{std::make_unique<Sock>(s[1])};
+
+    SockEpoll epoll;
+    BOOST_REQUIRE(epoll.IsValid());
+    BOOST_REQUIRE(epoll.Add(sock0, Sock::RECV, /*id=*/7, /*edge_triggered=*/true));
+
+    std::vector<SockEpoll::Event> events;
+    BOOST_REQUIRE(epoll.Wait(0ms, 10, events));
+    BOOST_CHECK(events.empty());
+
+    // Readiness is reported once, even if the data is not read.
+    BOOST_REQUIRE_EQUAL(sock1->Send("a", 1, 0), 1);
+    BOOST_REQUIRE(epoll.Wait(1min, 10, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 1U);
+    BOOST_CHECK_EQUAL(events[0].id, 7U);
+    BOOST_CHECK_EQUAL(events[0].occurred, Sock::RECV);
+    BOOST_REQUIRE(epoll.Wait(0ms, 10, events));
+    BOOST_CHECK(events.empty());
+
+    // New data is a new edge.
+    BOOST_REQUIRE_EQUAL(sock1->Send("b", 1, 0), 1);
+    BOOST_REQUIRE(epoll.Wait(1min, 10, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 1U);
+
+    // A removed socket is not reported anymore.
+    BOOST_REQUIRE(epoll.Remove(sock0));
+    BOOST_REQUIRE_EQUAL(sock1->Send("c", 1, 0), 1);
+    BOOST_REQUIRE(epoll.Wait(0ms, 10, events));
+    BOOST_CHECK(events.empty());
+
+    // A hangup of the other side is reported as an error.
+    BOOST_REQUIRE(epoll.Add(sock0, Sock::RECV, /*id=*/8, /*edge_triggered=*/true));
+    BOOST_REQUIRE(epoll.Wait(1min, 10, events));
+    sock1.reset();
+    BOOST_REQUIRE(epoll.Wait(1min, 10, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 1U);
+    BOOST_CHECK_EQUAL(events[0].id, 8U);
+    BOOST_CHECK(events[0].occurred & Sock::ERR);
+}
+#endif // USE_EPOLL
+
 #endif /* WIN32 */
 
 BOOST_AUTO_TEST_SUITE_END()
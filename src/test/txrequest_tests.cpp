@@ -728,6 +728,58 @@ void TestInterleavedScenarios()
     BOOST_CHECK(runner.expired.empty());
 }
 
+/** Check that ReceivedInvs has the same effect as ReceivedInv for each announcement in the batch. */
+void TestReceivedInvs()
+{
+    // Deterministic trackers, so both compute the same priorities.
+    TxRequestTracker batched(true), single(true);
+
+    // A pool of txhashes, small enough for batches to overlap and contain duplicates.
+    std::vector<uint256> txhashes(200);
+    for (auto& txhash : txhashes) txhash = InsecureRand256();
+    auto now = RandomTime1y();
+
+    for (int round = 0; round < 50; ++round) {
+        const NodeId peer = InsecureRandRange(8);
+        const bool preferred = InsecureRandBool();
+        const bool wtxid = InsecureRandBool();
+        const auto reqtime = now + RandomTime8s();
+        const size_t max_announcements = InsecureRandBool() ? std::numeric_limits<size_t>::max() : 1 + InsecureRandRange(60);
+        std::vector<GenTxid> gtxids;
+        for (int i = InsecureRandRange(40); i > 0; --i) {
+            gtxids.emplace_back(wtxid, txhashes[InsecureRandRange(txhashes.size())]);
+        }
+
+        batched.ReceivedInvs(peer, gtxids, preferred, reqtime, max_announcements);
+        for (const auto& gtxid : gtxids) {
+            if (single.Count(peer) >= max_announcements) break;
+            single.ReceivedInv(peer, gtxid, preferred, reqtime);
+        }
+        batched.SanityCheck();
+        BOOST_CHECK_EQUAL(batched.Size(), single.Size());
+
+        // Request and complete some of what became requestable.
+        now += RandomTime8s();
+        for (NodeId p = 0; p < 8; ++p) {
+            const auto requestable = batched.GetRequestable(p, now);
+            BOOST_CHECK(requestable == single.GetRequestable(p, now));
+            batched.PostGetRequestableSanityCheck(now);
+            BOOST_CHECK_EQUAL(batched.Count(p), single.Count(p));
+            BOOST_CHECK_EQUAL(batched.CountCandidates(p), single.CountCandidates(p));
+            for (const auto& gtxid : requestable) {
+                if (InsecureRandBool()) continue;
+                const auto expiry = now + RandomTime8s();
+                batched.RequestedTx(p, gtxid.GetHash(), expiry);
+                single.RequestedTx(p, gtxid.GetHash(), expiry);
+                if (InsecureRandBool()) {
+                    batched.ReceivedResponse(p, gtxid.GetHash());
+                    single.ReceivedResponse(p, gtxid.GetHash());
+                }
+            }
+        }
+    }
+}
+
 }  // namespace
 
 BOOST_AUTO_TEST_CASE(TxRequestTest)
@@ -737,4 +789,11 @@ BOOST_AUTO_TEST_CASE(TxRequestTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(TxRequestBatchTest)
+{
+    for (int i = 0; i < 5; ++i) {
+        TestReceivedInvs();
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
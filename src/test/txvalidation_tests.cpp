@@ -48,4 +48,41 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that submitting a batch of transactions gives the same results as
+ * submitting them one by one, including for transactions that depend on an
+ * earlier one in the batch.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_process_transactions, TestChain100Setup)
+{
+    const CScript spk{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/0,
+                                                                                   coinbaseKey, spk, CAmount(48 * COIN), /*submit=*/false))};
+    const CTransactionRef child{MakeTransactionRef(CreateValidMempoolTransaction(parent, /*input_vout=*/0, /*input_height=*/101,
+                                                                                  coinbaseKey, spk, CAmount(47 * COIN), /*submit=*/false))};
+    CMutableTransaction coinbase_tx;
+    coinbase_tx.vin.resize(1);
+    coinbase_tx.vin[0].scriptSig = CScript() << OP_11 << OP_EQUAL;
+    coinbase_tx.vout.resize(1);
+    coinbase_tx.vout[0].nValue = 1 * CENT;
+    coinbase_tx.vout[0].scriptPubKey = spk;
+
+    const size_t initial_pool_size{WITH_LOCK(m_node.mempool->cs, return m_node.mempool->size())};
+    const TxAcceptStageStats initial_stats{WITH_LOCK(cs_main, return m_node.chainman->m_tx_accept_stats)};
+    const auto results{m_node.chainman->ProcessTransactions({parent, child, parent, MakeTransactionRef(coinbase_tx)})};
+
+    BOOST_REQUIRE_EQUAL(results.size(), 4U);
+    BOOST_CHECK(results[0].m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(results[1].m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK(results[2].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[2].m_state.GetRejectReason(), "txn-already-in-mempool");
+    BOOST_CHECK(results[3].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[3].m_state.GetRejectReason(), "coinbase");
+
+    BOOST_CHECK_EQUAL(WITH_LOCK(m_node.mempool->cs, return m_node.mempool->size()), initial_pool_size + 2);
+    LOCK(cs_main);
+    BOOST_CHECK_EQUAL(m_node.chainman->m_tx_accept_stats.batches, initial_stats.batches + 1);
+    BOOST_CHECK_EQUAL(m_node.chainman->m_tx_accept_stats.transactions, initial_stats.transactions + 4);
+}
 BOOST_AUTO_TEST_SUITE_END()
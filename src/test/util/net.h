@@ -124,6 +124,13 @@ public:
 
     ssize_t Send(const void*, size_t len, int) const override { return len; }
 
+    ssize_t SendMany(Span<const Span<const uint8_t>> chunks, int) const override
+    {
+        size_t len{0};
+        for (const auto& chunk : chunks) len += chunk.size();
+        return len;
+    }
+
     ssize_t Recv(void* buf, size_t len, int flags) const override
     {
         const size_t consume_bytes{std::min(len, m_contents.size() - m_consumed)};
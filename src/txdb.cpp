@@ -12,11 +12,13 @@
 #include <random.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/thread.h>
 #include <util/vector.h>
 
 #include <cassert>
 #include <cstdlib>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 
 static constexpr uint8_t DB_COIN{'C'};
@@ -51,8 +53,14 @@ CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options) :
     m_options{std::move(options)},
     m_db{std::make_unique<CDBWrapper>(m_db_params)} { }
 
+CCoinsViewDB::~CCoinsViewDB()
+{
+    WaitForBackgroundWrite();
+}
+
 void CCoinsViewDB::ResizeCache(size_t new_cache_size)
 {
+    WaitForBackgroundWrite();
     // We can't do this operation with an in-memory DB since we'll lose all the coins upon
     // reset.
     if (!m_db_params.memory_only) {
@@ -65,15 +73,57 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size)
     }
 }
 
+std::shared_ptr<const CCoinsFlushBatch> CCoinsViewDB::GetPending() const
+{
+    LOCK(m_pending_mutex);
+    return m_pending;
+}
+
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
+    if (const auto pending{GetPending()}) {
+        if (const auto it{pending->coins.find(outpoint)}; it != pending->coins.end()) {
+            coin = it->second.coin;
+            return !coin.IsSpent();
+        }
+    }
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
 
+std::vector<std::optional<Coin>> CCoinsViewDB::GetCoins(Span<const COutPoint> outpoints) const {
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<CoinEntry> entries;
+    std::vector<size_t> entries_pos;
+    entries.reserve(outpoints.size());
+    entries_pos.reserve(outpoints.size());
+    const auto pending{GetPending()};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (pending) {
+            if (const auto it{pending->coins.find(outpoints[i])}; it != pending->coins.end()) {
+                if (!it->second.coin.IsSpent()) coins[i] = it->second.coin;
+                continue;
+            }
+        }
+        entries.emplace_back(&outpoints[i]);
+        entries_pos.push_back(i);
+    }
+    std::vector<std::optional<Coin>> read{m_db->ReadMany<Coin>(Span<const CoinEntry>{entries})};
+    for (size_t j = 0; j < read.size(); ++j) {
+        coins[entries_pos[j]] = std::move(read[j]);
+    }
+    return coins;
+}
+
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
+    if (const auto pending{GetPending()}) {
+        if (const auto it{pending->coins.find(outpoint)}; it != pending->coins.end()) {
+            return !it->second.coin.IsSpent();
+        }
+    }
     return m_db->Exists(CoinEntry(&outpoint));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
+    if (const auto pending{GetPending()}) return pending->hashBlock;
     uint256 hashBestChain;
     if (!m_db->Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
@@ -89,12 +139,56 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) {
+    // Writes must land in the order they were made.
+    if (!WaitForBackgroundWrite()) return false;
+    return WriteCoins(mapCoins, hashBlock, erase);
+}
+
+bool CCoinsViewDB::BatchWriteInBackground(CCoinsFlushBatch&& batch, std::function<void()> on_complete)
+{
+    LOCK(m_flush_thread_mutex);
+    if (m_flush_thread.joinable()) m_flush_thread.join();
+    if (m_background_write_failed) return false;
+
+    auto pending{std::make_shared<const CCoinsFlushBatch>(std::move(batch))};
+    WITH_LOCK(m_pending_mutex, m_pending = pending);
+    m_flush_thread = std::thread(&util::TraceThread, "coinsflush", [this, pending = std::move(pending), on_complete = std::move(on_complete)] {
+        bool ok{false};
+        try {
+            ok = WriteCoins(pending->coins, pending->hashBlock, /*erase=*/false);
+        } catch (const std::exception& e) {
+            LogPrintf("Error writing coins database in background: %s\n", e.what());
+        }
+        if (!ok) {
+            // Keep serving reads from the batch; the next write or flush
+            // reports the failure.
+            m_background_write_failed = true;
+            return;
+        }
+        WITH_LOCK(m_pending_mutex, m_pending.reset());
+        if (on_complete) on_complete();
+    });
+    return true;
+}
+
+bool CCoinsViewDB::WaitForBackgroundWrite() const
+{
+    LOCK(m_flush_thread_mutex);
+    if (m_flush_thread.joinable()) m_flush_thread.join();
+    return !m_background_write_failed;
+}
+
+template <typename Map>
+bool CCoinsViewDB::WriteCoins(Map& mapCoins, const uint256& hashBlock, bool erase)
+{
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
     assert(!hashBlock.IsNull());
 
-    uint256 old_tip = GetBestBlock();
+    // Read the tip from disk, not through a pending background batch.
+    uint256 old_tip;
+    if (!m_db->Read(DB_BEST_BLOCK, old_tip)) old_tip.SetNull();
     if (old_tip.IsNull()) {
         // We may be in the middle of replaying.
         std::vector<uint256> old_heads = GetHeadBlocks();
@@ -114,7 +208,7 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (auto it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
@@ -124,7 +218,11 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, boo
             changed++;
         }
         count++;
-        it = erase ? mapCoins.erase(it) : std::next(it);
+        if constexpr (std::is_const_v<Map>) {
+            ++it;
+        } else {
+            it = erase ? mapCoins.erase(it) : std::next(it);
+        }
         if (batch.SizeEstimate() > m_options.batch_write_bytes) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
             m_db->WriteBatch(batch);
@@ -179,6 +277,9 @@ private:
 
 std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
 {
+    // The cursor iterates the database directly, so it must not miss a
+    // batch that is still being written.
+    WaitForBackgroundWrite();
     auto i = std::make_unique<CCoinsViewDBCursor>(
         const_cast<CDBWrapper&>(*m_db).NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
@@ -12,10 +12,13 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <vector>
 
 class COutPoint;
@@ -39,6 +42,8 @@ static const int64_t nMaxTxIndexCache = 1024;
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -dbbackgroundflush default
+static constexpr bool DEFAULT_DB_BACKGROUND_FLUSH{false};
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
@@ -47,6 +52,8 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Write periodic coins cache flushes from a background thread.
+    bool background_flush = DEFAULT_DB_BACKGROUND_FLUSH;
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -56,16 +63,54 @@ protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
     std::unique_ptr<CDBWrapper> m_db;
+
+    //! Protects m_flush_thread against concurrent start and join.
+    mutable Mutex m_flush_thread_mutex;
+    //! Thread writing the current background batch, if any.
+    mutable std::thread m_flush_thread GUARDED_BY(m_flush_thread_mutex);
+    mutable Mutex m_pending_mutex;
+    //! Batch being written by m_flush_thread. Reads consult it before the
+    //! database, so they observe the batch before it is fully on disk.
+    std::shared_ptr<const CCoinsFlushBatch> m_pending GUARDED_BY(m_pending_mutex);
+    //! Set when a background write failed.
+    mutable std::atomic<bool> m_background_write_failed{false};
+
+    std::shared_ptr<const CCoinsFlushBatch> GetPending() const EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+    template <typename Map>
+    bool WriteCoins(Map& mapCoins, const uint256& hashBlock, bool erase);
+
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
+    ~CCoinsViewDB();
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>> GetCoins(Span<const COutPoint> outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
 
+    /**
+     * Write a batch detached from a cache (see CCoinsViewCache::TakeFlushBatch())
+     * in a background thread. Until the write completes, reads through this
+     * view are served from the batch first. The DB_HEAD_BLOCKS markers make a
+     * crash during the write recoverable exactly as for BatchWrite().
+     * Waits for any previous background write to finish before starting.
+     *
+     * @param[in] on_complete  called from the background thread after the batch
+     *                         was written successfully
+     * @returns false if a previous background write failed
+     */
+    bool BatchWriteInBackground(CCoinsFlushBatch&& batch, std::function<void()> on_complete) EXCLUSIVE_LOCKS_REQUIRED(!m_flush_thread_mutex, !m_pending_mutex);
+
+    //! Wait for the background write started by BatchWriteInBackground(), if any.
+    //! @returns false if a background write failed
+    bool WaitForBackgroundWrite() const EXCLUSIVE_LOCKS_REQUIRED(!m_flush_thread_mutex);
+
+    //! Whether periodic flushes of caches on top of this view should use BatchWriteInBackground().
+    bool BackgroundFlushEnabled() const { return m_options.background_flush; }
+
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
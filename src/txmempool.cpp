@@ -25,8 +25,11 @@
 #include <util/translation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <queue>
+#include <unordered_map>
 #include <optional>
 #include <string_view>
 #include <utility>
@@ -51,25 +54,35 @@ bool TestLockPointValidity(CChain& active_chain, const LockPoints& lp)
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    WITH_FRESH_EPOCH(m_epoch);
+    // Use epoch: visiting an entry means it has been added to descendants.
+    std::vector<txiter>& stageEntries{m_traversal_stage};
+    std::vector<txiter>& descendants{m_traversal_found};
+    stageEntries.clear();
+    descendants.clear();
+    for (const CTxMemPoolEntry& child : updateIt->GetMemPoolChildrenConst()) {
+        const txiter child_it{mapTx.iterator_to(child)};
+        visited(child_it);
+        stageEntries.push_back(child_it);
+    }
 
     while (!stageEntries.empty()) {
-        const CTxMemPoolEntry& descendant = *stageEntries.begin();
-        descendants.insert(descendant);
-        stageEntries.erase(descendant);
-        const CTxMemPoolEntry::Children& children = descendant.GetMemPoolChildrenConst();
+        const txiter descendant{stageEntries.back()};
+        stageEntries.pop_back();
+        descendants.push_back(descendant);
+        const CTxMemPoolEntry::Children& children = descendant->GetMemPoolChildrenConst();
         for (const CTxMemPoolEntry& childEntry : children) {
-            cacheMap::iterator cacheIt = cachedDescendants.find(mapTx.iterator_to(childEntry));
+            const txiter child_it{mapTx.iterator_to(childEntry)};
+            cacheMap::iterator cacheIt = cachedDescendants.find(child_it);
             if (cacheIt != cachedDescendants.end()) {
                 // We've already calculated this one, just add the entries for this set
                 // but don't traverse again.
                 for (txiter cacheEntry : cacheIt->second) {
-                    descendants.insert(*cacheEntry);
+                    if (!visited(cacheEntry)) descendants.push_back(cacheEntry);
                 }
-            } else if (!descendants.count(childEntry)) {
+            } else if (!visited(child_it)) {
                 // Schedule for later processing
-                stageEntries.insert(childEntry);
+                stageEntries.push_back(child_it);
             }
         }
     }
@@ -78,21 +91,21 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
     int32_t modifySize = 0;
     CAmount modifyFee = 0;
     int64_t modifyCount = 0;
-    for (const CTxMemPoolEntry& descendant : descendants) {
-        if (!setExclude.count(descendant.GetTx().GetHash())) {
-            modifySize += descendant.GetTxSize();
-            modifyFee += descendant.GetModifiedFee();
+    for (const txiter descendant : descendants) {
+        if (!setExclude.count(descendant->GetTx().GetHash())) {
+            modifySize += descendant->GetTxSize();
+            modifyFee += descendant->GetModifiedFee();
             modifyCount++;
-            cachedDescendants[updateIt].insert(mapTx.iterator_to(descendant));
+            cachedDescendants[updateIt].push_back(descendant);
             // Update ancestor state for each descendant
-            mapTx.modify(mapTx.iterator_to(descendant), [=](CTxMemPoolEntry& e) {
+            mapTx.modify(descendant, [=](CTxMemPoolEntry& e) {
               e.UpdateAncestorState(updateIt->GetTxSize(), updateIt->GetModifiedFee(), 1, updateIt->GetSigOpCost());
             });
             // Don't directly remove the transaction here -- doing so would
             // invalidate iterators in cachedDescendants. Mark it for removal
             // by inserting into descendants_to_remove.
-            if (descendant.GetCountWithAncestors() > uint64_t(m_limits.ancestor_count) || descendant.GetSizeWithAncestors() > m_limits.ancestor_size_vbytes) {
-                descendants_to_remove.insert(descendant.GetTx().GetHash());
+            if (descendant->GetCountWithAncestors() > uint64_t(m_limits.ancestor_count) || descendant->GetSizeWithAncestors() > m_limits.ancestor_size_vbytes) {
+                descendants_to_remove.insert(descendant->GetTx().GetHash());
             }
         }
     }
@@ -157,18 +170,23 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
 util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimits(
     int64_t entry_size,
     size_t entry_count,
-    CTxMemPoolEntry::Parents& staged_ancestors,
+    std::vector<txiter>& staged_ancestors,
     const Limits& limits) const
 {
     int64_t totalSizeWithAncestors = entry_size;
-    setEntries ancestors;
+    // Use epoch: visiting an entry means it has been staged, and will be moved to ancestors.
+    std::vector<txiter>& ancestors{m_traversal_found};
+    ancestors.clear();
 
+    // Process staged entries in txid order, so that the reported limit violation is deterministic.
+    const auto by_hash_desc{[](const txiter& a, const txiter& b) { return CompareIteratorByHash{}(b, a); }};
+    std::make_heap(staged_ancestors.begin(), staged_ancestors.end(), by_hash_desc);
     while (!staged_ancestors.empty()) {
-        const CTxMemPoolEntry& stage = staged_ancestors.begin()->get();
-        txiter stageit = mapTx.iterator_to(stage);
+        std::pop_heap(staged_ancestors.begin(), staged_ancestors.end(), by_hash_desc);
+        const txiter stageit{staged_ancestors.back()};
+        staged_ancestors.pop_back();
 
-        ancestors.insert(stageit);
-        staged_ancestors.erase(stage);
+        ancestors.push_back(stageit);
         totalSizeWithAncestors += stageit->GetTxSize();
 
         if (stageit->GetSizeWithDescendants() + entry_size > limits.descendant_size_vbytes) {
@@ -184,8 +202,9 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimit
             txiter parent_it = mapTx.iterator_to(parent);
 
             // If this is a new ancestor, add it.
-            if (ancestors.count(parent_it) == 0) {
-                staged_ancestors.insert(parent);
+            if (!visited(parent_it)) {
+                staged_ancestors.push_back(parent_it);
+                std::push_heap(staged_ancestors.begin(), staged_ancestors.end(), by_hash_desc);
             }
             if (staged_ancestors.size() + ancestors.size() + entry_count > static_cast<uint64_t>(limits.ancestor_count)) {
                 return util::Error{Untranslated(strprintf("too many unconfirmed ancestors [limit: %u]", limits.ancestor_count))};
@@ -193,7 +212,9 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateAncestorsAndCheckLimit
         }
     }
 
-    return ancestors;
+    // Sorting first makes every insertion hit the end of the set.
+    std::sort(ancestors.begin(), ancestors.end(), CompareIteratorByHash{});
+    return setEntries(ancestors.begin(), ancestors.end());
 }
 
 bool CTxMemPool::CheckPackageLimits(const Package& package,
@@ -217,12 +238,14 @@ bool CTxMemPool::CheckPackageLimits(const Package& package,
         return false;
     }
 
-    CTxMemPoolEntry::Parents staged_ancestors;
+    WITH_FRESH_EPOCH(m_epoch);
+    std::vector<txiter>& staged_ancestors{m_traversal_stage};
+    staged_ancestors.clear();
     for (const auto& tx : package) {
         for (const auto& input : tx->vin) {
             std::optional<txiter> piter = GetIter(input.prevout.hash);
-            if (piter) {
-                staged_ancestors.insert(**piter);
+            if (piter && !visited(*piter)) {
+                staged_ancestors.push_back(*piter);
                 if (staged_ancestors.size() + package.size() > static_cast<uint64_t>(m_limits.ancestor_count)) {
                     errString = strprintf("too many unconfirmed parents [limit: %u]", m_limits.ancestor_count);
                     return false;
@@ -245,7 +268,9 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
     const Limits& limits,
     bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    WITH_FRESH_EPOCH(m_epoch);
+    std::vector<txiter>& staged_ancestors{m_traversal_stage};
+    staged_ancestors.clear();
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -254,8 +279,8 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
         // iterate mapTx to find parents.
         for (unsigned int i = 0; i < tx.vin.size(); i++) {
             std::optional<txiter> piter = GetIter(tx.vin[i].prevout.hash);
-            if (piter) {
-                staged_ancestors.insert(**piter);
+            if (piter && !visited(*piter)) {
+                staged_ancestors.push_back(*piter);
                 if (staged_ancestors.size() + 1 > static_cast<uint64_t>(limits.ancestor_count)) {
                     return util::Error{Untranslated(strprintf("too many unconfirmed parents [limit: %u]", limits.ancestor_count))};
                 }
@@ -265,7 +290,11 @@ util::Result<CTxMemPool::setEntries> CTxMemPool::CalculateMemPoolAncestors(
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+            const txiter parent_it{mapTx.iterator_to(parent)};
+            visited(parent_it);
+            staged_ancestors.push_back(parent_it);
+        }
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1, staged_ancestors,
@@ -286,7 +315,8 @@ CTxMemPool::setEntries CTxMemPool::AssumeCalculateMemPoolAncestors(
     return std::move(result).value_or(CTxMemPool::setEntries{});
 }
 
-void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors)
+template <typename Ancestors>
+void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, const Ancestors& ancestors)
 {
     const CTxMemPoolEntry::Parents& parents = it->GetMemPoolParentsConst();
     // add or remove this tx as a child of each parent
@@ -296,7 +326,7 @@ void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors
     const int32_t updateCount = (add ? 1 : -1);
     const int32_t updateSize{updateCount * it->GetTxSize()};
     const CAmount updateFee = updateCount * it->GetModifiedFee();
-    for (txiter ancestorIt : setAncestors) {
+    for (txiter ancestorIt : ancestors) {
         mapTx.modify(ancestorIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(updateSize, updateFee, updateCount); });
     }
 }
@@ -323,7 +353,7 @@ void CTxMemPool::UpdateChildrenForRemoval(txiter it)
     }
 }
 
-void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants)
+void CTxMemPool::UpdateForRemoveFromMempool(const std::vector<txiter>& entriesToRemove, bool updateDescendants)
 {
     // For each entry, walk back all ancestors and decrement size associated with this
     // transaction
@@ -335,14 +365,16 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // and CTxMemPoolEntry::Children (which we need to preserve until we're
         // finished with all operations that need to traverse the mempool).
         for (txiter removeIt : entriesToRemove) {
-            setEntries setDescendants;
-            CalculateDescendants(removeIt, setDescendants);
-            setDescendants.erase(removeIt); // don't update state for self
+            WITH_FRESH_EPOCH(m_epoch);
+            std::vector<txiter>& descendants{m_traversal_found};
+            descendants.clear();
+            CalculateDescendants(removeIt, descendants);
             int32_t modifySize = -removeIt->GetTxSize();
             CAmount modifyFee = -removeIt->GetModifiedFee();
             int modifySigOps = -removeIt->GetSigOpCost();
-            for (txiter dit : setDescendants) {
-                mapTx.modify(dit, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFee, -1, modifySigOps); });
+            // descendants[0] is removeIt itself: don't update state for self
+            for (size_t i = 1; i < descendants.size(); ++i) {
+                mapTx.modify(descendants[i], [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFee, -1, modifySigOps); });
             }
         }
     }
@@ -367,7 +399,10 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // mempool parents we'd calculate by searching, and it's important that
         // we use the cached notion of ancestor transactions as the set of
         // things to update for removal.
-        auto ancestors{AssumeCalculateMemPoolAncestors(__func__, entry, Limits::NoLimits(), /*fSearchForParents=*/false)};
+        WITH_FRESH_EPOCH(m_epoch);
+        std::vector<txiter>& ancestors{m_traversal_found};
+        ancestors.clear();
+        CalculateAncestors(mapTx.iterator_to(entry), ancestors);
         // Note that UpdateAncestorsOf severs the child links that point to
         // removeIt in the entries for the parents of removeIt.
         UpdateAncestorsOf(false, removeIt, ancestors);
@@ -466,6 +501,8 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // In that case, our disconnect block logic will call UpdateTransactionsFromBlock
     // to clean up the mess we're leaving here.
 
+    InvalidateCluster(newit);
+
     // Update ancestors with information about this tx
     for (const auto& pit : GetIterSet(setParentTransactions)) {
             UpdateParent(newit, pit, true);
@@ -515,6 +552,8 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     for (const CTxIn& txin : it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
 
+    InvalidateCluster(it);
+
     RemoveUnbroadcastTx(hash, true /* add logging because unchecked */ );
 
     if (vTxHashes.size() > 1) {
@@ -543,36 +582,70 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 // can save time by not iterating over those entries.
 void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants) const
 {
-    setEntries stage;
-    if (setDescendants.count(entryit) == 0) {
-        stage.insert(entryit);
-    }
+    if (setDescendants.count(entryit)) return;
+    WITH_FRESH_EPOCH(m_epoch);
     // Traverse down the children of entry, only adding children that are not
     // accounted for in setDescendants already (because those children have either
     // already been walked, or will be walked in this iteration).
+    std::vector<txiter>& stage{m_traversal_stage};
+    stage.clear();
+    visited(entryit);
+    stage.push_back(entryit);
     while (!stage.empty()) {
-        txiter it = *stage.begin();
+        const txiter it{stage.back()};
+        stage.pop_back();
         setDescendants.insert(it);
-        stage.erase(it);
 
         const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
         for (const CTxMemPoolEntry& child : children) {
             txiter childiter = mapTx.iterator_to(child);
-            if (!setDescendants.count(childiter)) {
-                stage.insert(childiter);
+            if (!visited(childiter) && !setDescendants.count(childiter)) {
+                stage.push_back(childiter);
             }
         }
     }
 }
 
+void CTxMemPool::CalculateDescendants(txiter entryit, std::vector<txiter>& descendants) const
+{
+    if (visited(entryit)) return;
+    // descendants doubles as the work queue: everything from the first new
+    // entry on still has to have its children walked.
+    size_t next{descendants.size()};
+    descendants.push_back(entryit);
+    while (next < descendants.size()) {
+        const txiter it{descendants[next++]};
+        for (const CTxMemPoolEntry& child : it->GetMemPoolChildrenConst()) {
+            const txiter childiter{mapTx.iterator_to(child)};
+            if (!visited(childiter)) descendants.push_back(childiter);
+        }
+    }
+}
+
+void CTxMemPool::CalculateAncestors(txiter entryit, std::vector<txiter>& ancestors) const
+{
+    size_t next{ancestors.size()};
+    for (const CTxMemPoolEntry& parent : entryit->GetMemPoolParentsConst()) {
+        const txiter parentiter{mapTx.iterator_to(parent)};
+        if (!visited(parentiter)) ancestors.push_back(parentiter);
+    }
+    while (next < ancestors.size()) {
+        const txiter it{ancestors[next++]};
+        for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+            const txiter parentiter{mapTx.iterator_to(parent)};
+            if (!visited(parentiter)) ancestors.push_back(parentiter);
+        }
+    }
+}
+
 void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReason reason)
 {
     // Remove transaction from memory pool
     AssertLockHeld(cs);
-        setEntries txToRemove;
+        std::vector<txiter> txToRemove;
         txiter origit = mapTx.find(origTx.GetHash());
         if (origit != mapTx.end()) {
-            txToRemove.insert(origit);
+            txToRemove.push_back(origit);
         } else {
             // When recursively removing but origTx isn't in the mempool
             // be sure to remove any children that are in the pool. This can
@@ -584,15 +657,18 @@ void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReaso
                     continue;
                 txiter nextit = mapTx.find(it->second->GetHash());
                 assert(nextit != mapTx.end());
-                txToRemove.insert(nextit);
+                txToRemove.push_back(nextit);
             }
         }
-        setEntries setAllRemoves;
-        for (txiter it : txToRemove) {
-            CalculateDescendants(it, setAllRemoves);
+        std::vector<txiter> all_removes;
+        {
+            WITH_FRESH_EPOCH(m_epoch);
+            for (txiter it : txToRemove) {
+                CalculateDescendants(it, all_removes);
+            }
         }
 
-        RemoveStaged(setAllRemoves, false, reason);
+        RemoveStaged(all_removes, false, reason);
 }
 
 void CTxMemPool::removeForReorg(CChain& chain, std::function<bool(txiter)> check_final_and_mature)
@@ -601,15 +677,18 @@ void CTxMemPool::removeForReorg(CChain& chain, std::function<bool(txiter)> check
     AssertLockHeld(cs);
     AssertLockHeld(::cs_main);
 
-    setEntries txToRemove;
+    std::vector<txiter> txToRemove;
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
-        if (check_final_and_mature(it)) txToRemove.insert(it);
+        if (check_final_and_mature(it)) txToRemove.push_back(it);
     }
-    setEntries setAllRemoves;
-    for (txiter it : txToRemove) {
-        CalculateDescendants(it, setAllRemoves);
+    std::vector<txiter> all_removes;
+    {
+        WITH_FRESH_EPOCH(m_epoch);
+        for (txiter it : txToRemove) {
+            CalculateDescendants(it, all_removes);
+        }
     }
-    RemoveStaged(setAllRemoves, false, MemPoolRemovalReason::REORG);
+    RemoveStaged(all_removes, false, MemPoolRemovalReason::REORG);
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
         assert(TestLockPointValidity(chain, it->GetLockPoints()));
     }
@@ -653,8 +732,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     {
         txiter it = mapTx.find(tx->GetHash());
         if (it != mapTx.end()) {
-            setEntries stage;
-            stage.insert(it);
+            std::vector<txiter> stage{it};
             RemoveStaged(stage, true, MemPoolRemovalReason::BLOCK);
         }
         removeConflicts(*tx);
@@ -899,18 +977,22 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
         delta = SaturatingAdd(delta, nFeeDelta);
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
+            InvalidateCluster(it);
             mapTx.modify(it, [&nFeeDelta](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta); });
+            WITH_FRESH_EPOCH(m_epoch);
             // Now update all ancestors' modified fees with descendants
-            auto ancestors{AssumeCalculateMemPoolAncestors(__func__, *it, Limits::NoLimits(), /*fSearchForParents=*/false)};
-            for (txiter ancestorIt : ancestors) {
+            std::vector<txiter>& relatives{m_traversal_found};
+            relatives.clear();
+            CalculateAncestors(it, relatives);
+            for (txiter ancestorIt : relatives) {
                 mapTx.modify(ancestorIt, [=](CTxMemPoolEntry& e){ e.UpdateDescendantState(0, nFeeDelta, 0);});
             }
             // Now update all descendants' modified fees with ancestors
-            setEntries setDescendants;
-            CalculateDescendants(it, setDescendants);
-            setDescendants.erase(it);
-            for (txiter descendantIt : setDescendants) {
-                mapTx.modify(descendantIt, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
+            relatives.clear();
+            CalculateDescendants(it, relatives);
+            // relatives[0] is it itself
+            for (size_t i = 1; i < relatives.size(); ++i) {
+                mapTx.modify(relatives[i], [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDelta, 0, 0); });
             }
             ++nTransactionsUpdated;
         }
@@ -1059,6 +1141,14 @@ void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked)
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
     AssertLockHeld(cs);
+    std::vector<txiter> entries(stage.begin(), stage.end());
+    RemoveStaged(entries, updateDescendants, reason);
+}
+
+void CTxMemPool::RemoveStaged(std::vector<txiter>& stage, bool updateDescendants, MemPoolRemovalReason reason) {
+    AssertLockHeld(cs);
+    // Remove (and notify) in txid order, as when staging in a setEntries.
+    std::sort(stage.begin(), stage.end(), CompareIteratorByHash{});
     UpdateForRemoveFromMempool(stage, updateDescendants);
     for (txiter it : stage) {
         removeUnchecked(it, reason);
@@ -1069,14 +1159,13 @@ int CTxMemPool::Expire(std::chrono::seconds time)
 {
     AssertLockHeld(cs);
     indexed_transaction_set::index<entry_time>::type::iterator it = mapTx.get<entry_time>().begin();
-    setEntries toremove;
-    while (it != mapTx.get<entry_time>().end() && it->GetTime() < time) {
-        toremove.insert(mapTx.project<0>(it));
-        it++;
-    }
-    setEntries stage;
-    for (txiter removeit : toremove) {
-        CalculateDescendants(removeit, stage);
+    std::vector<txiter> stage;
+    {
+        WITH_FRESH_EPOCH(m_epoch);
+        while (it != mapTx.get<entry_time>().end() && it->GetTime() < time) {
+            CalculateDescendants(mapTx.project<0>(it), stage);
+            it++;
+        }
     }
     RemoveStaged(stage, false, MemPoolRemovalReason::EXPIRY);
     return stage.size();
@@ -1091,6 +1180,8 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, bool validFeeEstimat
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
+    InvalidateCluster(entry);
+    InvalidateCluster(child);
     CTxMemPoolEntry::Children s;
     if (add && entry->GetMemPoolChildren().insert(*child).second) {
         cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
@@ -1102,6 +1193,8 @@ void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
+    InvalidateCluster(entry);
+    InvalidateCluster(parent);
     CTxMemPoolEntry::Parents s;
     if (add && entry->GetMemPoolParents().insert(*parent).second) {
         cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
@@ -1159,8 +1252,11 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
 
-        setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        std::vector<txiter> stage;
+        {
+            WITH_FRESH_EPOCH(m_epoch);
+            CalculateDescendants(mapTx.project<0>(it), stage);
+        }
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1257,3 +1353,191 @@ std::vector<CTxMemPool::txiter> CTxMemPool::GatherClusters(const std::vector<uin
     }
     return clustered_txs;
 }
+
+void CTxMemPool::InvalidateCluster(txiter it)
+{
+    AssertLockHeld(cs);
+    if (m_all_clusters_dirty) return;
+    if (auto cluster{m_cluster_chunks.find(it->m_cluster_id)}; cluster != m_cluster_chunks.end()) {
+        // The cluster may split; every former member has to be re-clustered.
+        for (const ClusterChunk& chunk : cluster->second) {
+            for (const txiter& member : chunk.txs) {
+                m_dirty_cluster_txids.push_back(member->GetTx().GetHash());
+            }
+        }
+        m_cluster_chunks.erase(cluster);
+    }
+    m_dirty_cluster_txids.push_back(it->GetTx().GetHash());
+    // Rather than tracking individual changes when most of the mempool changed (or when
+    // GetClusterChunks() is not being called at all), rebuild everything on the next call.
+    if (m_dirty_cluster_txids.size() > 2 * mapTx.size()) {
+        m_all_clusters_dirty = true;
+        m_cluster_chunks.clear();
+        m_dirty_cluster_txids.clear();
+    }
+}
+
+namespace {
+/** Linearize a cluster and split the linearization into chunks. See CTxMemPool::GetClusterChunks(). */
+CTxMemPool::ClusterChunks LinearizeCluster(const CTxMemPool& pool, const std::vector<CTxMemPool::txiter>& cluster) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    const size_t n{cluster.size()};
+    std::unordered_map<const CTxMemPoolEntry*, uint32_t> index;
+    index.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) index.emplace(&*cluster[i], i);
+
+    // Ancestor state, restricted to transactions not yet in the linearization. Since a cluster
+    // contains all in-mempool ancestors of its transactions, it starts out equal to the
+    // entries' cached ancestor state.
+    struct TxState {
+        CAmount anc_fee;
+        int64_t anc_vsize;
+        int64_t anc_sigop_cost;
+        uint32_t version{0};
+        uint32_t mark{0};
+        bool included{false};
+    };
+    std::vector<TxState> state(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        state[i].anc_fee = cluster[i]->GetModFeesWithAncestors();
+        state[i].anc_vsize = cluster[i]->GetSizeWithAncestors();
+        state[i].anc_sigop_cost = cluster[i]->GetSigOpCostWithAncestors();
+    }
+
+    struct Candidate {
+        CAmount fee;
+        int64_t vsize;
+        uint32_t idx;
+        uint32_t version;
+    };
+    // Order candidates by ancestor feerate, ties broken by txid, like CompareTxMemPoolEntryByAncestorFee.
+    auto worse{[&](const Candidate& a, const Candidate& b) {
+        const double f1{double(a.fee) * b.vsize};
+        const double f2{double(b.fee) * a.vsize};
+        if (f1 == f2) return cluster[b.idx]->GetTx().GetHash() < cluster[a.idx]->GetTx().GetHash();
+        return f1 < f2;
+    }};
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> candidates{worse};
+    for (uint32_t i = 0; i < n; ++i) candidates.push({state[i].anc_fee, state[i].anc_vsize, i, 0});
+
+    std::vector<uint32_t> linearization;
+    linearization.reserve(n);
+    uint32_t round{0};
+    std::vector<uint32_t> todo;
+    while (linearization.size() < n) {
+        const Candidate best{candidates.top()};
+        candidates.pop();
+        if (state[best.idx].included || state[best.idx].version != best.version) continue;
+
+        // Collect best and its remaining ancestors.
+        ++round;
+        const size_t set_begin{linearization.size()};
+        todo.assign(1, best.idx);
+        state[best.idx].mark = round;
+        while (!todo.empty()) {
+            const uint32_t i{todo.back()};
+            todo.pop_back();
+            linearization.push_back(i);
+            for (const CTxMemPoolEntry& parent : cluster[i]->GetMemPoolParentsConst()) {
+                const uint32_t p{index.at(&parent)};
+                if (state[p].included || state[p].mark == round) continue;
+                state[p].mark = round;
+                todo.push_back(p);
+            }
+        }
+        // A transaction has more in-mempool ancestors than any of its ancestors, so sorting by
+        // ancestor count puts the set in a valid order (see BlockAssembler::SortForBlock).
+        std::sort(linearization.begin() + set_begin, linearization.end(), [&](uint32_t a, uint32_t b) {
+            if (cluster[a]->GetCountWithAncestors() != cluster[b]->GetCountWithAncestors()) {
+                return cluster[a]->GetCountWithAncestors() < cluster[b]->GetCountWithAncestors();
+            }
+            return a < b;
+        });
+        for (size_t pos = set_begin; pos < linearization.size(); ++pos) state[linearization[pos]].included = true;
+
+        // Remove the selected transactions from the ancestor state of their descendants.
+        for (size_t pos = set_begin; pos < linearization.size(); ++pos) {
+            const uint32_t added{linearization[pos]};
+            ++round;
+            todo.assign(1, added);
+            while (!todo.empty()) {
+                const uint32_t i{todo.back()};
+                todo.pop_back();
+                for (const CTxMemPoolEntry& child : cluster[i]->GetMemPoolChildrenConst()) {
+                    const uint32_t c{index.at(&child)};
+                    if (state[c].included || state[c].mark == round) continue;
+                    state[c].mark = round;
+                    state[c].anc_fee -= cluster[added]->GetModifiedFee();
+                    state[c].anc_vsize -= cluster[added]->GetTxSize();
+                    state[c].anc_sigop_cost -= cluster[added]->GetSigOpCost();
+                    ++state[c].version;
+                    candidates.push({state[c].anc_fee, state[c].anc_vsize, c, state[c].version});
+                    todo.push_back(c);
+                }
+            }
+        }
+    }
+
+    // Split the linearization into chunks: start a new chunk for every transaction, and merge it
+    // into the previous chunk as long as it has a higher feerate than that chunk.
+    CTxMemPool::ClusterChunks chunks;
+    for (const uint32_t i : linearization) {
+        chunks.push_back({{cluster[i]}, cluster[i]->GetModifiedFee(), cluster[i]->GetTxSize(), cluster[i]->GetSigOpCost()});
+        while (chunks.size() > 1) {
+            const auto& last{chunks.back()};
+            const auto& prev{chunks[chunks.size() - 2]};
+            if (double(last.fee) * prev.vsize <= double(prev.fee) * last.vsize) break;
+            auto& merged{chunks[chunks.size() - 2]};
+            merged.txs.insert(merged.txs.end(), last.txs.begin(), last.txs.end());
+            merged.fee += last.fee;
+            merged.vsize += last.vsize;
+            merged.sigop_cost += last.sigop_cost;
+            chunks.pop_back();
+        }
+    }
+    return chunks;
+}
+} // namespace
+
+std::vector<const CTxMemPool::ClusterChunks*> CTxMemPool::GetClusterChunks() const
+{
+    AssertLockHeld(cs);
+    if (m_all_clusters_dirty) {
+        m_cluster_chunks.clear();
+        m_dirty_cluster_txids.clear();
+        for (const CTxMemPoolEntry& entry : mapTx) m_dirty_cluster_txids.push_back(entry.GetTx().GetHash());
+        m_all_clusters_dirty = false;
+    }
+    if (!m_dirty_cluster_txids.empty()) {
+        WITH_FRESH_EPOCH(m_epoch);
+        std::vector<txiter> cluster;
+        auto add_unvisited{[&](const auto& entries) EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch) {
+            for (const CTxMemPoolEntry& entry : entries) {
+                const auto entry_it{mapTx.iterator_to(entry)};
+                if (!visited(entry_it)) cluster.push_back(entry_it);
+            }
+        }};
+        for (const uint256& txid : m_dirty_cluster_txids) {
+            const auto it{GetIter(txid)};
+            // Skip removed transactions and those already re-clustered in this loop.
+            if (!it || visited(*it)) continue;
+            cluster.assign(1, *it);
+            for (size_t i{0}; i < cluster.size(); ++i) {
+                add_unvisited(cluster[i]->GetMemPoolParentsConst());
+                add_unvisited(cluster[i]->GetMemPoolChildrenConst());
+            }
+            const uint64_t cluster_id{m_next_cluster_id++};
+            for (const txiter& member : cluster) {
+                m_cluster_chunks.erase(member->m_cluster_id);
+                member->m_cluster_id = cluster_id;
+            }
+            m_cluster_chunks.emplace(cluster_id, LinearizeCluster(*this, cluster));
+        }
+        m_dirty_cluster_txids.clear();
+    }
+
+    std::vector<const ClusterChunks*> result;
+    result.reserve(m_cluster_chunks.size());
+    for (const auto& [_, chunks] : m_cluster_chunks) result.push_back(&chunks);
+    return result;
+}
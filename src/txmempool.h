@@ -36,6 +36,7 @@
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -398,9 +399,38 @@ public:
 
     using Limits = kernel::MemPoolLimits;
 
+    /** A group of transactions from one cluster that should be included in a
+     *  block together, in a valid order for inclusion. */
+    struct ClusterChunk {
+        std::vector<txiter> txs;
+        CAmount fee{0}; //!< Sum of the modified fees of txs
+        int64_t vsize{0};
+        int64_t sigop_cost{0};
+    };
+    /** The chunks of a linearized cluster, in decreasing feerate order. Each
+     *  chunk only depends on transactions in itself and in earlier chunks. */
+    using ClusterChunks = std::vector<ClusterChunk>;
+
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 private:
-    typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
+    typedef std::map<txiter, std::vector<txiter>, CompareIteratorByHash> cacheMap;
+
+    //! Reusable scratch space for the epoch-based traversals below, so that walking the
+    //! mempool graph does not allocate. Only used while m_epoch is held, which rules out
+    //! nested use.
+    mutable std::vector<txiter> m_traversal_stage GUARDED_BY(cs);
+    mutable std::vector<txiter> m_traversal_found GUARDED_BY(cs);
+
+    //! Linearized chunks of each cluster, by cluster id (see CTxMemPoolEntry::m_cluster_id).
+    mutable std::unordered_map<uint64_t, ClusterChunks> m_cluster_chunks GUARDED_BY(cs);
+    //! Transactions whose cluster has to be (re-)linearized by GetClusterChunks().
+    mutable std::vector<uint256> m_dirty_cluster_txids GUARDED_BY(cs);
+    mutable uint64_t m_next_cluster_id GUARDED_BY(cs){1};
+    //! Whether all clusters have to be re-linearized, in which case changes are not tracked.
+    mutable bool m_all_clusters_dirty GUARDED_BY(cs){true};
+
+    /** Drop the cached linearization of the cluster containing it. */
+    void InvalidateCluster(txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
 
     void UpdateParent(txiter entry, txiter parent, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -420,16 +450,18 @@ private:
      *
      * @param[in]   entry_size          Virtual size to include in the limits.
      * @param[in]   entry_count         How many entries to include in the limits.
-     * @param[in]   staged_ancestors    Should contain entries in the mempool.
+     * @param[in]   staged_ancestors    Should contain distinct entries in the mempool, all of which
+     *                                  have been marked visited in the current epoch. Used as
+     *                                  scratch space.
      * @param[in]   limits              Maximum number and size of ancestors and descendants
      *
      * @return all in-mempool ancestors, or an error if any ancestor or descendant limits were hit
      */
     util::Result<setEntries> CalculateAncestorsAndCheckLimits(int64_t entry_size,
                                                               size_t entry_count,
-                                                              CTxMemPoolEntry::Parents &staged_ancestors,
+                                                              std::vector<txiter>& staged_ancestors,
                                                               const Limits& limits
-                                                              ) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                                                              ) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch);
 
 public:
     indirectmap<COutPoint, const CTransaction*> mapNextTx GUARDED_BY(cs);
@@ -538,7 +570,7 @@ public:
      *  Set updateDescendants to true when removing a tx that was in a block, so
      *  that any in-mempool descendants have their ancestor state updated.
      */
-    void RemoveStaged(setEntries& stage, bool updateDescendants, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void RemoveStaged(setEntries& stage, bool updateDescendants, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /** UpdateTransactionsFromBlock is called when adding transactions from a
      * disconnected block back to the mempool, new mempool entries may have
@@ -569,7 +601,7 @@ public:
      */
     util::Result<setEntries> CalculateMemPoolAncestors(const CTxMemPoolEntry& entry,
                                    const Limits& limits,
-                                   bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                                   bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /**
      * Same as CalculateMemPoolAncestors, but always returns a (non-optional) setEntries.
@@ -589,7 +621,7 @@ public:
         std::string_view calling_fn_name,
         const CTxMemPoolEntry &entry,
         const Limits& limits,
-        bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+        bool fSearchForParents = true) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /** Collect the entire cluster of connected transactions for each transaction in txids.
      * All txids must correspond to transaction entries in the mempool, otherwise this returns an
@@ -597,6 +629,17 @@ public:
      * more transactions as a DoS protection. */
     std::vector<txiter> GatherClusters(const std::vector<uint256>& txids) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Return the linearized chunks of every cluster of connected transactions in the mempool.
+     *
+     * Each cluster is linearized by repeatedly picking the remaining transaction with the highest
+     * ancestor feerate together with its remaining ancestors, after which the linearization is
+     * split into chunks of non-increasing feerate. Linearizations are cached until a transaction
+     * of the cluster is added, removed, linked to another transaction or prioritised, so this only
+     * does work for clusters that changed since the previous call.
+     *
+     * The returned pointers are invalidated by any modification of the mempool. */
+    std::vector<const ClusterChunks*> GetClusterChunks() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Calculate all in-mempool ancestors of a set of transactions not already in the mempool and
      * check ancestor and descendant limits. Heuristics are used to estimate the ancestor and
      * descendant count of all entries if the package were to be added to the mempool.  The limits
@@ -611,12 +654,12 @@ public:
      */
     bool CheckPackageLimits(const Package& package,
                             int64_t total_vsize,
-                            std::string &errString) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+                            std::string &errString) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /** Populate setDescendants with all in-mempool descendants of hash.
      *  Assumes that setDescendants includes all in-mempool descendants of anything
      *  already in it.  */
-    void CalculateDescendants(txiter it, setEntries& setDescendants) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void CalculateDescendants(txiter it, setEntries& setDescendants) const EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
 
     /** The minimum fee to get into the mempool, which may itself not be enough
      *  for larger-sized transactions.
@@ -765,15 +808,25 @@ private:
      *     removeRecursive them.
      */
     void UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
-                              const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove) EXCLUSIVE_LOCKS_REQUIRED(cs);
+                              const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove) EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
     /** Update ancestors of hash to add/remove it as a descendant transaction. */
-    void UpdateAncestorsOf(bool add, txiter hash, setEntries &setAncestors) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    template <typename Ancestors>
+    void UpdateAncestorsOf(bool add, txiter hash, const Ancestors& ancestors) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Set ancestor state for an entry */
     void UpdateEntryForAncestors(txiter it, const setEntries &setAncestors) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** For each transaction being removed, update ancestors and any direct children.
       * If updateDescendants is true, then also update in-mempool descendants'
       * ancestor state. */
-    void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void UpdateForRemoveFromMempool(const std::vector<txiter>& entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
+    /** Remove the transactions in stage, which must be distinct. See the public RemoveStaged(). */
+    void RemoveStaged(std::vector<txiter>& stage, bool updateDescendants, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs) LOCKS_EXCLUDED(m_epoch);
+    /** Append to ancestors all in-mempool ancestors of it, found through the cached parent
+     *  links, which have not been visited in the current epoch yet. */
+    void CalculateAncestors(txiter it, std::vector<txiter>& ancestors) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch);
+    /** Append to descendants it and all of its in-mempool descendants which have not been
+     *  visited in the current epoch yet. Calling this for several transactions within one
+     *  epoch collects the union of their descendants. */
+    void CalculateDescendants(txiter it, std::vector<txiter>& descendants) const EXCLUSIVE_LOCKS_REQUIRED(cs, m_epoch);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
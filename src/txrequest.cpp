@@ -8,6 +8,7 @@
 #include <net.h>
 #include <primitives/transaction.h>
 #include <random.h>
+#include <support/allocators/pool.h>
 #include <uint256.h>
 
 #include <boost/multi_index/indexed_by.hpp>
@@ -18,6 +19,7 @@
 #include <boost/tuple/tuple.hpp>
 
 #include <chrono>
+#include <numeric>
 #include <unordered_map>
 #include <utility>
 
@@ -218,6 +220,12 @@ struct ByTimeViewExtractor
     }
 };
 
+/** Allocator for the nodes of the main data structure. Each node holds an Announcement and, for each of the 3
+ *  ordered indexes, a parent and two child pointers. The exact layout is implementation defined, so leave room for
+ *  a few more. Nodes come from pooled chunks rather than one heap allocation per announcement, which keeps them
+ *  close together in memory and makes the frequent insertions and deletions cheap. */
+using IndexAllocator = PoolAllocator<Announcement, sizeof(Announcement) + sizeof(void*) * 12, alignof(void*)>;
+
 /** Data type for the main data structure (Announcement objects with ByPeer/ByTxHash/ByTime indexes). */
 using Index = boost::multi_index_container<
     Announcement,
@@ -225,7 +233,8 @@ using Index = boost::multi_index_container<
         boost::multi_index::ordered_unique<boost::multi_index::tag<ByPeer>, ByPeerViewExtractor>,
         boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTxHash>, ByTxHashViewExtractor>,
         boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTime>, ByTimeViewExtractor>
-    >
+    >,
+    IndexAllocator
 >;
 
 /** Helper type to simplify syntax of iterator types. */
@@ -318,6 +327,9 @@ class TxRequestTracker::Impl {
     //! This tracker's priority computer.
     const PriorityComputer m_computer;
 
+    //! Memory for the nodes of m_index.
+    IndexAllocator::ResourceType m_index_resource;
+
     //! This tracker's main data structure. See SanityCheck() for the invariants that apply to it.
     Index m_index;
 
@@ -532,7 +544,7 @@ public:
             boost::make_tuple(ByPeerViewExtractor(), std::less<ByPeerView>()),
             boost::make_tuple(ByTxHashViewExtractor(m_computer), std::less<ByTxHashView>()),
             boost::make_tuple(ByTimeViewExtractor(), std::less<ByTimeView>())
-        )) {}
+        ), IndexAllocator{&m_index_resource}) {}
 
     // Disable copying and assigning (a default copy won't work due the stateful ByTxHashViewExtractor).
     Impl(const Impl&) = delete;
@@ -596,6 +608,60 @@ public:
         ++m_current_sequence;
     }
 
+    void ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred,
+        std::chrono::microseconds reqtime, size_t max_announcements)
+    {
+        auto peerit = m_peerinfo.find(peer);
+        const size_t count{peerit == m_peerinfo.end() ? 0 : peerit->second.m_total};
+        if (gtxids.empty() || count >= max_announcements) return;
+
+        // Visit the batch in txhash order, so the lookups and insertions below walk the ByPeer index forward.
+        // Announcement order breaks ties, so only the first of duplicate txhashes is kept.
+        std::vector<uint32_t> order(gtxids.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return gtxids[a].GetHash() < gtxids[b].GetHash();
+        });
+
+        // Find the new announcements, and where in the ByPeer index each goes. Existing announcements for
+        // (peer, txhash) are either CANDIDATE_BEST ones, or sort at that position.
+        auto& index = m_index.get<ByPeer>();
+        std::vector<std::pair<uint32_t, Iter<ByPeer>>> added;
+        added.reserve(gtxids.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            const uint256& txhash = gtxids[order[i]].GetHash();
+            if (i > 0 && gtxids[order[i - 1]].GetHash() == txhash) continue;
+            auto it = index.lower_bound(ByPeerView{peer, false, txhash});
+            if (it != index.end() && it->m_peer == peer && it->m_txhash == txhash) continue;
+            if (index.count(ByPeerView{peer, true, txhash})) continue;
+            added.emplace_back(order[i], it);
+        }
+
+        // Only the earliest announced ones fit if the peer would go over the limit.
+        if (added.size() > max_announcements - count) {
+            std::nth_element(added.begin(), added.begin() + (max_announcements - count), added.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+            added.resize(max_announcements - count);
+            std::sort(added.begin(), added.end(), [&](const auto& a, const auto& b) {
+                return gtxids[a.first].GetHash() < gtxids[b.first].GetHash();
+            });
+        }
+        if (added.empty()) return;
+
+        // Sequence numbers follow announcement order, as if ReceivedInv had been called for each.
+        std::vector<uint32_t> positions(added.size());
+        std::transform(added.begin(), added.end(), positions.begin(), [](const auto& a) { return a.first; });
+        std::sort(positions.begin(), positions.end());
+        for (const auto& [pos, hint] : added) {
+            const SequenceNumber rank = std::lower_bound(positions.begin(), positions.end(), pos) - positions.begin();
+            index.emplace_hint(hint, gtxids[pos], peer, preferred, reqtime, m_current_sequence + rank);
+        }
+
+        // Update accounting metadata.
+        m_peerinfo[peer].m_total += added.size();
+        m_current_sequence += added.size();
+    }
+
     //! Find the GenTxids to request now from peer.
     std::vector<GenTxid> GetRequestable(NodeId peer, std::chrono::microseconds now,
         std::vector<std::pair<NodeId, GenTxid>>* expired)
@@ -737,6 +803,12 @@ void TxRequestTracker::ReceivedInv(NodeId peer, const GenTxid& gtxid, bool prefe
     m_impl->ReceivedInv(peer, gtxid, preferred, reqtime);
 }
 
+void TxRequestTracker::ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred,
+    std::chrono::microseconds reqtime, size_t max_announcements)
+{
+    m_impl->ReceivedInvs(peer, gtxids, preferred, reqtime, max_announcements);
+}
+
 void TxRequestTracker::RequestedTx(NodeId peer, const uint256& txhash, std::chrono::microseconds expiry)
 {
     m_impl->RequestedTx(peer, txhash, expiry);
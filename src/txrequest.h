@@ -7,9 +7,11 @@
 
 #include <primitives/transaction.h>
 #include <net.h> // For NodeId
+#include <span.h>
 #include <uint256.h>
 
 #include <chrono>
+#include <limits>
 #include <vector>
 
 #include <stdint.h>
@@ -131,6 +133,16 @@ public:
     void ReceivedInv(NodeId peer, const GenTxid& gtxid, bool preferred,
         std::chrono::microseconds reqtime);
 
+    /** Adds new CANDIDATE announcements for a batch of transactions announced together by one peer, such as the
+     *  contents of an inv message.
+     *
+     * This has the same effect as calling ReceivedInv for each gtxid in order, with the same preferred and reqtime
+     * values, except that no more are added once the peer has max_announcements announcements in total. The batch
+     * is processed in txhash order, which makes it cheaper than separate calls.
+     */
+    void ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred, std::chrono::microseconds reqtime,
+        size_t max_announcements = std::numeric_limits<size_t>::max());
+
     /** Deletes all announcements for a given peer.
      *
      * It should be called when a peer goes offline.
@@ -99,13 +99,22 @@ public:
     bool read(std::string_view raw);
 
 private:
+    // Objects with at least this many keys keep a hash index of their keys
+    static constexpr size_t KEY_INDEX_MIN_SIZE = 16;
+
     UniValue::VType typ;
     std::string val;                       // numbers are stored as C++ strings
     std::vector<std::string> keys;
     std::vector<UniValue> values;
+    // Open addressing hash table of (index into keys) + 1, 0 for an empty
+    // slot. Only used for objects with KEY_INDEX_MIN_SIZE or more keys.
+    std::vector<uint32_t> keyIndex;
 
     void checkType(const VType& expected) const;
-    bool findKey(const std::string& key, size_t& retIdx) const;
+    bool findKey(std::string_view key, size_t& retIdx) const;
+    void pushKey(std::string key);
+    void indexKey(size_t idx);
+    void writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
     void writeArray(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
     void writeObject(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const;
 
@@ -4,6 +4,7 @@
 #ifndef BITCOIN_UNIVALUE_INCLUDE_UNIVALUE_UTFFILTER_H
 #define BITCOIN_UNIVALUE_INCLUDE_UNIVALUE_UTFFILTER_H
 
+#include <cstddef>
 #include <string>
 
 /**
@@ -45,6 +46,15 @@ public:
                 push_back_u(codepoint);
         }
     }
+    // Write a run of 7-bit ASCII characters, as push_back would one by one
+    void append_ascii(const char* s, size_t n)
+    {
+        if (n == 0)
+            return;
+        if (state) // Not a continuation, invalid
+            is_valid = false;
+        str.append(s, n);
+    }
     // Write codepoint directly, possibly collating surrogate pairs
     void push_back_u(unsigned int codepoint_)
     {
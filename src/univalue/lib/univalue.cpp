@@ -5,11 +5,15 @@
 
 #include <univalue.h>
 
+#include <charconv>
+#include <cstdint>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -21,6 +25,7 @@ void UniValue::clear()
     val.clear();
     keys.clear();
     values.clear();
+    keyIndex.clear();
 }
 
 void UniValue::setNull()
@@ -55,22 +60,27 @@ void UniValue::setNumStr(std::string str)
     val = std::move(str);
 }
 
-void UniValue::setInt(uint64_t val_)
+template <typename Int>
+static std::string intToNumStr(Int val)
 {
-    std::ostringstream oss;
-
-    oss << val_;
+    // Large enough for any 64-bit integer and its sign
+    char buf[24];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), val).ptr);
+}
 
-    return setNumStr(oss.str());
+void UniValue::setInt(uint64_t val_)
+{
+    // An integer is always a valid number, there is no need for setNumStr's check
+    clear();
+    typ = VNUM;
+    val = intToNumStr(val_);
 }
 
 void UniValue::setInt(int64_t val_)
 {
-    std::ostringstream oss;
-
-    oss << val_;
-
-    return setNumStr(oss.str());
+    clear();
+    typ = VNUM;
+    val = intToNumStr(val_);
 }
 
 void UniValue::setFloat(double val_)
@@ -119,7 +129,7 @@ void UniValue::pushKVEnd(std::string key, UniValue val)
 {
     checkType(VOBJ);
 
-    keys.push_back(std::move(key));
+    pushKey(std::move(key));
     values.push_back(std::move(val));
 }
 
@@ -153,8 +163,51 @@ void UniValue::getObjMap(std::map<std::string,UniValue>& kv) const
         kv[keys[i]] = values[i];
 }
 
-bool UniValue::findKey(const std::string& key, size_t& retIdx) const
+void UniValue::pushKey(std::string key)
 {
+    keys.push_back(std::move(key));
+    if (keys.size() < KEY_INDEX_MIN_SIZE)
+        return;
+
+    if (keys.size() * 2 > keyIndex.size()) {
+        // Keep the load factor at or below 1/2, rebuilding from scratch
+        size_t slots = 1;
+        while (slots < keys.size() * 4)
+            slots *= 2;
+        keyIndex.assign(slots, 0);
+        for (size_t i = 0; i < keys.size(); i++)
+            indexKey(i);
+    } else {
+        indexKey(keys.size() - 1);
+    }
+}
+
+void UniValue::indexKey(size_t idx)
+{
+    const size_t mask = keyIndex.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(keys[idx]) & mask;
+    while (keyIndex[slot]) {
+        // Like the linear search, lookups find the first of duplicate keys
+        if (keys[keyIndex[slot] - 1] == keys[idx])
+            return;
+        slot = (slot + 1) & mask;
+    }
+    keyIndex[slot] = idx + 1;
+}
+
+bool UniValue::findKey(std::string_view key, size_t& retIdx) const
+{
+    if (!keyIndex.empty()) {
+        const size_t mask = keyIndex.size() - 1;
+        for (size_t slot = std::hash<std::string_view>{}(key) & mask; keyIndex[slot]; slot = (slot + 1) & mask) {
+            if (keys[keyIndex[slot] - 1] == key) {
+                retIdx = keyIndex[slot] - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
     for (size_t i = 0; i < keys.size(); i++) {
         if (keys[i] == key) {
             retIdx = i;
@@ -232,11 +285,10 @@ const char *uvTypeName(UniValue::VType t)
 
 const UniValue& UniValue::find_value(std::string_view key) const
 {
-    for (unsigned int i = 0; i < keys.size(); ++i) {
-        if (keys[i] == key) {
-            return values.at(i);
-        }
-    }
-    return NullUniValue;
+    size_t index = 0;
+    if (!findKey(key, index))
+        return NullUniValue;
+
+    return values.at(index);
 }
 
@@ -5,26 +5,51 @@
 #include <univalue.h>
 #include <univalue_escapes.h>
 
-#include <memory>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 
-static std::string json_escape(const std::string& inS)
+// Repeated byte values, for testing all bytes of a 64-bit word at once
+static constexpr uint64_t ONES = 0x0101010101010101ULL;
+static constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+// Whether any byte of the word is zero
+static inline bool hasZeroByte(uint64_t w)
 {
-    std::string outS;
-    outS.reserve(inS.size() * 2);
+    return (w - ONES) & ~w & HIGH_BITS;
+}
 
-    for (unsigned int i = 0; i < inS.size(); i++) {
-        unsigned char ch = static_cast<unsigned char>(inS[i]);
-        const char *escStr = escapes[ch];
+// Whether any byte of the word needs escaping: control characters, '"', '\\' or DEL
+static inline bool needsEscape(uint64_t w)
+{
+    const bool has_control = (w - ONES * 0x20) & ~w & HIGH_BITS;
+    return has_control || hasZeroByte(w ^ (ONES * '"')) || hasZeroByte(w ^ (ONES * '\\')) || hasZeroByte(w ^ (ONES * 0x7f));
+}
 
-        if (escStr)
-            outS += escStr;
-        else
-            outS += static_cast<char>(ch);
+static void json_escape(std::string_view in, std::string& out)
+{
+    size_t pos = 0;
+    while (pos < in.size()) {
+        // Skip over runs of characters that need no escaping, 8 at a time
+        size_t run_end = pos;
+        while (run_end + 8 <= in.size()) {
+            uint64_t word;
+            std::memcpy(&word, in.data() + run_end, 8);
+            if (needsEscape(word))
+                break;
+            run_end += 8;
+        }
+        while (run_end < in.size() && !escapes[static_cast<unsigned char>(in[run_end])])
+            run_end++;
+
+        out.append(in.data() + pos, run_end - pos);
+        if (run_end == in.size())
+            break;
+        out += escapes[static_cast<unsigned char>(in[run_end])];
+        pos = run_end + 1;
     }
-
-    return outS;
 }
 
 std::string UniValue::write(unsigned int prettyIndent,
@@ -37,18 +62,26 @@ std::string UniValue::write(unsigned int prettyIndent,
     if (modIndent == 0)
         modIndent = 1;
 
+    writeTo(prettyIndent, modIndent, s);
+    return s;
+}
+
+void UniValue::writeTo(unsigned int prettyIndent, unsigned int indentLevel, std::string& s) const
+{
     switch (typ) {
     case VNULL:
         s += "null";
         break;
     case VOBJ:
-        writeObject(prettyIndent, modIndent, s);
+        writeObject(prettyIndent, indentLevel, s);
         break;
     case VARR:
-        writeArray(prettyIndent, modIndent, s);
+        writeArray(prettyIndent, indentLevel, s);
         break;
     case VSTR:
-        s += "\"" + json_escape(val) + "\"";
+        s += '"';
+        json_escape(val, s);
+        s += '"';
         break;
     case VNUM:
         s += val;
@@ -57,8 +90,6 @@ std::string UniValue::write(unsigned int prettyIndent,
         s += (val == "1" ? "true" : "false");
         break;
     }
-
-    return s;
 }
 
 static void indentStr(unsigned int prettyIndent, unsigned int indentLevel, std::string& s)
@@ -75,7 +106,7 @@ void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, s
     for (unsigned int i = 0; i < values.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += values[i].write(prettyIndent, indentLevel + 1);
+        values[i].writeTo(prettyIndent, indentLevel + 1, s);
         if (i != (values.size() - 1)) {
             s += ",";
         }
@@ -97,10 +128,12 @@ void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel,
     for (unsigned int i = 0; i < keys.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += "\"" + json_escape(keys[i]) + "\":";
+        s += '"';
+        json_escape(keys[i], s);
+        s += "\":";
         if (prettyIndent)
             s += " ";
-        s += values.at(i).write(prettyIndent, indentLevel + 1);
+        values.at(i).writeTo(prettyIndent, indentLevel + 1, s);
         if (i != (values.size() - 1))
             s += ",";
         if (prettyIndent)
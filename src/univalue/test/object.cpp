@@ -382,6 +382,48 @@ void univalue_object()
 
 }
 
+void univalue_large_object()
+{
+    // Large objects are looked up through a key index, which must behave
+    // like the linear search used for small objects.
+    UniValue obj(UniValue::VOBJ);
+    for (int i = 0; i < 1000; ++i) {
+        obj.pushKVEnd("key" + std::to_string(i), i);
+    }
+    obj.pushKVEnd("key7", "duplicate");
+    BOOST_CHECK_EQUAL(obj.size(), 1001);
+    for (int i = 0; i < 1000; ++i) {
+        const std::string key = "key" + std::to_string(i);
+        BOOST_CHECK(obj.exists(key));
+        BOOST_CHECK_EQUAL(obj[key].getInt<int>(), i);
+        BOOST_CHECK_EQUAL(obj.find_value(key).getInt<int>(), i);
+    }
+    BOOST_CHECK(!obj.exists("key1000"));
+    BOOST_CHECK(obj["key1000"].isNull());
+
+    // pushKV replaces the first of duplicate keys
+    obj.pushKV("key7", "replaced");
+    BOOST_CHECK_EQUAL(obj["key7"].get_str(), "replaced");
+    BOOST_CHECK_EQUAL(obj.size(), 1001);
+
+    // Copies and parsed objects have working indexes too
+    UniValue copy = obj;
+    copy.pushKV("extra", true);
+    BOOST_CHECK(copy["extra"].get_bool());
+    BOOST_CHECK(!obj.exists("extra"));
+    UniValue parsed;
+    BOOST_CHECK(parsed.read(obj.write()));
+    BOOST_CHECK_EQUAL(parsed.size(), 1001);
+    BOOST_CHECK_EQUAL(parsed["key999"].getInt<int>(), 999);
+    BOOST_CHECK_EQUAL(parsed["key7"].get_str(), "replaced");
+    BOOST_CHECK_EQUAL(parsed.write(), obj.write());
+
+    obj.setObject();
+    BOOST_CHECK(!obj.exists("key0"));
+    obj.pushKV("key0", 1);
+    BOOST_CHECK_EQUAL(obj["key0"].getInt<int>(), 1);
+}
+
 static const char *json1 =
 "[1.10000000,{\"key1\":\"str\\u0000\",\"key2\":800,\"key3\":{\"name\":\"martian http://test.com\"}}]";
 
@@ -453,6 +495,22 @@ void univalue_readwrite()
     BOOST_CHECK(!v.read("[]{}"));
     BOOST_CHECK(!v.read("{}[]"));
     BOOST_CHECK(!v.read("{} 42"));
+
+    // Long strings take the word at a time paths of the reader and writer
+    std::string long_str;
+    for (int i = 0; i < 300; ++i) {
+        long_str += static_cast<char>(i % 128);
+        long_str += "abcdefghijkl\xc3\xa9";
+    }
+    const UniValue long_val(long_str);
+    const std::string long_json = long_val.write();
+    BOOST_CHECK(v.read(long_json));
+    BOOST_CHECK_EQUAL(v.get_str(), long_str);
+    BOOST_CHECK_EQUAL(v.write(), long_json);
+    BOOST_CHECK(long_json.find('\x7f') == std::string::npos);
+    BOOST_CHECK(long_json.find("\\u007f") != std::string::npos);
+    BOOST_CHECK(!v.read("\"abcdefghijklmnop\x01qrstuvwxyz\""));
+    BOOST_CHECK(!v.read("\"abcdefghijklmnop\xc3qrstuvwxyz\""));
 }
 
 int main(int argc, char* argv[])
@@ -463,6 +521,7 @@ int main(int argc, char* argv[])
     univalue_set();
     univalue_array();
     univalue_object();
+    univalue_large_object();
     univalue_readwrite();
     return 0;
 }
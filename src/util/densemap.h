@@ -0,0 +1,268 @@
+// Copyright (c) 2024 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_DENSEMAP_H
+#define BITCOIN_UTIL_DENSEMAP_H
+
+#include <memusage.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * DenseHashMap: an open-addressing hash map with contiguous value storage.
+ *
+ * Values are kept densely packed in a std::vector, in insertion order (until
+ * an erase moves the last value into the hole). A separate power-of-two array
+ * of 8-byte buckets maps hashes to value indices using robin hood linear
+ * probing. Each bucket stores its distance from the ideal slot together with
+ * 8 bits of the hash, so most unsuccessful probes are rejected without
+ * touching the values.
+ *
+ * Compared to a node-based std::unordered_map:
+ * - there is no per-entry allocation and no pointer chasing on lookup;
+ * - iteration walks a flat array;
+ * - memory usage is exactly the two vectors' capacity, see DynamicMemoryUsage().
+ *
+ * Erasure uses backward-shift deletion in the bucket array, so there are no
+ * tombstones and lookups do not slow down after many erasures. Growing the
+ * table only rebuilds the small bucket array; the values stay where they are.
+ *
+ * Differences from std::unordered_map that callers must be aware of:
+ * - value_type is std::pair<Key, T> (not const Key); do not modify keys
+ *   through iterators;
+ * - inserting may invalidate all iterators and references (like std::vector);
+ * - erase(it) moves the last value into `it`'s position and returns `it`,
+ *   which makes the usual `it = map.erase(it)` loop visit every element once.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual = std::equal_to<Key>>
+class DenseHashMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+private:
+    struct Bucket {
+        //! Upper 24 bits: distance from the ideal slot plus one (0 = empty). Lower 8 bits: hash fingerprint.
+        uint32_t dist_and_fingerprint{0};
+        //! Index of the value in m_values.
+        uint32_t value_idx{0};
+    };
+
+    static constexpr uint32_t DIST_INC{1U << 8};
+    static constexpr uint32_t FINGERPRINT_MASK{DIST_INC - 1};
+    //! Maximum load factor, as a fraction of 256.
+    static constexpr size_t MAX_LOAD_256{204};
+    static constexpr uint8_t INITIAL_SHIFTS{64 - 3};
+
+    std::vector<value_type> m_values;
+    std::vector<Bucket> m_buckets;
+    //! 64 - log2(m_buckets.size()); the ideal slot is the top bits of the hash.
+    uint8_t m_shifts{INITIAL_SHIFTS};
+    size_t m_max_size{0};
+    Hash m_hash;
+    KeyEqual m_equal;
+
+    uint64_t HashKey(const Key& key) const
+    {
+        // Spread the hash over 64 bits in case size_t is narrower or the hash
+        // only has entropy in its lower bits.
+        return uint64_t{m_hash(key)} * 0x9E3779B97F4A7C15ULL;
+    }
+    static uint32_t DistAndFingerprint(uint64_t hash) { return DIST_INC | (static_cast<uint32_t>(hash) & FINGERPRINT_MASK); }
+    size_t BucketIndex(uint64_t hash) const { return static_cast<size_t>(hash >> m_shifts); }
+    size_t Next(size_t idx) const { return idx + 1 == m_buckets.size() ? 0 : idx + 1; }
+
+    /** Find the bucket whose value has the given key, or m_buckets.size(). */
+    size_t FindBucket(const Key& key) const
+    {
+        if (m_values.empty()) return m_buckets.size();
+        const uint64_t hash{HashKey(key)};
+        uint32_t daf{DistAndFingerprint(hash)};
+        size_t idx{BucketIndex(hash)};
+        while (true) {
+            const Bucket& bucket{m_buckets[idx]};
+            if (bucket.dist_and_fingerprint == daf && m_equal(key, m_values[bucket.value_idx].first)) return idx;
+            // Robin hood invariant: the key would have displaced this bucket.
+            if (bucket.dist_and_fingerprint < daf) return m_buckets.size();
+            daf += DIST_INC;
+            idx = Next(idx);
+        }
+    }
+
+    /** Put `bucket` at `idx`, shifting the following occupied buckets up by one. */
+    void PlaceAndShiftUp(Bucket bucket, size_t idx)
+    {
+        while (m_buckets[idx].dist_and_fingerprint != 0) {
+            std::swap(bucket, m_buckets[idx]);
+            bucket.dist_and_fingerprint += DIST_INC;
+            idx = Next(idx);
+        }
+        m_buckets[idx] = bucket;
+    }
+
+    /** Insert a bucket for m_values[value_idx], which must not be present yet. */
+    void InsertBucket(size_t value_idx)
+    {
+        const uint64_t hash{HashKey(m_values[value_idx].first)};
+        uint32_t daf{DistAndFingerprint(hash)};
+        size_t idx{BucketIndex(hash)};
+        while (daf <= m_buckets[idx].dist_and_fingerprint) {
+            daf += DIST_INC;
+            idx = Next(idx);
+        }
+        PlaceAndShiftUp({daf, static_cast<uint32_t>(value_idx)}, idx);
+    }
+
+    /** Remove the bucket at idx using backward-shift deletion. */
+    void EraseBucket(size_t idx)
+    {
+        size_t next{Next(idx)};
+        while (m_buckets[next].dist_and_fingerprint >= 2 * DIST_INC) {
+            m_buckets[idx] = {m_buckets[next].dist_and_fingerprint - DIST_INC, m_buckets[next].value_idx};
+            idx = next;
+            next = Next(next);
+        }
+        m_buckets[idx] = {};
+    }
+
+    void Rebuild(uint8_t shifts)
+    {
+        m_shifts = shifts;
+        const size_t num_buckets{size_t{1} << (64 - m_shifts)};
+        m_buckets.assign(num_buckets, Bucket{});
+        m_max_size = num_buckets * MAX_LOAD_256 / 256;
+        for (size_t i = 0; i < m_values.size(); ++i) InsertBucket(i);
+    }
+
+    static uint8_t ShiftsFor(size_t count)
+    {
+        uint8_t shifts{INITIAL_SHIFTS};
+        while (shifts > 0 && (size_t{1} << (64 - shifts)) * MAX_LOAD_256 / 256 < count) --shifts;
+        return shifts;
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> DoTryEmplace(K&& key, Args&&... args)
+    {
+        if (const size_t idx{FindBucket(key)}; idx != m_buckets.size()) {
+            return {m_values.begin() + m_buckets[idx].value_idx, false};
+        }
+        if (m_values.size() + 1 > m_max_size) Rebuild(ShiftsFor(std::max<size_t>(m_values.size() + 1, m_buckets.size())));
+        m_values.emplace_back(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        InsertBucket(m_values.size() - 1);
+        return {m_values.end() - 1, true};
+    }
+
+public:
+    explicit DenseHashMap(size_t bucket_count = 0, const Hash& hash = Hash{}, const KeyEqual& equal = KeyEqual{})
+        : m_hash{hash}, m_equal{equal}
+    {
+        Rebuild(ShiftsFor(bucket_count));
+    }
+
+    iterator begin() { return m_values.begin(); }
+    iterator end() { return m_values.end(); }
+    const_iterator begin() const { return m_values.begin(); }
+    const_iterator end() const { return m_values.end(); }
+    const_iterator cbegin() const { return m_values.cbegin(); }
+    const_iterator cend() const { return m_values.cend(); }
+
+    bool empty() const { return m_values.empty(); }
+    size_t size() const { return m_values.size(); }
+    size_t bucket_count() const { return m_buckets.size(); }
+
+    iterator find(const Key& key)
+    {
+        const size_t idx{FindBucket(key)};
+        return idx == m_buckets.size() ? end() : begin() + m_buckets[idx].value_idx;
+    }
+    const_iterator find(const Key& key) const
+    {
+        const size_t idx{FindBucket(key)};
+        return idx == m_buckets.size() ? end() : begin() + m_buckets[idx].value_idx;
+    }
+    size_t count(const Key& key) const { return FindBucket(key) == m_buckets.size() ? 0 : 1; }
+
+    T& at(const Key& key)
+    {
+        auto it{find(key)};
+        if (it == end()) throw std::out_of_range("DenseHashMap::at");
+        return it->second;
+    }
+    const T& at(const Key& key) const
+    {
+        auto it{find(key)};
+        if (it == end()) throw std::out_of_range("DenseHashMap::at");
+        return it->second;
+    }
+    T& operator[](const Key& key) { return DoTryEmplace(key).first->second; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) { return DoTryEmplace(key, std::forward<Args>(args)...); }
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) { return DoTryEmplace(std::move(key), std::forward<Args>(args)...); }
+    std::pair<iterator, bool> insert(const value_type& value) { return DoTryEmplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type&& value) { return DoTryEmplace(std::move(value.first), std::move(value.second)); }
+
+    /** Erase the element at `pos`. The last element is moved into its place;
+     *  the returned iterator points at it (or is end()). */
+    iterator erase(const_iterator pos)
+    {
+        const size_t value_idx{static_cast<size_t>(pos - cbegin())};
+        EraseBucket(FindBucket(m_values[value_idx].first));
+        const size_t last_idx{m_values.size() - 1};
+        if (value_idx != last_idx) {
+            // Repoint the bucket of the last value to its new position.
+            const uint64_t hash{HashKey(m_values[last_idx].first)};
+            size_t idx{BucketIndex(hash)};
+            while (m_buckets[idx].value_idx != last_idx || m_buckets[idx].dist_and_fingerprint == 0) idx = Next(idx);
+            m_buckets[idx].value_idx = static_cast<uint32_t>(value_idx);
+            m_values[value_idx] = std::move(m_values[last_idx]);
+        }
+        m_values.pop_back();
+        return begin() + value_idx;
+    }
+    iterator erase(iterator pos) { return erase(const_iterator{pos}); }
+    size_t erase(const Key& key)
+    {
+        auto it{find(key)};
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        m_values.clear();
+        std::fill(m_buckets.begin(), m_buckets.end(), Bucket{});
+    }
+
+    void reserve(size_t count)
+    {
+        m_values.reserve(count);
+        if (count > m_max_size) Rebuild(ShiftsFor(count));
+    }
+
+    /** Exact heap usage of the map (the values and bucket arrays). */
+    size_t DynamicMemoryUsage() const
+    {
+        return memusage::MallocUsage(m_values.capacity() * sizeof(value_type)) + memusage::MallocUsage(m_buckets.capacity() * sizeof(Bucket));
+    }
+};
+
+#endif // BITCOIN_UTIL_DENSEMAP_H
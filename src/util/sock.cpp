@@ -11,6 +11,9 @@
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -19,6 +22,10 @@
 #include <poll.h>
 #endif
 
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -47,6 +54,31 @@ ssize_t Sock::Send(const void* data, size_t len, int flags) const
     return send(m_socket, static_cast<const char*>(data), len, flags);
 }
 
+ssize_t Sock::SendMany(Span<const Span<const uint8_t>> chunks, int flags) const
+{
+#ifdef WIN32
+    for (const auto& chunk : chunks) {
+        if (!chunk.empty()) return Send(chunk.data(), chunk.size(), flags);
+    }
+    return 0;
+#else
+    // Sending fewer chunks than given is just a partial send.
+    iovec iov[16];
+    size_t iov_count{0};
+    for (const auto& chunk : chunks) {
+        if (chunk.empty()) continue;
+        if (iov_count == std::size(iov)) break;
+        iov[iov_count].iov_base = const_cast<uint8_t*>(chunk.data());
+        iov[iov_count].iov_len = chunk.size();
+        ++iov_count;
+    }
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void* buf, size_t len, int flags) const
 {
     return recv(m_socket, static_cast<char*>(buf), len, flags);
@@ -412,6 +444,59 @@ bool Sock::operator==(SOCKET s) const
     return m_socket == s;
 };
 
+#ifdef USE_EPOLL
+SockEpoll::SockEpoll() : m_epoll_fd{epoll_create1(EPOLL_CLOEXEC)} {}
+
+SockEpoll::~SockEpoll()
+{
+    if (m_epoll_fd != -1) close(m_epoll_fd);
+}
+
+bool SockEpoll::Add(const Sock& sock, Sock::Event requested, uint64_t id, bool edge_triggered)
+{
+    epoll_event ev{};
+    ev.events = EPOLLRDHUP;
+    if (requested & Sock::RECV) ev.events |= EPOLLIN;
+    if (requested & Sock::SEND) ev.events |= EPOLLOUT;
+    if (edge_triggered) ev.events |= EPOLLET;
+    ev.data.u64 = id;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, sock.m_socket, &ev) == 0) return true;
+    // The same file descriptor number may still be registered if the socket that used
+    // it before has not been fully closed yet (another reference to it was alive).
+    return errno == EEXIST && epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, sock.m_socket, &ev) == 0;
+}
+
+bool SockEpoll::Remove(const Sock& sock)
+{
+    return epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, sock.m_socket, nullptr) == 0;
+}
+
+bool SockEpoll::Wait(std::chrono::milliseconds timeout, size_t max_events, std::vector<Event>& events)
+{
+    events.clear();
+    m_ready.resize(std::max<size_t>(max_events, 1));
+    const int n{epoll_wait(m_epoll_fd, m_ready.data(), m_ready.size(), count_milliseconds(timeout))};
+    if (n < 0) {
+        return errno == EINTR;
+    }
+    events.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        Sock::Event occurred{0};
+        if (m_ready[i].events & EPOLLIN) {
+            occurred |= Sock::RECV;
+        }
+        if (m_ready[i].events & EPOLLOUT) {
+            occurred |= Sock::SEND;
+        }
+        if (m_ready[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+            occurred |= Sock::ERR;
+        }
+        events.push_back({m_ready[i].data.u64, occurred});
+    }
+    return true;
+}
+#endif // USE_EPOLL
+
 std::string NetworkErrorString(int err)
 {
 #if defined(WIN32)
@@ -6,6 +6,7 @@
 #define BITCOIN_UTIL_SOCK_H
 
 #include <compat/compat.h>
+#include <span.h>
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
@@ -13,6 +14,11 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 /**
  * Maximum time to wait for I/O readiness.
@@ -64,6 +70,13 @@ public:
      */
     [[nodiscard]] virtual ssize_t Send(const void* data, size_t len, int flags) const;
 
+    /**
+     * sendmsg(2) wrapper that sends the concatenation of chunks with a single system call,
+     * without copying them together first. Like Send(), it may send only a prefix. Where
+     * scatter-gather sending is not available, only the first non-empty chunk is sent.
+     */
+    [[nodiscard]] virtual ssize_t SendMany(Span<const Span<const uint8_t>> chunks, int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(m_socket, buf, len, flags);`. Code that uses this
      * wrapper can be unit tested if this method is overridden by a mock Sock implementation.
@@ -268,12 +281,72 @@ protected:
     SOCKET m_socket;
 
 private:
+#ifdef USE_EPOLL
+    friend class SockEpoll;
+#endif
+
     /**
      * Close `m_socket` if it is not `INVALID_SOCKET`.
      */
     void Close();
 };
 
+#ifdef USE_EPOLL
+/**
+ * A persistent set of sockets to wait on, backed by epoll(7).
+ *
+ * `Sock::WaitMany()` hands every socket to the kernel on each call, which
+ * costs O(number of sockets) per wakeup. Here sockets are registered once and
+ * `Wait()` only returns the ones that became ready, tagged with the id given
+ * at registration.
+ *
+ * Sockets registered as edge-triggered are reported once per readiness
+ * change: the caller has to remember that a socket is readable (writable)
+ * until a recv (send) on it would block.
+ */
+class SockEpoll
+{
+public:
+    struct Event {
+        uint64_t id;
+        Sock::Event occurred;
+    };
+
+    SockEpoll();
+    ~SockEpoll();
+
+    SockEpoll(const SockEpoll&) = delete;
+    SockEpoll& operator=(const SockEpoll&) = delete;
+
+    /** Whether the epoll instance could be created. */
+    bool IsValid() const { return m_epoll_fd != -1; }
+
+    /**
+     * Start waiting for `requested` (bitwise-or of `Sock::RECV` and `Sock::SEND`) on `sock`.
+     * `ERR` is always reported. The registration is dropped automatically when the socket
+     * is closed.
+     */
+    [[nodiscard]] bool Add(const Sock& sock, Sock::Event requested, uint64_t id, bool edge_triggered);
+
+    /** Stop waiting on `sock`. */
+    [[nodiscard]] bool Remove(const Sock& sock);
+
+    /**
+     * Wait until at least one registered socket is ready, or the timeout expires.
+     * @param[in] timeout How long to wait.
+     * @param[in] max_events Return at most this many events, the rest are reported by the next call.
+     * @param[out] events Set to the ready sockets (empty on timeout).
+     * @return true on success (or timeout), false otherwise
+     */
+    [[nodiscard]] bool Wait(std::chrono::milliseconds timeout, size_t max_events, std::vector<Event>& events);
+
+private:
+    int m_epoll_fd;
+    //! Buffer for epoll_wait(2), kept to avoid an allocation per call.
+    std::vector<epoll_event> m_ready;
+};
+#endif // USE_EPOLL
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
@@ -57,6 +57,7 @@
 #include <util/rbf.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
@@ -66,11 +67,15 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 
 using kernel::CCoinsStats;
@@ -2408,6 +2413,25 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &scriptcheckqueue : nullptr);
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
 
+    // Warm the cache with the inputs of this block that were not created by the
+    // block itself, so that coins missing from the cache are read from the
+    // database in one batched lookup instead of one at a time below.
+    {
+        std::vector<uint256> block_txids;
+        block_txids.reserve(block.vtx.size());
+        for (const auto& tx : block.vtx) block_txids.push_back(tx->GetHash());
+        std::sort(block_txids.begin(), block_txids.end());
+        std::vector<COutPoint> prevouts;
+        for (const auto& tx : block.vtx) {
+            if (tx->IsCoinBase()) continue;
+            for (const CTxIn& txin : tx->vin) {
+                if (std::binary_search(block_txids.begin(), block_txids.end(), txin.prevout.hash)) continue;
+                prevouts.push_back(txin.prevout);
+            }
+        }
+        view.GetCoins(prevouts);
+    }
+
     std::vector<int> prevheights;
     CAmount nFees = 0;
     CAmount nActualStakeReward = 0;
@@ -2719,10 +2743,24 @@ bool Chainstate::FlushStateToDisk(
                 return FatalError(m_chainman.GetNotifications(), state, "Disk space is too low!", _("Disk space is too low!"));
             }
             // Flush the chainstate (which may refer to block index entries).
-            if (!CoinsTip().Flush())
-                return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+            // Periodic and cache-pressure flushes may be written in the
+            // background, so that cs_main is not held during the database write.
+            // Explicit flushes are synchronous, as are flushes that prune: the
+            // blocks needed to replay an interrupted write must still exist.
+            if (CoinsDB().BackgroundFlushEnabled() && mode != FlushStateMode::ALWAYS && !fFlushForPrune) {
+                if (!CoinsDB().BatchWriteInBackground(CoinsTip().TakeFlushBatch(),
+                        [role = GetRole(), locator = m_chain.GetLocator()] {
+                            // Update best block in wallet (so we can detect restored wallets).
+                            GetMainSignals().ChainStateFlushed(role, locator);
+                        })) {
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                }
+            } else {
+                if (!CoinsTip().Flush())
+                    return FatalError(m_chainman.GetNotifications(), state, "Failed to write to coin database");
+                full_flush_completed = true;
+            }
             m_last_flush = nNow;
-            full_flush_completed = true;
             TRACE5(utxocache, flush,
                    int64_t{Ticks<std::chrono::microseconds>(SteadyClock::now() - nNow)},
                    (uint32_t)mode,
@@ -4451,6 +4489,100 @@ MempoolAcceptResult ChainstateManager::ProcessTransaction(const CTransactionRef&
     return result;
 }
 
+std::vector<MempoolAcceptResult> ChainstateManager::ProcessTransactions(const std::vector<CTransactionRef>& txns, bool test_accept)
+{
+    AssertLockNotHeld(cs_main);
+    const auto time_start{SteadyClock::now()};
+
+    // Stage 1: fetch the coins spent by each transaction, falling back to the
+    // outputs of earlier transactions of the batch, and set up its script checks.
+    // Transactions that are already known or obviously invalid are skipped; they
+    // are dealt with in stage 3 as usual.
+    std::vector<std::unique_ptr<PrecomputedTransactionData>> txdata;
+    std::vector<CScriptCheck> checks;
+    std::vector<std::vector<COutPoint>> coins_to_uncache(txns.size());
+    if (txns.size() > 1 && scriptcheckqueue.HasThreads()) {
+        LOCK(cs_main);
+        Chainstate& active_chainstate{ActiveChainstate()};
+        CTxMemPool* mempool{active_chainstate.GetMempool()};
+        if (mempool) {
+            LOCK(mempool->cs);
+            CCoinsViewCache& coins_tip{active_chainstate.CoinsTip()};
+            CCoinsViewMemPool view_mempool{&coins_tip, *mempool};
+            std::unordered_map<uint256, const CTransaction*, SaltedTxidHasher> batch_txs;
+            for (size_t i = 0; i < txns.size(); ++i) {
+                const CTransaction& tx{*txns[i]};
+                TxValidationState state;
+                if (tx.IsCoinBase() || mempool->exists(GenTxid::Wtxid(tx.GetWitnessHash())) || !CheckTransaction(tx, state)) continue;
+                std::vector<CTxOut> spent_outputs;
+                spent_outputs.reserve(tx.vin.size());
+                for (const CTxIn& txin : tx.vin) {
+                    if (const auto it{batch_txs.find(txin.prevout.hash)}; it != batch_txs.end()) {
+                        if (txin.prevout.n >= it->second->vout.size()) break;
+                        spent_outputs.push_back(it->second->vout[txin.prevout.n]);
+                        continue;
+                    }
+                    // Like MemPoolAccept, don't leave coins in the cache for transactions that end up rejected.
+                    if (!coins_tip.HaveCoinInCache(txin.prevout)) coins_to_uncache[i].push_back(txin.prevout);
+                    Coin coin;
+                    if (!view_mempool.GetCoin(txin.prevout, coin)) break;
+                    spent_outputs.push_back(coin.out);
+                }
+                batch_txs.emplace(tx.GetHash(), &tx);
+                if (spent_outputs.size() != tx.vin.size()) continue;
+
+                auto& tx_data{*txdata.emplace_back(std::make_unique<PrecomputedTransactionData>())};
+                tx_data.Init(tx, std::move(spent_outputs));
+                for (unsigned int n = 0; n < tx.vin.size(); ++n) {
+                    checks.emplace_back(tx_data.m_spent_outputs[n], tx, n, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheIn=*/true, &tx_data);
+                }
+            }
+        }
+    }
+    const size_t num_checks{checks.size()};
+    const auto time_1{SteadyClock::now()};
+
+    // Stage 2: verify all scripts concurrently, without holding cs_main. This only
+    // fills the signature cache, so the result does not matter: stage 3 redoes
+    // the checks and reports the actual validation result of each transaction.
+    if (!checks.empty()) {
+        CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+        control.Add(std::move(checks));
+        (void)control.Wait();
+    }
+    const auto time_2{SteadyClock::now()};
+
+    // Stage 3: submit the transactions in order.
+    std::vector<MempoolAcceptResult> results;
+    results.reserve(txns.size());
+    LOCK(cs_main);
+    for (size_t i = 0; i < txns.size(); ++i) {
+        results.push_back(ProcessTransaction(txns[i], test_accept));
+        if (results.back().m_result_type != MempoolAcceptResult::ResultType::VALID) {
+            for (const COutPoint& outpoint : coins_to_uncache[i]) ActiveChainstate().CoinsTip().Uncache(outpoint);
+        }
+    }
+    const auto time_3{SteadyClock::now()};
+
+    TxAcceptStageStats& stats{m_tx_accept_stats};
+    ++stats.batches;
+    stats.transactions += txns.size();
+    stats.script_checks += num_checks;
+    stats.prefetch += std::chrono::duration_cast<std::chrono::microseconds>(time_1 - time_start);
+    stats.verify += std::chrono::duration_cast<std::chrono::microseconds>(time_2 - time_1);
+    stats.accept += std::chrono::duration_cast<std::chrono::microseconds>(time_3 - time_2);
+    LogPrint(BCLog::BENCH, "ProcessTransactions: %u txs, %u txins: prefetch %.2fms, verify %.2fms, accept %.2fms [%.2fs, %.2fs, %.2fs (%.2fms/tx)]\n",
+             txns.size(), num_checks,
+             Ticks<MillisecondsDouble>(time_1 - time_start),
+             Ticks<MillisecondsDouble>(time_2 - time_1),
+             Ticks<MillisecondsDouble>(time_3 - time_2),
+             Ticks<SecondsDouble>(stats.prefetch),
+             Ticks<SecondsDouble>(stats.verify),
+             Ticks<SecondsDouble>(stats.accept),
+             Ticks<MillisecondsDouble>(stats.prefetch + stats.verify + stats.accept) / stats.transactions);
+    return results;
+}
+
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
                        Chainstate& chainstate,
@@ -5581,6 +5713,142 @@ static void SnapshotUTXOHashBreakpoint(const util::SignalInterrupt& interrupt)
     if (interrupt) throw StopHashingException();
 }
 
+namespace {
+//! Number of coins handed from one snapshot loading stage to the next at a time.
+constexpr size_t SNAPSHOT_CHUNK_COINS{10000};
+//! Maximum number of chunks waiting between two snapshot loading stages.
+constexpr size_t SNAPSHOT_MAX_QUEUED_CHUNKS{8};
+
+using SnapshotChunk = std::vector<std::pair<COutPoint, Coin>>;
+
+/** Bounded queue of coin chunks between two snapshot loading threads. */
+class SnapshotChunkQueue
+{
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<SnapshotChunk> m_chunks GUARDED_BY(m_mutex);
+    //! The producer will not push any more chunks.
+    bool m_finished GUARDED_BY(m_mutex){false};
+    //! The consumer stopped; pushing fails and popping returns nothing.
+    bool m_aborted GUARDED_BY(m_mutex){false};
+
+public:
+    //! Wait for space in the queue and add a chunk. Returns false if the queue was aborted.
+    bool Push(SnapshotChunk&& chunk) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_aborted || m_chunks.size() < SNAPSHOT_MAX_QUEUED_CHUNKS; });
+        if (m_aborted) return false;
+        m_chunks.push_back(std::move(chunk));
+        m_cv.notify_all();
+        return true;
+    }
+
+    //! Wait for the next chunk. Returns std::nullopt once the queue is finished and empty, or aborted.
+    std::optional<SnapshotChunk> Pop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_aborted || m_finished || !m_chunks.empty(); });
+        if (m_aborted || m_chunks.empty()) return std::nullopt;
+        SnapshotChunk chunk{std::move(m_chunks.front())};
+        m_chunks.pop_front();
+        m_cv.notify_all();
+        return chunk;
+    }
+
+    void Finish() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WITH_LOCK(m_mutex, m_finished = true);
+        m_cv.notify_all();
+    }
+
+    void Abort() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WITH_LOCK(m_mutex, m_aborted = true);
+        m_cv.notify_all();
+    }
+};
+
+/**
+ * Deserialize and sanity-check the coins of a snapshot, passing them on in
+ * chunks. Returns an error message, or an empty string on success.
+ */
+std::string ReadSnapshotCoins(AutoFile& coins_file, uint64_t coins_count, int base_height, SnapshotChunkQueue& out)
+{
+    uint64_t coins_read{0};
+    SnapshotChunk chunk;
+    chunk.reserve(SNAPSHOT_CHUNK_COINS);
+    while (coins_read < coins_count) {
+        COutPoint outpoint;
+        Coin coin;
+        try {
+            coins_file >> outpoint;
+            coins_file >> coin;
+        } catch (const std::ios_base::failure&) {
+            return strprintf("bad snapshot format or truncated snapshot after deserializing %d coins", coins_read);
+        }
+        if (coin.nHeight > base_height ||
+            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+        ) {
+            return strprintf("bad snapshot data after deserializing %d coins", coins_read);
+        }
+        if (!MoneyRange(coin.out.nValue)) {
+            return strprintf("bad snapshot data after deserializing %d coins - bad tx out value", coins_read);
+        }
+        chunk.emplace_back(std::move(outpoint), std::move(coin));
+        ++coins_read;
+
+        if (chunk.size() == SNAPSHOT_CHUNK_COINS || coins_read == coins_count) {
+            if (!out.Push(std::move(chunk))) return {};
+            chunk = {};
+            chunk.reserve(SNAPSHOT_CHUNK_COINS);
+        }
+    }
+
+    try {
+        COutPoint outpoint;
+        coins_file >> outpoint;
+    } catch (const std::ios_base::failure&) {
+        // We expect an exception since we should be out of coins.
+        return {};
+    }
+    return strprintf("bad snapshot - coins left over after deserializing %d coins", coins_count);
+}
+
+/**
+ * Compute the HASH_SERIALIZED commitment over snapshot coins, in the same way
+ * as ComputeUTXOStats() does over a coins database: the outputs of each
+ * transaction are hashed in output index order. Returns an error message, or
+ * an empty string on success.
+ */
+std::string HashSnapshotCoins(SnapshotChunkQueue& in, SnapshotChunkQueue& out, uint256& hash_out)
+{
+    HashWriter ss{};
+    uint256 prev_txid;
+    std::map<uint32_t, Coin> outputs;
+    auto apply_outputs{[&] {
+        for (const auto& [n, coin] : outputs) {
+            kernel::ApplyCoinHash(ss, COutPoint{prev_txid, n}, coin);
+        }
+        outputs.clear();
+    }};
+
+    while (auto chunk{in.Pop()}) {
+        for (const auto& [outpoint, coin] : *chunk) {
+            if (!outputs.empty() && outpoint.hash != prev_txid) apply_outputs();
+            prev_txid = outpoint.hash;
+            if (!outputs.try_emplace(outpoint.n, coin).second) {
+                return strprintf("bad snapshot - duplicate coin %s", outpoint.ToString());
+            }
+        }
+        if (!out.Push(std::move(*chunk))) return {};
+    }
+    apply_outputs();
+    hash_out = ss.GetHash();
+    return {};
+}
+} // namespace
+
 bool ChainstateManager::PopulateAndValidateSnapshot(
     Chainstate& snapshot_chainstate,
     AutoFile& coins_file,
@@ -5621,53 +5889,58 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
         return false;
     }
 
-    COutPoint outpoint;
-    Coin coin;
     const uint64_t coins_count = metadata.m_coins_count;
-    uint64_t coins_left = metadata.m_coins_count;
 
     LogPrintf("[snapshot] loading coins from snapshot %s\n", base_blockhash.ToString());
-    int64_t coins_processed{0};
-
-    while (coins_left > 0) {
-        try {
-            coins_file >> outpoint;
-            coins_file >> coin;
-        } catch (const std::ios_base::failure&) {
-            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (coin.nHeight > base_height ||
-            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-        ) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
-        }
-        if (!MoneyRange(coin.out.nValue)) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins - bad tx out value\n",
-                      coins_count - coins_left);
-            return false;
-        }
 
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
-
-        --coins_left;
-        ++coins_processed;
+    // Loading is pipelined over three threads: a reader deserializes and
+    // sanity-checks coins from the snapshot file, a hasher computes the
+    // HASH_SERIALIZED commitment over them, and this thread inserts them into
+    // the coins cache and flushes it to disk when it fills up.
+    //
+    // The commitment is computed over the coins in the order in which they
+    // appear in the snapshot, the same order in which ComputeUTXOStats()
+    // would visit them in the coins database, as dumptxoutset writes them
+    // from a database cursor. A snapshot whose coins are reordered, missing,
+    // or duplicated therefore fails the hash check below, and there is no
+    // need to read back the whole coins database after loading.
+    SnapshotChunkQueue read_queue;
+    SnapshotChunkQueue hashed_queue;
+    std::string read_error;
+    std::string hash_error;
+    uint256 coins_hash;
+
+    std::thread reader{&util::TraceThread, "snapshotread", [&] {
+        read_error = ReadSnapshotCoins(coins_file, coins_count, base_height, read_queue);
+        read_queue.Finish();
+    }};
+    std::thread hasher{&util::TraceThread, "snapshothash", [&] {
+        hash_error = HashSnapshotCoins(read_queue, hashed_queue, coins_hash);
+        hashed_queue.Finish();
+    }};
+
+    const bool loaded{[&] {
+        uint64_t coins_processed{0};
+        int last_progress{-1};
+        while (auto chunk{hashed_queue.Pop()}) {
+            for (auto& [outpoint, coin] : *chunk) {
+                coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+            }
+            const uint64_t prev_processed{coins_processed};
+            coins_processed += chunk->size();
 
-        if (coins_processed % 1000000 == 0) {
-            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                coins_processed,
-                static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-        }
+            const int progress{static_cast<int>(coins_processed * 100 / std::max<uint64_t>(coins_count, 1))};
+            if (progress != last_progress) {
+                GetNotifications().progress(_("Loading UTXO snapshot…"), progress, false);
+                last_progress = progress;
+            }
+            if (coins_processed / 1000000 != prev_processed / 1000000) {
+                LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
+                    coins_processed,
+                    static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
+                    coins_cache.DynamicMemoryUsage() / (1000 * 1000));
+            }
 
-        // Batch write and flush (if we need to) every so often.
-        //
-        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-        // means <5MB of memory imprecision.
-        if (coins_processed % 120000 == 0) {
             if (m_interrupt) {
                 return false;
             }
@@ -5685,6 +5958,33 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
             }
         }
+        return true;
+    }()};
+
+    // Unblock the reader and hasher if we stopped early.
+    read_queue.Abort();
+    hashed_queue.Abort();
+    reader.join();
+    hasher.join();
+    GetNotifications().progress(bilingual_str{}, 100, false);
+
+    if (!loaded) {
+        return false;
+    }
+    if (!read_error.empty()) {
+        LogPrintf("[snapshot] %s\n", read_error);
+        return false;
+    }
+    if (!hash_error.empty()) {
+        LogPrintf("[snapshot] %s\n", hash_error);
+        return false;
+    }
+
+    // Assert that the deserialized chainstate contents match the expected assumeutxo value.
+    if (AssumeutxoHash{coins_hash} != au_data.hash_serialized) {
+        LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
+            au_data.hash_serialized.ToString(), coins_hash.ToString());
+        return false;
     }
 
     // Important that we set this. This and the coins_cache accesses above are
@@ -5694,19 +5994,6 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // method.
     coins_cache.SetBestBlock(base_blockhash);
 
-    bool out_of_coins{false};
-    try {
-        coins_file >> outpoint;
-    } catch (const std::ios_base::failure&) {
-        // We expect an exception since we should be out of coins.
-        out_of_coins = true;
-    }
-    if (!out_of_coins) {
-        LogPrintf("[snapshot] bad snapshot - coins left over after deserializing %d coins\n",
-            coins_count);
-        return false;
-    }
-
     LogPrintf("[snapshot] loaded %d (%.2f MB) coins from snapshot %s\n",
         coins_count,
         coins_cache.DynamicMemoryUsage() / (1000 * 1000),
@@ -5717,30 +6004,6 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    // As above, okay to immediately release cs_main here since no other context knows
-    // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
-
-    std::optional<CCoinsStats> maybe_stats;
-
-    try {
-        maybe_stats = ComputeUTXOStats(
-            CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, [&interrupt = m_interrupt] { SnapshotUTXOHashBreakpoint(interrupt); });
-    } catch (StopHashingException const&) {
-        return false;
-    }
-    if (!maybe_stats.has_value()) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
-        return false;
-    }
-
-    // Assert that the deserialized chainstate contents match the expected assumeutxo value.
-    if (AssumeutxoHash{maybe_stats->hashSerialized} != au_data.hash_serialized) {
-        LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
-            au_data.hash_serialized.ToString(), maybe_stats->hashSerialized.ToString());
-        return false;
-    }
-
     snapshot_chainstate.m_chain.SetTip(*snapshot_start_block);
 
     // The remainder of this function requires modifying data protected by cs_main.
@@ -6430,6 +6693,27 @@ bool CheckHeaderProof(const CBlockHeader& block, const Consensus::Params& consen
     return true;
 }
 
+bool CheckHeaderSignature(const CBlockHeader& block)
+{
+    if (block.IsProofOfWork()) {
+        return block.vchBlockSig.empty();
+    }
+    if (block.vchBlockSig.empty()) {
+        return false;
+    }
+
+    // Recovery fails for signatures that can't be parsed, or that no key could
+    // have made for this hash.
+    const uint256 hash = block.GetHashWithoutSign();
+    CPubKey pubkey;
+    for (uint8_t recid = 0; recid <= 3; ++recid) {
+        if (pubkey.RecoverLaxDER(hash, block.vchBlockSig, recid, /*fComp=*/true)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool CheckIndexProof(const CBlockIndex& block, const Consensus::Params& consensusParams)
 {
     // Get the hash of the proof
@@ -355,6 +355,20 @@ static_assert(std::is_nothrow_move_assignable_v<CScriptCheck>);
 static_assert(std::is_nothrow_move_constructible_v<CScriptCheck>);
 static_assert(std::is_nothrow_destructible_v<CScriptCheck>);
 
+/** Cumulative statistics of ChainstateManager::ProcessTransactions(). */
+struct TxAcceptStageStats {
+    uint64_t batches{0};
+    uint64_t transactions{0};
+    //! Inputs whose scripts were verified ahead of mempool acceptance
+    uint64_t script_checks{0};
+    //! Time spent fetching spent coins and setting up script checks, under cs_main
+    std::chrono::microseconds prefetch{0};
+    //! Time spent verifying scripts on the worker threads, without cs_main
+    std::chrono::microseconds verify{0};
+    //! Time spent submitting the transactions to the mempool, under cs_main
+    std::chrono::microseconds accept{0};
+};
+
 /** Initializes the script-execution cache */
 [[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
 
@@ -1209,6 +1223,25 @@ public:
     [[nodiscard]] MempoolAcceptResult ProcessTransaction(const CTransactionRef& tx, bool test_accept=false)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Try to add a batch of independently relayed transactions to the memory pool, in order.
+     *
+     * The result is the same as calling ProcessTransaction() for each transaction in turn, but
+     * the work is pipelined: the spent coins of all transactions are fetched under cs_main, then
+     * their scripts are verified concurrently on the script check worker threads without holding
+     * cs_main, which fills the signature cache, and finally the transactions are submitted one by
+     * one. Later transactions may spend outputs of earlier ones.
+     *
+     * @param[in]  txns            The transactions to submit for mempool acceptance.
+     * @param[in]  test_accept     When true, run validation checks but don't submit to mempool.
+     * @returns one result per transaction, in the same order.
+     */
+    [[nodiscard]] std::vector<MempoolAcceptResult> ProcessTransactions(const std::vector<CTransactionRef>& txns, bool test_accept=false)
+        LOCKS_EXCLUDED(cs_main);
+
+    //! Cumulative timings of the stages of ProcessTransactions().
+    TxAcceptStageStats m_tx_accept_stats GUARDED_BY(::cs_main);
+
     //! Load the block tree and coins database from disk, initializing state if we're running with -reindex
     bool LoadBlockIndex() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -1335,6 +1368,10 @@ bool GetSpentCoinFromMainChain(const CBlockIndex* pforkPrev, COutPoint prevoutSt
 bool CheckHeaderPoW(const CBlockHeader& block, const Consensus::Params& consensusParams);
 bool CheckHeaderPoS(const CBlockHeader& block, const Consensus::Params& consensusParams, CBlockIndex* pindex, CCoinsViewCache& view);
 bool CheckHeaderProof(const CBlockHeader& block, const Consensus::Params& consensusParams);
+/** Context-free check of a header's block signature: proof-of-stake headers must
+ *  carry one from which a public key can be recovered for the header. Whether
+ *  that key owns prevoutStake needs the UTXO set, see CheckHeaderPoS(). */
+bool CheckHeaderSignature(const CBlockHeader& block);
 bool CheckIndexProof(const CBlockIndex& block, const Consensus::Params& consensusParams);
 
 #ifdef ENABLE_WALLET
@@ -10,6 +10,7 @@
 #include <memory>
 #include <string>
 
+class CBlock;
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
@@ -44,8 +45,9 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    // Notifies of ConnectTip result, i.e., new active tip only
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    // Notifies of ConnectTip result, i.e., new active tip only. block is the
+    // tip's block if it is still in memory, or nullptr.
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const CBlock *block);
     // Notifies of every block connection
     virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
     // Notifies of every block disconnection
@@ -56,6 +58,8 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Publishes notifications that were held back to be sent in a batch
+    virtual bool Flush();
 
 protected:
     void* psocket{nullptr};
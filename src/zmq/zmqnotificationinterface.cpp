@@ -40,16 +40,20 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
-std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index)
+std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index,
+                                                                            std::function<ZmqPayload(const CBlockIndex&, const CBlock*)> get_serialized_block)
 {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
-    factories["pubrawblock"] = [&get_block_by_index]() -> std::unique_ptr<CZMQAbstractNotifier> {
-        return std::make_unique<CZMQPublishRawBlockNotifier>(get_block_by_index);
+    factories["pubrawblock"] = [&get_block_by_index, &get_serialized_block]() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishRawBlockNotifier>(get_block_by_index, get_serialized_block);
     };
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubrawtxbatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionBatchNotifier>;
+    factories["pubsequencebatch"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceBatchNotifier>;
+    factories["pubstakeblock"] = CZMQAbstractNotifier::Create<CZMQPublishStakeBlockNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -116,6 +120,7 @@ void CZMQNotificationInterface::Shutdown()
     {
         for (auto& notifier : notifiers) {
             LogPrint(BCLog::ZMQ, "Shutdown notifier %s at %s\n", notifier->GetType(), notifier->GetAddress());
+            notifier->Flush();
             notifier->Shutdown();
         }
         zmq_ctx_term(pcontext);
@@ -142,14 +147,30 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
 
 } // anonymous namespace
 
+void CZMQNotificationInterface::FlushIfIdle()
+{
+    // A burst of mempool or block updates is queued as many callbacks. Batches
+    // are sent after the last of them, or when they are full.
+    if (GetMainSignals().CallbacksPending() > 0) return;
+    TryForEachAndRemoveFailed(notifiers, [](CZMQAbstractNotifier* notifier) {
+        return notifier->Flush();
+    });
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
+    std::shared_ptr<const CBlock> block;
+    if (m_last_connected_index == pindexNew) block = std::move(m_last_connected_block);
+    m_last_connected_block.reset();
+    m_last_connected_index = nullptr;
+
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
         return;
 
-    TryForEachAndRemoveFailed(notifiers, [pindexNew](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyBlock(pindexNew);
+    TryForEachAndRemoveFailed(notifiers, [pindexNew, &block](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew, block.get());
     });
+    FlushIfIdle();
 }
 
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx, uint64_t mempool_sequence)
@@ -159,6 +180,7 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
     TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyTransaction(tx) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
     });
+    FlushIfIdle();
 }
 
 void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
@@ -169,6 +191,7 @@ void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransaction
     TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyTransactionRemoval(tx, mempool_sequence);
     });
+    FlushIfIdle();
 }
 
 void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected)
@@ -176,6 +199,8 @@ void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::s
     if (role == ChainstateRole::BACKGROUND) {
         return;
     }
+    m_last_connected_block = pblock;
+    m_last_connected_index = pindexConnected;
     for (const CTransactionRef& ptx : pblock->vtx) {
         const CTransaction& tx = *ptx;
         TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
@@ -187,6 +212,7 @@ void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::s
     TryForEachAndRemoveFailed(notifiers, [pindexConnected](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyBlockConnect(pindexConnected);
     });
+    FlushIfIdle();
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
@@ -202,6 +228,7 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     TryForEachAndRemoveFailed(notifiers, [pindexDisconnected](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyBlockDisconnect(pindexDisconnected);
     });
+    FlushIfIdle();
 }
 
 std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
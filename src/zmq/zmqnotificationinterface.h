@@ -7,6 +7,7 @@
 
 #include <primitives/transaction.h>
 #include <validationinterface.h>
+#include <zmq/zmqpublishnotifier.h>
 
 #include <cstdint>
 #include <functional>
@@ -24,7 +25,8 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
-    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index);
+    static std::unique_ptr<CZMQNotificationInterface> Create(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index,
+                                                             std::function<ZmqPayload(const CBlockIndex&, const CBlock*)> get_serialized_block);
 
 protected:
     bool Initialize();
@@ -40,8 +42,15 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    //! Send batched notifications once there are no more validation callbacks to handle
+    void FlushIfIdle();
+
     void* pcontext{nullptr};
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+    //! Block last connected to the active chainstate, kept until the next
+    //! UpdatedBlockTip so rawblock doesn't have to read the new tip from disk
+    std::shared_ptr<const CBlock> m_last_connected_block;
+    const CBlockIndex* m_last_connected_index{nullptr};
 };
 
 extern std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
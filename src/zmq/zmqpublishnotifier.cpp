@@ -24,12 +24,14 @@
 
 #include <zmq.h>
 
+#include <algorithm>
 #include <cassert>
-#include <cstdarg>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -46,50 +48,63 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_RAWTXBATCH    = "rawtxbatch";
+static const char *MSG_SEQUENCEBATCH = "sequencebatch";
+static const char *MSG_STAKEBLOCK    = "stakeblock";
 
-// Internal function to send multipart message
-static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
+static void zmq_free_payload(void* /*data*/, void* hint)
 {
-    va_list args;
-    va_start(args, size);
+    delete static_cast<ZmqPayload*>(hint);
+}
 
-    while (1)
-    {
+// Internal function to send multipart message
+static int zmq_send_multipart(void *sock, Span<const ZmqMessagePart> parts)
+{
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const ZmqMessagePart& part = parts[i];
         zmq_msg_t msg;
-
-        int rc = zmq_msg_init_size(&msg, size);
+        int rc;
+        if (part.owner) {
+            // ZMQ keeps a reference to the payload until the message was sent
+            auto* hint = new ZmqPayload{part.owner};
+            rc = zmq_msg_init_data(&msg, const_cast<unsigned char*>(part.data.data()), part.data.size(), zmq_free_payload, hint);
+            if (rc != 0) delete hint;
+        } else {
+            rc = zmq_msg_init_size(&msg, part.data.size());
+            if (rc == 0 && !part.data.empty()) {
+                memcpy(zmq_msg_data(&msg), part.data.data(), part.data.size());
+            }
+        }
         if (rc != 0)
         {
             zmqError("Unable to initialize ZMQ msg");
-            va_end(args);
             return -1;
         }
 
-        void *buf = zmq_msg_data(&msg);
-        memcpy(buf, data, size);
-
-        data = va_arg(args, const void*);
-
-        rc = zmq_msg_send(&msg, sock, data ? ZMQ_SNDMORE : 0);
+        rc = zmq_msg_send(&msg, sock, i + 1 < parts.size() ? ZMQ_SNDMORE : 0);
         if (rc == -1)
         {
             zmqError("Unable to send ZMQ msg");
             zmq_msg_close(&msg);
-            va_end(args);
             return -1;
         }
 
         zmq_msg_close(&msg);
-
-        if (!data)
-            break;
-
-        size = va_arg(args, size_t);
     }
-    va_end(args);
     return 0;
 }
 
+//! Serialize an object for publishing, in the serialization RPC uses
+template <typename T>
+static ZmqPayload SerializePayload(const T& obj)
+{
+    const int version{PROTOCOL_VERSION | RPCSerializationFlags()};
+    auto data = std::make_shared<std::vector<unsigned char>>();
+    data->reserve(::GetSerializeSize(obj, version));
+    CVectorWriter{version, *data, 0} << obj;
+    return data;
+}
+
 static bool IsZMQAddressIPV6(const std::string &zmq_address)
 {
     const std::string tcp_prefix = "tcp://";
@@ -202,13 +217,30 @@ void CZMQAbstractPublishNotifier::Shutdown()
 }
 
 bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+{
+    const ZmqMessagePart part{{static_cast<const unsigned char*>(data), size}, nullptr};
+    return SendZmqMessage(command, Span{&part, 1});
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, ZmqPayload payload)
+{
+    const ZmqMessagePart part{*payload, payload};
+    return SendZmqMessage(command, Span{&part, 1});
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, Span<const ZmqMessagePart> parts)
 {
     assert(psocket);
 
-    /* send three parts, command & data & a LE 4byte sequence number */
+    /* send the command, the data parts and a LE 4byte sequence number */
     unsigned char msgseq[sizeof(uint32_t)];
     WriteLE32(msgseq, nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), nullptr);
+    std::vector<ZmqMessagePart> message;
+    message.reserve(parts.size() + 2);
+    message.push_back({{reinterpret_cast<const unsigned char*>(command), strlen(command)}, nullptr});
+    message.insert(message.end(), parts.begin(), parts.end());
+    message.push_back({msgseq, nullptr});
+    int rc = zmq_send_multipart(psocket, message);
     if (rc == -1)
         return false;
 
@@ -218,7 +250,7 @@ bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CBlock * /*block*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "Publish hashblock %s to %s\n", hash.GetHex(), this->address);
@@ -240,42 +272,60 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendZmqMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CBlock *block)
 {
     LogPrint(BCLog::ZMQ, "Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    CBlock block;
-    if (!m_get_block_by_index(block, *pindex)) {
-        zmqError("Can't read block from disk");
-        return false;
+    if (RPCSerializationFlags() == 0) {
+        // Published as stored, so the payload is shared with the serialized
+        // block cache peers are served from.
+        ZmqPayload data{m_get_serialized_block(*pindex, block)};
+        if (!data) {
+            zmqError("Can't read block from disk");
+            return false;
+        }
+        return SendZmqMessage(MSG_RAWBLOCK, std::move(data));
     }
 
-    ss << block;
+    CBlock block_from_disk;
+    if (!block) {
+        if (!m_get_block_by_index(block_from_disk, *pindex)) {
+            zmqError("Can't read block from disk");
+            return false;
+        }
+        block = &block_from_disk;
+    }
 
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWBLOCK, SerializePayload(*block));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "Publish rawtx %s to %s\n", hash.GetHex(), this->address);
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWTX, SerializePayload(transaction));
 }
 
-// Helper function to send a 'sequence' topic message with the following structure:
+static constexpr size_t SEQUENCE_MSG_MAX_SIZE{sizeof(uint256) + sizeof(char) + sizeof(uint64_t)};
+
+// Helper function to build a 'sequence' topic message with the following structure:
 //    <32-byte hash> | <1-byte label> | <8-byte LE sequence> (optional)
-static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash, char label, std::optional<uint64_t> sequence = {})
+// Returns the size of the message.
+static size_t WriteSequenceMsg(unsigned char (&data)[SEQUENCE_MSG_MAX_SIZE], const uint256& hash, char label, std::optional<uint64_t> sequence)
 {
-    unsigned char data[sizeof(hash) + sizeof(label) + sizeof(uint64_t)];
     for (unsigned int i = 0; i < sizeof(hash); ++i) {
         data[sizeof(hash) - 1 - i] = hash.begin()[i];
     }
     data[sizeof(hash)] = label;
     if (sequence) WriteLE64(data + sizeof(hash) + sizeof(label), *sequence);
-    return notifier.SendZmqMessage(MSG_SEQUENCE, data, sequence ? sizeof(data) : sizeof(hash) + sizeof(label));
+    return sequence ? sizeof(data) : sizeof(hash) + sizeof(label);
+}
+
+static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash, char label, std::optional<uint64_t> sequence = {})
+{
+    unsigned char data[SEQUENCE_MSG_MAX_SIZE];
+    const size_t size{WriteSequenceMsg(data, hash, label, sequence)};
+    return notifier.SendZmqMessage(MSG_SEQUENCE, data, size);
 }
 
 bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
@@ -305,3 +355,109 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+bool CZMQPublishRawTransactionBatchNotifier::NotifyTransaction(const CTransaction &transaction)
+{
+    ZmqPayload data = SerializePayload(transaction);
+    m_batch.push_back({*data, data});
+    return m_batch.size() < ZMQ_MAX_BATCH_SIZE || Flush();
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::Flush()
+{
+    if (m_batch.empty()) return true;
+    LogPrint(BCLog::ZMQ, "Publish rawtxbatch of %u transactions to %s\n", m_batch.size(), this->address);
+    const bool sent = SendZmqMessage(MSG_RAWTXBATCH, m_batch);
+    m_batch.clear();
+    return sent;
+}
+
+bool CZMQPublishSequenceBatchNotifier::Add(Span<const unsigned char> record)
+{
+    m_batch.insert(m_batch.end(), record.begin(), record.end());
+    m_ends.push_back(m_batch.size());
+    return m_ends.size() < ZMQ_MAX_BATCH_SIZE || Flush();
+}
+
+bool CZMQPublishSequenceBatchNotifier::Flush()
+{
+    if (m_ends.empty()) return true;
+    LogPrint(BCLog::ZMQ, "Publish sequencebatch of %u messages to %s\n", m_ends.size(), this->address);
+    std::vector<ZmqMessagePart> parts;
+    parts.reserve(m_ends.size());
+    size_t begin = 0;
+    for (const size_t end : m_ends) {
+        parts.push_back({Span<const unsigned char>{m_batch}.subspan(begin, end - begin), nullptr});
+        begin = end;
+    }
+    const bool sent = SendZmqMessage(MSG_SEQUENCEBATCH, parts);
+    m_batch.clear();
+    m_ends.clear();
+    return sent;
+}
+
+bool CZMQPublishSequenceBatchNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+{
+    unsigned char data[SEQUENCE_MSG_MAX_SIZE];
+    return Add({data, WriteSequenceMsg(data, pindex->GetBlockHash(), /* Block (C)onnect */ 'C', {})});
+}
+
+bool CZMQPublishSequenceBatchNotifier::NotifyBlockDisconnect(const CBlockIndex *pindex)
+{
+    unsigned char data[SEQUENCE_MSG_MAX_SIZE];
+    return Add({data, WriteSequenceMsg(data, pindex->GetBlockHash(), /* Block (D)isconnect */ 'D', {})});
+}
+
+bool CZMQPublishSequenceBatchNotifier::NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence)
+{
+    unsigned char data[SEQUENCE_MSG_MAX_SIZE];
+    return Add({data, WriteSequenceMsg(data, transaction.GetHash(), /* Mempool (A)cceptance */ 'A', mempool_sequence)});
+}
+
+bool CZMQPublishSequenceBatchNotifier::NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence)
+{
+    unsigned char data[SEQUENCE_MSG_MAX_SIZE];
+    return Add({data, WriteSequenceMsg(data, transaction.GetHash(), /* Mempool (R)emoval */ 'R', mempool_sequence)});
+}
+
+// Helper function to send a 'stakeblock' topic message with the following structure:
+//    <32-byte block hash> | <1-byte label> | <4-byte LE height> | <4-byte LE block time> |
+//    <32-byte stake prevout hash> | <4-byte LE stake prevout index> |
+//    <32-byte stake modifier> | <32-byte proof hash> | <block signature>
+static bool SendStakeBlockMsg(CZMQAbstractPublishNotifier& notifier, const CBlockIndex& index, char label)
+{
+    std::vector<unsigned char> data;
+    data.reserve(4 * sizeof(uint256) + sizeof(label) + 3 * sizeof(uint32_t) + index.vchBlockSig.size());
+    const auto append_hash = [&data](const uint256& hash) {
+        std::reverse_copy(hash.begin(), hash.end(), std::back_inserter(data));
+    };
+    const auto append_le32 = [&data](uint32_t value) {
+        unsigned char buf[sizeof(uint32_t)];
+        WriteLE32(buf, value);
+        data.insert(data.end(), std::begin(buf), std::end(buf));
+    };
+    append_hash(index.GetBlockHash());
+    data.push_back(label);
+    append_le32(index.nHeight);
+    append_le32(index.nTime);
+    append_hash(index.prevoutStake.hash);
+    append_le32(index.prevoutStake.n);
+    append_hash(index.nStakeModifier);
+    append_hash(index.hashProof);
+    data.insert(data.end(), index.vchBlockSig.begin(), index.vchBlockSig.end());
+    return notifier.SendZmqMessage(MSG_STAKEBLOCK, data.data(), data.size());
+}
+
+bool CZMQPublishStakeBlockNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+{
+    if (!pindex->IsProofOfStake()) return true;
+    LogPrint(BCLog::ZMQ, "Publish stakeblock connect %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
+    return SendStakeBlockMsg(*this, *pindex, /* Block (C)onnect */ 'C');
+}
+
+bool CZMQPublishStakeBlockNotifier::NotifyBlockDisconnect(const CBlockIndex *pindex)
+{
+    if (!pindex->IsProofOfStake()) return true;
+    LogPrint(BCLog::ZMQ, "Publish stakeblock disconnect %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
+    return SendStakeBlockMsg(*this, *pindex, /* Block (D)isconnect */ 'D');
+}
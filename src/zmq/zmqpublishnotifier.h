@@ -5,16 +5,32 @@
 #ifndef BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
+#include <span.h>
 #include <zmq/zmqabstractnotifier.h>
 
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
 class CTransaction;
 
+//! Serialized data that is handed to ZMQ without copying it
+using ZmqPayload = std::shared_ptr<const std::vector<unsigned char>>;
+
+//! Maximum number of entries published in one message by the batch notifiers
+static constexpr size_t ZMQ_MAX_BATCH_SIZE{1000};
+
+/** Part of a multipart message. If owner is set, data points into it and is
+ *  sent without being copied. */
+struct ZmqMessagePart {
+    Span<const unsigned char> data;
+    ZmqPayload owner;
+};
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
@@ -29,6 +45,9 @@ public:
           * message sequence number
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
+    bool SendZmqMessage(const char *command, ZmqPayload payload);
+    /* like above, with any number of data parts between command and sequence number */
+    bool SendZmqMessage(const char *command, Span<const ZmqMessagePart> parts);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -37,7 +56,7 @@ public:
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const CBlock *block) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -50,11 +69,15 @@ class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 private:
     const std::function<bool(CBlock&, const CBlockIndex&)> m_get_block_by_index;
+    //! Get a block as stored, serializing the block passed if it is not cached
+    const std::function<ZmqPayload(const CBlockIndex&, const CBlock*)> m_get_serialized_block;
 
 public:
-    CZMQPublishRawBlockNotifier(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index)
-        : m_get_block_by_index{std::move(get_block_by_index)} {}
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    CZMQPublishRawBlockNotifier(std::function<bool(CBlock&, const CBlockIndex&)> get_block_by_index,
+                                std::function<ZmqPayload(const CBlockIndex&, const CBlock*)> get_serialized_block)
+        : m_get_block_by_index{std::move(get_block_by_index)},
+          m_get_serialized_block{std::move(get_serialized_block)} {}
+    bool NotifyBlock(const CBlockIndex *pindex, const CBlock *block) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -72,4 +95,44 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+/** Publishes the transactions of the rawtx topic in batches: all transactions
+ *  seen until the validation callbacks of a burst have been handled, up to
+ *  ZMQ_MAX_BATCH_SIZE, are sent in one message with a part per transaction. */
+class CZMQPublishRawTransactionBatchNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    std::vector<ZmqMessagePart> m_batch;
+
+public:
+    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool Flush() override;
+};
+
+/** Publishes the messages of the sequence topic in batches, like
+ *  CZMQPublishRawTransactionBatchNotifier. */
+class CZMQPublishSequenceBatchNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    std::vector<unsigned char> m_batch;
+    std::vector<size_t> m_ends;
+
+    bool Add(Span<const unsigned char> record);
+
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
+    bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence) override;
+    bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
+    bool Flush() override;
+};
+
+/** Publishes the proof-of-stake metadata of every connected and disconnected
+ *  proof-of-stake block. */
+class CZMQPublishStakeBlockNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -319,6 +319,22 @@ class RESTTest (BitcoinTestFramework):
                 self.test_rest_request(f"/headers/{bb_hash}", ret_type=RetType.BYTES, status=400, query_params={"count": num}),
             )
 
+        self.log.info("Test the /blockrange and /headerrange URIs")
+        range_hashes = [self.nodes[0].getblockhash(h) for h in range(204, 209)]
+        expected_blocks = b''.join(self.test_rest_request(f"/block/{h}", req_type=ReqType.BIN, ret_type=RetType.BYTES) for h in range_hashes)
+        assert_equal(self.test_rest_request(f"/blockrange/{range_hashes[0]}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 5}), expected_blocks)
+        # The range ends at the tip
+        assert_equal(self.test_rest_request(f"/blockrange/{range_hashes[0]}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 1000}), expected_blocks)
+        expected_headers = self.test_rest_request(f"/headers/{range_hashes[0]}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 5})
+        assert_equal(self.test_rest_request(f"/headerrange/{range_hashes[0]}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 100000}), expected_headers)
+        self.test_rest_request(f"/blockrange/{range_hashes[0]}", req_type=ReqType.JSON, ret_type=RetType.BYTES, status=404)
+        self.test_rest_request(f"/headerrange/{UNKNOWN_PARAM}", req_type=ReqType.BIN, ret_type=RetType.BYTES, status=404)
+        for num in ['0', '1001']:
+            assert_equal(
+                bytes(f'Count is invalid or out of acceptable range (1-1000): {num}\r\n', 'ascii'),
+                self.test_rest_request(f"/blockrange/{range_hashes[0]}", req_type=ReqType.BIN, ret_type=RetType.BYTES, status=400, query_params={"count": num}),
+            )
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 chained txs and mine them on node 1
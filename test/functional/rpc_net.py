@@ -124,6 +124,14 @@ class NetTest(BitcoinTestFramework):
                 "addr_relay_enabled": False,
                 "bip152_hb_from": False,
                 "bip152_hb_to": False,
+                "blockdownload": {
+                    "blocks": 0,
+                    "bytes": 0,
+                    "latency": 0,
+                    "rate": 0,
+                    "servicetime": 0,
+                    "window": 16,
+                },
                 "bytesrecv": 0,
                 "bytesrecv_per_msg": {},
                 "bytessent": 0,